@@ -0,0 +1,69 @@
+#pragma once
+
+// Replacement of the global C++ allocation functions, used when the contract is built with
+// SYSTEM_ARENA_ALLOCATOR and/or SYSTEM_INSTRUMENTED. A regular build keeps CDT's defaults.
+//
+// With SYSTEM_ARENA_ALLOCATOR, `operator new` bumps a pointer through a static arena of SYSTEM_ARENA_SIZE bytes
+// and `operator delete` is a no-op for arena memory. Every action (including each inline action and notification)
+// runs in a fresh WASM instance, so the arena starts empty for every action and never needs to be reset.
+// Allocations that do not fit in what is left of the arena fall back to `malloc`.
+//
+// This header defines the allocation functions, so it must only be included by one translation unit.
+
+#include <system/instrument.hpp>
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(SYSTEM_ARENA_ALLOCATOR) || defined(SYSTEM_INSTRUMENTED)
+
+namespace system_memory {
+#ifdef SYSTEM_ARENA_ALLOCATOR
+#ifndef SYSTEM_ARENA_SIZE
+#define SYSTEM_ARENA_SIZE 65536
+#endif
+   static constexpr size_t arena_align = 16;
+
+   alignas(arena_align) inline char arena[SYSTEM_ARENA_SIZE];
+   inline size_t arena_used = 0;
+
+   inline bool in_arena(const void* ptr) {
+      return static_cast<const char*>(ptr) >= arena && static_cast<const char*>(ptr) < arena + SYSTEM_ARENA_SIZE;
+   }
+
+   inline void* allocate(size_t size) {
+      const size_t aligned = (size + arena_align - 1) & ~(arena_align - 1);
+      if (aligned > SYSTEM_ARENA_SIZE - arena_used)
+         return malloc(size);
+      void* ptr = arena + arena_used;
+      arena_used += aligned;
+      return ptr;
+   }
+
+   inline void release(void* ptr) {
+      if (!in_arena(ptr))
+         free(ptr);
+   }
+#else
+   inline void* allocate(size_t size) { return malloc(size); }
+   inline void  release(void* ptr) { free(ptr); }
+#endif
+}
+
+void* operator new(size_t size) {
+   SYSTEM_COUNT_ALLOCATION();
+   return system_memory::allocate(size);
+}
+
+void* operator new[](size_t size) {
+   SYSTEM_COUNT_ALLOCATION();
+   return system_memory::allocate(size);
+}
+
+void operator delete(void* ptr) noexcept { system_memory::release(ptr); }
+void operator delete[](void* ptr) noexcept { system_memory::release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { system_memory::release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { system_memory::release(ptr); }
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <eosio/asset.hpp>
+#include <eosio/crypto.hpp>
+#include <eosio/datastream.hpp>
+#include <eosio/name.hpp>
+
+// Hashing of the balance commitment, a compact sparse Merkle tree over the XYZ balances (see `setcommit`).
+//
+// Each owner has a 64 bit key, the first 8 bytes of sha256(owner), read big-endian: its bits, most significant
+// first, are the path from the root. A subtree is hashed as
+//
+//    - zero (32 zero bytes) when it holds no balance,
+//    - `leaf_hash(owner, balance)` when it holds the balance of a single owner, whatever its depth,
+//    - `branch_hash(left, right)` otherwise.
+//
+// So an owner's leaf sits right below the deepest point its key shares with another key, about log2(holders)
+// levels down, and only that many nodes are stored and rehashed per balance change. Zero balances are not in
+// the tree. Leaves and branches hash 24 and 64 bytes respectively, so one can't be passed off as the other.
+
+namespace system_commitment {
+
+   static constexpr uint32_t max_depth = 64;
+
+   inline uint64_t key_of(eosio::name owner) {
+      const auto digest = eosio::sha256(reinterpret_cast<const char*>(&owner.value), sizeof(owner.value))
+                             .extract_as_byte_array();
+      uint64_t key = 0;
+      for (int i = 0; i < 8; ++i)
+         key = key << 8 | digest[i];
+      return key;
+   }
+
+   // The index, among the nodes of its depth, of the node at `depth` on the path of `key`.
+   inline uint64_t prefix_of(uint64_t key, uint32_t depth) { return depth == 0 ? 0 : key >> (max_depth - depth); }
+
+   // The depth below which two different keys are in different subtrees.
+   inline uint32_t split_depth(uint64_t a, uint64_t b) { return __builtin_clzll(a ^ b) + 1; }
+
+   inline eosio::checksum256 leaf_hash(eosio::name owner, const eosio::asset& balance) {
+      char                     buffer[sizeof(owner) + sizeof(balance)];
+      eosio::datastream<char*> ds(buffer, sizeof(buffer));
+      ds << owner << balance;
+      return eosio::sha256(buffer, sizeof(buffer));
+   }
+
+   inline eosio::checksum256 branch_hash(const eosio::checksum256& left, const eosio::checksum256& right) {
+      char                     buffer[64];
+      eosio::datastream<char*> ds(buffer, sizeof(buffer));
+      ds << left << right;
+      return eosio::sha256(buffer, sizeof(buffer));
+   }
+
+} // namespace system_commitment
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <eosio/action.hpp>
+#include <eosio/datastream.hpp>
+#include <eosio/name.hpp>
+
+#ifdef SYSTEM_WRAPPED_INLINE
+#include <tuple>
+#endif
+
+namespace system_inline {
+
+   /**
+    * An inline action with a single `actor@permission` authorization, serialized straight into a stack buffer
+    * and handed to `send_inline`.
+    *
+    * The receiver, action name and authorization are packed once on construction, `send` only appends the
+    * arguments. This sends the same bytes as `eosio::action_wrapper<...>(...).send(...)` without building an
+    * `eosio::action`, its authorization vector and its data vector on the heap.
+    *
+    * @tparam Capacity - size of the buffer, the packed action must fit in it
+    */
+#ifndef SYSTEM_WRAPPED_INLINE
+   template <uint32_t Capacity>
+   class packed_action {
+   public:
+      packed_action(eosio::name code, eosio::name act, eosio::name actor, eosio::name permission = "active"_n) {
+         eosio::datastream<char*> ds(_buffer, Capacity);
+         ds << code << act << eosio::unsigned_int(1) << actor << permission;
+         _header_size = ds.tellp();
+      }
+
+      template <typename... Args>
+      void send(const Args&... args) {
+         const size_t             data_size = (eosio::pack_size(args) + ... + 0);
+         eosio::datastream<char*> ds(_buffer + _header_size, Capacity - _header_size);
+         ds << eosio::unsigned_int(data_size);
+         (ds << ... << args);
+         eosio::internal_use_do_not_use::send_inline(_buffer, _header_size + ds.tellp());
+      }
+
+   private:
+      char     _buffer[Capacity];
+      uint32_t _header_size = 0;
+   };
+#else
+   /**
+    * The same interface over `eosio::action`, sending the way `action_wrapper` does. Only built into the
+    * `system_wrapped_inline` variant of the contract (see contracts/CMakeLists.txt), so that the benchmarks can
+    * measure what the pre-packed buffers save.
+    */
+   template <uint32_t Capacity>
+   class packed_action {
+   public:
+      packed_action(eosio::name code, eosio::name act, eosio::name actor, eosio::name permission = "active"_n)
+         : _code(code)
+         , _act(act)
+         , _authorization(actor, permission) {}
+
+      template <typename... Args>
+      void send(const Args&... args) {
+         eosio::action(_authorization, _code, _act, std::make_tuple(args...)).send();
+      }
+
+   private:
+      eosio::name             _code;
+      eosio::name             _act;
+      eosio::permission_level _authorization;
+   };
+#endif
+
+   // Room for a token transfer with a memo of up to 256 bytes.
+   static constexpr uint32_t transfer_capacity = 512;
+
+   // `code::transfer(from, to, quantity, memo)` authorized by `actor@active`.
+   inline void send_transfer(eosio::name code, eosio::name actor, eosio::name from, eosio::name to,
+                             const eosio::asset& quantity, const std::string& memo) {
+      packed_action<transfer_capacity>(code, "transfer"_n, actor).send(from, to, quantity, memo);
+   }
+
+} // namespace system_inline
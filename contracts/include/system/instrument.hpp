@@ -0,0 +1,33 @@
+#pragma once
+
+// Test-build instrumentation for the system contract.
+//
+// When compiled with SYSTEM_INSTRUMENTED (the `system_instrumented` target, see contracts/CMakeLists.txt)
+// every C++ heap allocation made by the contract is counted (see allocator.hpp), and each tracked scope prints
+// `allocs:<label>:<count>` to the action console when it is left. The unit tests read these lines back
+// from the action traces. In a regular build the macros expand to nothing.
+
+#ifdef SYSTEM_INSTRUMENTED
+
+#include <eosio/print.hpp>
+
+namespace system_instrument {
+   inline uint32_t allocations = 0;
+
+   struct alloc_report {
+      const char*    label;
+      const uint32_t start = allocations;
+
+      ~alloc_report() { eosio::print("allocs:", label, ":", allocations - start, "\n"); }
+   };
+}
+
+#define SYSTEM_COUNT_ALLOCATION() ++system_instrument::allocations
+#define SYSTEM_TRACK_ALLOCATIONS(label) system_instrument::alloc_report _alloc_report{label}
+
+#else
+
+#define SYSTEM_COUNT_ALLOCATION()
+#define SYSTEM_TRACK_ALLOCATIONS(label)
+
+#endif
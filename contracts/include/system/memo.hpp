@@ -0,0 +1,102 @@
+#pragma once
+
+#include <eosio/check.hpp>
+#include <eosio/name.hpp>
+
+#include <string_view>
+
+namespace system_memo {
+
+   // What a transfer to this contract asks for in its memo, see `parse_route`.
+   enum class route_kind : uint8_t {
+      none,    // the default: swap, and credit the sender
+      swapto,  // swap, and credit `account` instead of the sender
+      buyram,  // pay for RAM for `account` with the EOS
+      powerup, // pay for a powerup of `account` with the EOS, what is left is swapped to XYZ for the sender
+   };
+
+   struct route {
+      route_kind  kind = route_kind::none;
+      eosio::name account;
+      uint32_t    days     = 0; // powerup only
+      int64_t     net_frac = 0;
+      int64_t     cpu_frac = 0;
+   };
+
+   // Splits a memo into `:` separated fields, in place.
+   class fields {
+   public:
+      explicit fields(std::string_view memo)
+         : _rest(memo) {}
+
+      std::string_view next() {
+         eosio::check(!_done, "invalid memo route: missing field");
+         const size_t end   = _rest.find(':');
+         const auto   field = _rest.substr(0, end);
+         if (end == std::string_view::npos) {
+            _done = true;
+         } else {
+            _rest.remove_prefix(end + 1);
+         }
+         return field;
+      }
+
+      bool done() const { return _done; }
+
+   private:
+      std::string_view _rest;
+      bool             _done = false;
+   };
+
+   inline eosio::name parse_account(std::string_view field) {
+      eosio::check(!field.empty() && field.size() <= 12, "invalid memo route: bad account");
+      return eosio::name(field);
+   }
+
+   inline uint64_t parse_number(std::string_view field, uint64_t max) {
+      eosio::check(!field.empty(), "invalid memo route: bad number");
+      uint64_t value = 0;
+      for (const char c : field) {
+         eosio::check(c >= '0' && c <= '9' && value <= (max - (c - '0')) / 10, "invalid memo route: bad number");
+         value = value * 10 + (c - '0');
+      }
+      return value;
+   }
+
+   /**
+    * Reads the route of a transfer to this contract from its memo, without allocating:
+    *
+    *    swapto:<account>
+    *    buyram:<receiver>
+    *    powerup:<receiver>:<days>:<net_frac>:<cpu_frac>
+    *
+    * Memos that don't start with one of these commands, including empty ones, are not routes: the transfer
+    * is swapped for the sender as always. A memo that starts with a command but is malformed fails the transfer.
+    */
+   inline route parse_route(std::string_view memo) {
+      fields     f(memo);
+      const auto command = f.next();
+      route      r;
+      if (f.done()) {
+         return r;
+      } else if (command == "swapto") {
+         r.kind = route_kind::swapto;
+      } else if (command == "buyram") {
+         r.kind = route_kind::buyram;
+      } else if (command == "powerup") {
+         r.kind = route_kind::powerup;
+      } else {
+         return r;
+      }
+
+      r.account = parse_account(f.next());
+      if (r.kind == route_kind::powerup) {
+         r.days     = parse_number(f.next(), UINT32_MAX);
+         r.net_frac = parse_number(f.next(), INT64_MAX);
+         r.cpu_frac = parse_number(f.next(), INT64_MAX);
+      }
+      eosio::check(f.done(), "invalid memo route: too many fields");
+      return r;
+   }
+
+} // namespace system_memo
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <eosio/eosio.hpp>
+#include <eosio/datastream.hpp>
+
+#ifdef SYSTEM_MULTI_INDEX_STORAGE
+#include <eosio/multi_index.hpp>
+#include <memory>
+#include <type_traits>
+#endif
+
+namespace system_storage {
+
+   /**
+    * A single row of a table, accessed through the db intrinsics directly.
+    *
+    * The row is looked up and unpacked once on construction into a fixed size stack buffer, and every
+    * write goes straight to the database. Rows are serialized exactly like `eosio::multi_index` does, so a
+    * table can be read and written through either. There is no item cache and no secondary index support:
+    * only use this for tables that have no secondary indices.
+    *
+    * @tparam TableName  - name of the table
+    * @tparam T          - type of the row
+    * @tparam BufferSize - upper bound of the packed size of `T`
+    */
+#ifndef SYSTEM_MULTI_INDEX_STORAGE
+   template <eosio::name::raw TableName, typename T, uint32_t BufferSize = 64>
+   class row {
+   public:
+      row(eosio::name code, uint64_t scope, uint64_t primary_key)
+         : _scope(scope)
+         , _primary_key(primary_key) {
+         _itr = eosio::internal_use_do_not_use::db_find_i64(code.value, scope, static_cast<uint64_t>(TableName),
+                                                            primary_key);
+         if (_itr >= 0) {
+            char          buffer[BufferSize];
+            const int32_t size = eosio::internal_use_do_not_use::db_get_i64(_itr, buffer, BufferSize);
+            eosio::check(size <= int32_t(BufferSize), "row is larger than its storage buffer");
+            eosio::datastream<const char*> ds(buffer, size);
+            ds >> _value;
+         }
+      }
+
+      bool exists() const { return _itr >= 0; }
+
+      const T& get(const char* error_msg = "unable to find key") const {
+         eosio::check(exists(), error_msg);
+         return _value;
+      }
+
+      const T* operator->() const { return &_value; }
+
+      // Creates the row, which must not exist yet. Only valid for tables of the current receiver.
+      template <typename Lambda>
+      void emplace(eosio::name payer, Lambda&& constructor) {
+         eosio::check(!exists(), "row already exists");
+         _value = T{};
+         constructor(_value);
+         char buffer[BufferSize];
+         _itr = eosio::internal_use_do_not_use::db_store_i64(_scope, static_cast<uint64_t>(TableName), payer.value,
+                                                             _primary_key, buffer, serialize(buffer));
+      }
+
+      // Updates the row in place. An empty `payer` keeps the current RAM payer, like `eosio::same_payer`.
+      template <typename Lambda>
+      void modify(eosio::name payer, Lambda&& updater) {
+         eosio::check(exists(), "row does not exist");
+         updater(_value);
+         char buffer[BufferSize];
+         eosio::internal_use_do_not_use::db_update_i64(_itr, payer.value, buffer, serialize(buffer));
+      }
+
+      void erase() {
+         eosio::check(exists(), "row does not exist");
+         eosio::internal_use_do_not_use::db_remove_i64(_itr);
+         _itr = -1;
+      }
+
+   private:
+      uint32_t serialize(char* buffer) const {
+         const size_t size = eosio::pack_size(_value);
+         eosio::check(size <= BufferSize, "row is larger than its storage buffer");
+         eosio::datastream<char*> ds(buffer, size);
+         ds << _value;
+         return size;
+      }
+
+      uint64_t _scope;
+      uint64_t _primary_key;
+      int32_t  _itr = -1;
+      T        _value{};
+   };
+#else
+   /**
+    * The same interface over `eosio::multi_index`, the way the tables were read and written before `row` existed.
+    * Only built into the `system_multi_index` variant of the contract (see contracts/CMakeLists.txt), so that the
+    * benchmarks can measure what the direct access saves. Rows without a primary key are stored as
+    * `eosio::singleton` stores them.
+    */
+   template <eosio::name::raw TableName, typename T, uint32_t BufferSize = 64>
+   class row {
+      template <typename U, typename = void>
+      struct keyed : std::false_type {};
+      template <typename U>
+      struct keyed<U, std::void_t<decltype(std::declval<const U&>().primary_key())>> : std::true_type {};
+
+      struct singleton_row {
+         T        value;
+         uint64_t primary_key() const { return static_cast<uint64_t>(TableName); }
+         EOSLIB_SERIALIZE(singleton_row, (value))
+      };
+
+      using stored = std::conditional_t<keyed<T>::value, T, singleton_row>;
+      using table  = eosio::multi_index<TableName, stored>;
+
+      static T& value_of(stored& s) {
+         if constexpr (keyed<T>::value)
+            return s;
+         else
+            return s.value;
+      }
+      static const T& value_of(const stored& s) { return value_of(const_cast<stored&>(s)); }
+
+   public:
+      // The table is on the heap so that rows can be moved, its iterators point to it.
+      row(eosio::name code, uint64_t scope, uint64_t primary_key)
+         : _table(std::make_unique<table>(code, scope)) {
+         const auto itr = _table->find(primary_key);
+         if (itr != _table->end())
+            _item = &*itr;
+      }
+
+      bool exists() const { return _item != nullptr; }
+
+      const T& get(const char* error_msg = "unable to find key") const {
+         eosio::check(exists(), error_msg);
+         return value_of(*_item);
+      }
+
+      const T* operator->() const { return &value_of(*_item); }
+
+      template <typename Lambda>
+      void emplace(eosio::name payer, Lambda&& constructor) {
+         eosio::check(!exists(), "row already exists");
+         _item = &*_table->emplace(payer, [&](stored& s) {
+            value_of(s) = T{};
+            constructor(value_of(s));
+         });
+      }
+
+      template <typename Lambda>
+      void modify(eosio::name payer, Lambda&& updater) {
+         eosio::check(exists(), "row does not exist");
+         _table->modify(*_item, payer, [&](stored& s) { updater(value_of(s)); });
+      }
+
+      void erase() {
+         eosio::check(exists(), "row does not exist");
+         _table->erase(*_item);
+         _item = nullptr;
+      }
+
+   private:
+      std::unique_ptr<table> _table;
+      const stored*          _item = nullptr;
+   };
+#endif
+
+} // namespace system_storage
@@ -4,6 +4,9 @@
 #include <eosio/singleton.hpp>
 #include <eosio/binary_extension.hpp>
 
+#include <system/storage.hpp>
+#include <system/memo.hpp>
+
 namespace system_origin {
 struct authority;
 };
@@ -33,11 +36,104 @@ public:
    typedef eosio::multi_index< "stat"_n, currency_stats > stats;
 
    struct [[eosio::table]] config {
-      symbol token_symbol;
+      symbol                           token_symbol;
+      eosio::binary_extension<uint8_t> swap_audit;
+      eosio::binary_extension<bool>    implicit_reserve;
+      eosio::binary_extension<bool>    commitment; // `commitment_state::enabled`, read with the config
+      eosio::binary_extension<bool>    registry;   // `registry_state::enabled`, read with the config
    };
 
    typedef eosio::singleton<"config"_n, config> config_table;
 
+   // Direct access to single rows of the tables above, see storage.hpp. Same on-disk format.
+   using account_row = system_storage::row<"accounts"_n, account>;
+   using stat_row    = system_storage::row<"stat"_n, currency_stats>;
+   using config_row  = system_storage::row<"config"_n, config>;
+
+   // Aggregate swap counters, kept up to date by every swap once seeded (see `init` and `syncsolvency`),
+   // so that solvency can be checked with a single read instead of scanning every `accounts` scope.
+   struct [[eosio::table("solvency"), eosio::contract("system")]] solvency_stats {
+      asset circulating; // XYZ held outside the reserve
+      asset eos_held;    // EOS held by this contract to back it
+      asset swapped_in;  // cumulative EOS swapped to XYZ
+      asset swapped_out; // cumulative XYZ swapped to EOS
+   };
+
+   typedef eosio::singleton<"solvency"_n, solvency_stats> solvency_table;
+   using solvency_row = system_storage::row<"solvency"_n, solvency_stats>;
+
+   // Optional commitment to every XYZ balance, so that light clients can check a balance against a single hash
+   // instead of trusting an API node. See system/commitment.hpp for the tree and `proofs` for the proofs.
+   struct [[eosio::table("commitment"), eosio::contract("system")]] commitment_state {
+      bool               enabled = false;
+      eosio::checksum256 root;       // zero when no balance is committed
+      uint64_t           leaves = 0; // owners with a committed balance
+   };
+
+   typedef eosio::singleton<"commitment"_n, commitment_state> commitment_table;
+   using commitment_row = system_storage::row<"commitment"_n, commitment_state>;
+
+   // The top of a non-empty subtree of the commitment, scoped by its depth. A leaf when `owner` is set,
+   // otherwise a branch whose hash covers two children.
+   struct [[eosio::table("commitnodes"), eosio::contract("system")]] commitment_node {
+      uint64_t           prefix; // index of the node among those of its depth, see `system_commitment::prefix_of`
+      eosio::checksum256 hash;
+      name               owner;
+      asset              balance;
+
+      uint64_t primary_key() const { return prefix; }
+   };
+
+   typedef eosio::multi_index<"commitnodes"_n, commitment_node> commitment_nodes;
+   using commitment_node_row = system_storage::row<"commitnodes"_n, commitment_node>;
+
+   // The path from the root to the subtree of the commitment where `owner`'s key leads.
+   struct balance_proof {
+      name                            owner;
+      name                            leaf;     // the owner of the leaf found there: `owner`, another account, or none
+      asset                           balance;  // committed balance of `leaf`
+      uint8_t                         depth;    // depth of that leaf, or of the empty subtree
+      uint64_t                        present;  // bit `d` is set when the sibling at depth `d + 1` is not empty
+      std::vector<eosio::checksum256> siblings; // the siblings that are not empty, from the root down
+   };
+
+   struct commitment_proofs {
+      eosio::checksum256         root;
+      uint64_t                   leaves;
+      std::vector<balance_proof> proofs;
+   };
+
+   // Optional index of the `accounts` rows, see `setregistry`. WASM can't enumerate the scopes of `accounts`,
+   // so this is what `holders` and `topholders` read instead of a node-wide scan.
+   struct [[eosio::table("registry"), eosio::contract("system")]] registry_state {
+      bool     enabled = false;
+      uint64_t holders = 0; // rows in `holders`
+   };
+
+   typedef eosio::singleton<"registry"_n, registry_state> registry_table;
+   using registry_row = system_storage::row<"registry"_n, registry_state>;
+
+   struct [[eosio::table("holders"), eosio::contract("system")]] holder {
+      name  owner;
+      asset balance;
+
+      uint64_t primary_key() const { return owner.value; }
+      uint64_t by_balance() const { return ~uint64_t(balance.amount); } // largest balances first
+   };
+
+   typedef eosio::multi_index<
+      "holders"_n, holder,
+      eosio::indexed_by<"bybalance"_n, eosio::const_mem_fun<holder, uint64_t, &holder::by_balance>>>
+      holders_table;
+
+   // Largest page `holders` and `topholders` return, so that a query stays well within the read-only time limit.
+   static constexpr uint32_t max_holders_page = 1000;
+
+   struct holders_page {
+      std::vector<holder> holders;
+      name                next; // cursor of the next page, none after the last page
+   };
+
    // allow account owners to disallow the `swapto` action with their account as destination.
    // This has been requested by exchanges who prefer to receive funds into their hot wallets
    // exclusively via the root `transfer` action.
@@ -48,6 +144,48 @@ public:
    };
 
    typedef eosio::multi_index<"blocked"_n, blocked_recipient> blocked_table;
+   using blocked_row = system_storage::row<"blocked"_n, blocked_recipient>;
+
+   // How the swaps done by the forwarding actions are surfaced to indexers.
+   // `audit_full` sends a `swaptrace` inline action per swap (the original behaviour),
+   // `audit_compact` sets a packed `swap_receipt` as the forwarding action's return value instead,
+   // and `audit_none` emits no marker at all, leaving only the token transfers in the trace.
+   enum swap_audit_mode : uint8_t {
+      audit_full    = 0,
+      audit_compact = 1,
+      audit_none    = 2,
+   };
+
+   struct swap_receipt {
+      name  account;
+      asset quantity;
+   };
+
+   // What `provision` does for a receiver.
+   enum provision_kind : uint8_t {
+      provision_ram     = 0, // `buyram` for `quantity`
+      provision_stake   = 1, // `delegatebw` of `quantity` to NET and `cpu_quantity` to CPU
+      provision_powerup = 2, // `powerup` for `days`, `net_frac` and `cpu_frac`, paying at most `quantity`
+   };
+
+   struct provision_request {
+      name     receiver;
+      uint8_t  kind;         // one of `provision_kind`
+      asset    quantity;     // XYZ
+      asset    cpu_quantity; // XYZ, stake only
+      uint32_t days     = 0; // powerup only
+      int64_t  net_frac = 0;
+      int64_t  cpu_frac = 0;
+   };
+
+   // An account created by `newaccounts`, with `key` as its owner and active key.
+   struct new_account {
+      name              account;
+      eosio::public_key key;
+      uint32_t          ram_bytes; // RAM bought for the account, none when zero
+      asset             net;       // XYZ staked to the account's NET, by the creator
+      asset             cpu;       // XYZ staked to the account's CPU, by the creator
+   };
 
    /**
     * Initialize the token with a maximum supply and given token ticker and store a ref to which ticker is selected.
@@ -57,6 +195,85 @@ public:
     */
    [[eosio::action]] void init(asset maximum_supply);
 
+   /**
+    * Select how swaps done by the forwarding actions are marked in traces.
+    * @param mode - One of `swap_audit_mode`, defaults to `audit_full` until set.
+    */
+   [[eosio::action]] void setaudit(uint8_t mode);
+
+   /**
+    * Switch between an explicit reserve, where the unswapped XYZ is held in this contract's own balance row,
+    * and an implicit reserve, where that row is left untouched and the reserve is derived from the solvency
+    * counters, which must be seeded. Swaps then only write the user's balance row.
+    * Switching back to explicit writes the derived reserve into the contract's balance row.
+    * @param implicit - true for an implicit reserve, the default is explicit.
+    */
+   [[eosio::action]] void setreserve(bool implicit);
+
+   /**
+    * Reseed the solvency counters from the current state: circulating XYZ is the supply less the reserve,
+    * and the EOS held is this contract's `eosio.token` balance. The cumulative swap volumes are kept, and so is
+    * circulating XYZ while the reserve is implicit, since the reserve is then derived from it.
+    * Needed once on deployments initialized before the counters existed, or to absorb EOS received outside of swaps.
+    */
+   [[eosio::action]] void syncsolvency();
+
+   /**
+    * Read-only: the solvency counters, see `solvency_stats`.
+    */
+   [[eosio::action, eosio::read_only]] solvency_stats solvency();
+
+   /**
+    * Turn the balance commitment on or off. While on, every balance change updates the commitment in the same
+    * action, at the cost of about 3 * log2(holders) row lookups and log2(holders) hashes and row writes.
+    * While off, balance changes only check the flag this mirrors into `config`.
+    * Balances that predate the commitment, or changed while it was off, are added with `commitacct`.
+    * @param enabled - true to maintain the commitment.
+    */
+   [[eosio::action]] void setcommit(bool enabled);
+
+   /**
+    * Commit the current balances of the given accounts, e.g. to backfill the holders that existed before the
+    * commitment was enabled. Anyone can call it, it only ever writes balances as they are.
+    * @param owners - accounts whose balance is committed.
+    */
+   [[eosio::action]] void commitacct(const std::vector<name>& owners);
+
+   /**
+    * Read-only: the commitment's root and a proof of the committed balance of each of `owners`, or of its
+    * absence. See README.md for how to check them.
+    */
+   [[eosio::action, eosio::read_only]] commitment_proofs proofs(const std::vector<name>& owners);
+
+   /**
+    * Turn the holder registry on or off. While on, every change to an `accounts` row is mirrored into `holders`
+    * in the same action, at the cost of one more row update and one secondary index update.
+    * While off, balance changes only check the flag this mirrors into `config`.
+    * Rows that predate the registry, or changed while it was off, are added with `registeracct`.
+    * @param enabled - true to maintain the registry.
+    */
+   [[eosio::action]] void setregistry(bool enabled);
+
+   /**
+    * Register the current balance rows of the given accounts, e.g. to backfill the holders that existed before
+    * the registry was enabled. Anyone can call it, it only ever writes rows as they are.
+    * @param owners - accounts whose row is registered, or unregistered when they have none.
+    */
+   [[eosio::action]] void registeracct(const std::vector<name>& owners);
+
+   /**
+    * Read-only: the registered holders in account name order, from `cursor` on.
+    * @param cursor - first account of the page, none for the first page, `next` of the previous page otherwise.
+    * @param limit  - number of holders, at most `max_holders_page`.
+    */
+   [[eosio::action, eosio::read_only]] holders_page holders(const name& cursor, uint32_t limit);
+
+   /**
+    * Read-only: the `limit` registered holders with the largest balances, largest first.
+    * @param limit - number of holders, at most `max_holders_page`.
+    */
+   [[eosio::action, eosio::read_only]] std::vector<holder> topholders(uint32_t limit);
+
    // ----------------------------------------------------
    // SYSTEM TOKEN ---------------------------------------
    // ----------------------------------------------------
@@ -67,7 +284,8 @@ public:
    // ----------------------------------------------------
    // SWAP -----------------------------------------------
    // ----------------------------------------------------
-   // When this contract receives EOS tokens, it will swap them for XYZ tokens and credit them to the sender.
+   // When this contract receives EOS tokens, it will swap them for XYZ tokens and credit them to the sender,
+   // unless the memo routes them elsewhere, see system/memo.hpp.
    [[eosio::on_notify("eosio.token::transfer")]]
    void on_transfer(const name& from, const name& to, const asset& quantity, const std::string& memo);
 
@@ -78,6 +296,7 @@ public:
    [[eosio::action]] void enforcebal(const name& account, const asset& expected_eos_balance);
    [[eosio::action]] void swapexcess(const name& account, const asset& eos_before);
    [[eosio::action]] void swaptrace(const name& account, const asset& quantity);
+   [[eosio::action]] void creditexcess(const name& account, const asset& eos_held);
 
    // ----------------------------------------------------
    // SYSTEM ACTIONS -------------------------------------
@@ -105,8 +324,13 @@ public:
    [[eosio::action]] void newaccount(const name& creator, const name& name,
                                      const system_origin::authority& owner, const system_origin::authority& active);
    [[eosio::action]] void newaccount2(const name& creator, const name& name, eosio::public_key key);
+   // Creates and provisions a batch of accounts, with a single swap for all of their RAM and stake.
+   [[eosio::action]] void newaccounts(const name& creator, const std::vector<new_account>& accounts);
    [[eosio::action]] void powerup(const name& payer, const name& receiver, uint32_t days, int64_t net_frac,
                                   int64_t cpu_frac, const asset& max_payment);
+   // Provisions many receivers with a single swap in and, when there are powerups, a single sweep of what they
+   // did not spend back to XYZ.
+   [[eosio::action]] void provision(const name& payer, const std::vector<provision_request>& requests);
    [[eosio::action]] void delegatebw(const name& from, const name& receiver, const asset& stake_net_quantity,
                                      const asset& stake_cpu_quantity, const bool& transfer);
    [[eosio::action]] void undelegatebw(const name& from, const name& receiver, const asset& unstake_net_quantity,
@@ -147,31 +371,45 @@ public:
    using buyrex_action       = eosio::action_wrapper<"buyrex"_n, &system_contract::buyrex>;
    using claimrewards_action = eosio::action_wrapper<"claimrewards"_n, &system_contract::claimrewards>;
    using close_action        = eosio::action_wrapper<"close"_n, &system_contract::close>;
+   using commitacct_action   = eosio::action_wrapper<"commitacct"_n, &system_contract::commitacct>;
+   using creditexcess_action = eosio::action_wrapper<"creditexcess"_n, &system_contract::creditexcess>;
    using delegatebw_action   = eosio::action_wrapper<"delegatebw"_n, &system_contract::delegatebw>;
    using deleteauth_action   = eosio::action_wrapper<"deleteauth"_n, &system_contract::deleteauth>;
    using deposit_action      = eosio::action_wrapper<"deposit"_n, &system_contract::deposit>;
    using donatetorex_action  = eosio::action_wrapper<"donatetorex"_n, &system_contract::donatetorex>;
    using enforcebal_action   = eosio::action_wrapper<"enforcebal"_n, &system_contract::enforcebal>;
    using giftram_action      = eosio::action_wrapper<"giftram"_n, &system_contract::giftram>;
+   using holders_action      = eosio::action_wrapper<"holders"_n, &system_contract::holders>;
    using init_action         = eosio::action_wrapper<"init"_n, &system_contract::init>;
    using linkauth_action     = eosio::action_wrapper<"linkauth"_n, &system_contract::linkauth>;
    using mvfrsavings_action  = eosio::action_wrapper<"mvfrsavings"_n, &system_contract::mvfrsavings>;
    using mvtosavings_action  = eosio::action_wrapper<"mvtosavings"_n, &system_contract::mvtosavings>;
    using newaccount2_action  = eosio::action_wrapper<"newaccount2"_n, &system_contract::newaccount2>;
    using newaccount_action   = eosio::action_wrapper<"newaccount"_n, &system_contract::newaccount>;
+   using newaccounts_action  = eosio::action_wrapper<"newaccounts"_n, &system_contract::newaccounts>;
    using noop_action         = eosio::action_wrapper<"noop"_n, &system_contract::noop>;
    using open_action         = eosio::action_wrapper<"open"_n, &system_contract::open>;
    using powerup_action      = eosio::action_wrapper<"powerup"_n, &system_contract::powerup>;
+   using proofs_action       = eosio::action_wrapper<"proofs"_n, &system_contract::proofs>;
+   using provision_action    = eosio::action_wrapper<"provision"_n, &system_contract::provision>;
    using ramburn_action      = eosio::action_wrapper<"ramburn"_n, &system_contract::ramburn>;
    using ramtransfer_action  = eosio::action_wrapper<"ramtransfer"_n, &system_contract::ramtransfer>;
    using refund_action       = eosio::action_wrapper<"refund"_n, &system_contract::refund>;
+   using registeracct_action = eosio::action_wrapper<"registeracct"_n, &system_contract::registeracct>;
    using sellram_action      = eosio::action_wrapper<"sellram"_n, &system_contract::sellram>;
    using sellrex_action      = eosio::action_wrapper<"sellrex"_n, &system_contract::sellrex>;
    using setabi_action       = eosio::action_wrapper<"setabi"_n, &system_contract::setabi>;
+   using setaudit_action     = eosio::action_wrapper<"setaudit"_n, &system_contract::setaudit>;
    using setcode_action      = eosio::action_wrapper<"setcode"_n, &system_contract::setcode>;
+   using setcommit_action    = eosio::action_wrapper<"setcommit"_n, &system_contract::setcommit>;
+   using setregistry_action  = eosio::action_wrapper<"setregistry"_n, &system_contract::setregistry>;
+   using setreserve_action   = eosio::action_wrapper<"setreserve"_n, &system_contract::setreserve>;
+   using solvency_action     = eosio::action_wrapper<"solvency"_n, &system_contract::solvency>;
    using swapexcess_action   = eosio::action_wrapper<"swapexcess"_n, &system_contract::swapexcess>;
    using swapto_action       = eosio::action_wrapper<"swapto"_n, &system_contract::swapto>;
    using swaptrace_action    = eosio::action_wrapper<"swaptrace"_n, &system_contract::swaptrace>;
+   using syncsolvency_action = eosio::action_wrapper<"syncsolvency"_n, &system_contract::syncsolvency>;
+   using topholders_action   = eosio::action_wrapper<"topholders"_n, &system_contract::topholders>;
    using transfer_action     = eosio::action_wrapper<"transfer"_n, &system_contract::transfer>;
    using undelegatebw_action = eosio::action_wrapper<"undelegatebw"_n, &system_contract::undelegatebw>;
    using ungiftram_action    = eosio::action_wrapper<"ungiftram"_n, &system_contract::ungiftram>;
@@ -183,11 +421,22 @@ public:
    using withdraw_action     = eosio::action_wrapper<"withdraw"_n, &system_contract::withdraw>;
 
 private:
-   void   add_balance(const name& owner, const asset& value, const name& ram_payer);
-   void   sub_balance(const name& owner, const asset& value);
+   void   add_balance(const config& cfg, const name& owner, const asset& value, const name& ram_payer);
+   void   sub_balance(const config& cfg, const name& owner, const asset& value);
+   void   commit_balance(const config& cfg, const name& owner, const asset& balance);
+   void   commit(commitment_row& commitment, const name& owner, const asset& balance);
+   void   register_balance(const config& cfg, const name& owner, const std::optional<asset>& balance);
+   void   index_holder(registry_row& registry, const name& owner, const std::optional<asset>& balance);
+   config get_config();
+   void   set_config(config cfg);
+   asset  get_implicit_reserve(const asset& supply);
    symbol get_token_symbol();
    void   enforce_symbol(const asset& quantity);
+   void   enforce_not_blocked(const name& recipient);
    void   credit_eos_to(const name& account, const asset& quantity);
+   void   credit_xyz_to(const name& account, const asset& quantity);
+   void   forward_route(const name& account, const system_memo::route& route, const asset& eos_quantity);
+   void   record_swap(const asset& quantity, bool to_xyz);
    void   swap_before_forwarding(const name& account, const asset& quantity);
    void   swap_after_forwarding(const name& account, const asset& quantity);
    asset  get_eos_balance(const name& account);
@@ -3,6 +3,8 @@
 #include <eosio/asset.hpp>
 #include <eosio/eosio.hpp>
 
+#include <system/storage.hpp>
+
 #include <string>
 
 namespace eosio_token {
@@ -15,4 +17,5 @@ namespace eosio_token {
         uint64_t primary_key()const { return balance.symbol.code().raw(); }
     };
     typedef eosio::multi_index< "accounts"_n, account > accounts;
+    using account_row = system_storage::row< "accounts"_n, account >;
 }
\ No newline at end of file
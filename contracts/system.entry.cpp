@@ -2,10 +2,17 @@
 
 #include <system/token.hpp>
 #include <system/oldsystem.hpp>
+#include <system/allocator.hpp>
+#include <system/inline_action.hpp>
+#include <system/instrument.hpp>
+#include <system/commitment.hpp>
 
 using namespace eosio;
 using namespace system_origin;
 
+// Shared by every inline transfer that carries no memo, so the hot paths don't build one per call.
+static const std::string empty_memo;
+
 /**
  * Initialize the token with a maximum supply and given token ticker and store a ref to which ticker is selected.
  * This also issues the maximum supply to the system contract itself so that it can use it for
@@ -21,16 +28,228 @@ void system_contract::init(asset maximum_supply) {
    check(maximum_supply.is_valid(), "invalid supply");
    check(maximum_supply.amount > 0, "max-supply must be positive");
 
-   _config.set(config{.token_symbol = sym}, get_self());
+   const config cfg{.token_symbol = sym};
+   _config.set(cfg, get_self());
 
-   stats statstable(get_self(), sym.code().raw());
-   statstable.emplace(get_self(), [&](auto& s) {
+   stat_row st(get_self(), sym.code().raw(), sym.code().raw());
+   st.emplace(get_self(), [&](auto& s) {
       s.supply     = maximum_supply;
       s.max_supply = maximum_supply;
       s.issuer     = get_self();
    });
 
-   add_balance(get_self(), maximum_supply, get_self());
+   add_balance(cfg, get_self(), maximum_supply, get_self());
+
+   // nothing circulates yet
+   solvency_row counters(get_self(), get_self().value, "solvency"_n.value);
+   counters.emplace(get_self(), [&](auto& s) {
+      s.circulating = asset(0, sym);
+      s.eos_held    = get_eos_balance(get_self());
+      s.swapped_in  = asset(0, EOS);
+      s.swapped_out = asset(0, sym);
+   });
+}
+
+// Selects how the forwarding actions mark the swaps they perform, see `swap_audit_mode`.
+void system_contract::setaudit(uint8_t mode) {
+   require_auth(get_self());
+   check(mode <= audit_none, "invalid swap audit mode");
+
+   config cfg = get_config();
+   cfg.swap_audit.emplace(mode);
+   set_config(cfg);
+}
+
+// Selects where the XYZ reserve used for swaps is kept, see `get_implicit_reserve`.
+void system_contract::setreserve(bool implicit) {
+   require_auth(get_self());
+
+   config cfg = get_config();
+   check(implicit != cfg.implicit_reserve.value_or(false),
+         implicit ? "reserve is already implicit" : "reserve is already explicit");
+
+   const auto     sym = cfg.token_symbol.code().raw();
+   const stat_row stat(get_self(), sym, sym);
+   account_row    reserve(get_self(), get_self().value, sym);
+   if (implicit) {
+      // The solvency counters take over from the reserve row, so they must agree with it.
+      check(get_implicit_reserve(stat.get().supply) == reserve.get("no balance object found").balance,
+            "solvency counters disagree with the reserve, see syncsolvency");
+   } else {
+      const asset derived = get_implicit_reserve(stat.get().supply);
+      check(derived.amount >= 0, "implicit reserve is overdrawn");
+      reserve.modify(same_payer, [&](auto& a) { a.balance = derived; });
+      commit_balance(cfg, get_self(), derived);
+      register_balance(cfg, get_self(), derived);
+   }
+
+   cfg.implicit_reserve.emplace(implicit);
+   set_config(cfg);
+}
+
+void system_contract::syncsolvency() {
+   require_auth(get_self());
+
+   const config   cfg = get_config();
+   const auto     sym = cfg.token_symbol.code().raw();
+   const stat_row stat(get_self(), sym, sym);
+
+   // While the reserve is implicit it is derived from `circulating`, which only swaps may move.
+   const bool implicit = cfg.implicit_reserve.value_or(false);
+
+   solvency_row counters(get_self(), get_self().value, "solvency"_n.value);
+   auto update = [&](auto& s) {
+      if (!implicit) {
+         const account_row reserve(get_self(), get_self().value, sym);
+         s.circulating = stat.get().supply - reserve.get("no balance object found").balance;
+      }
+      s.eos_held = get_eos_balance(get_self());
+   };
+   if (counters.exists()) {
+      counters.modify(same_payer, update);
+   } else {
+      counters.emplace(get_self(), [&](auto& s) {
+         s.swapped_in  = asset(0, EOS);
+         s.swapped_out = asset(0, cfg.token_symbol);
+         update(s);
+      });
+   }
+}
+
+system_contract::solvency_stats system_contract::solvency() {
+   const solvency_row counters(get_self(), get_self().value, "solvency"_n.value);
+   return counters.get("solvency counters are not seeded, see syncsolvency");
+}
+
+// Turns the balance commitment on or off, see `commit`.
+void system_contract::setcommit(bool enabled) {
+   require_auth(get_self());
+
+   commitment_row commitment(get_self(), get_self().value, "commitment"_n.value);
+   check(enabled != (commitment.exists() && commitment->enabled),
+         enabled ? "commitment is already enabled" : "commitment is already disabled");
+
+   // Turning it off keeps the tree, turning it back on resumes from there.
+   if (commitment.exists()) {
+      commitment.modify(same_payer, [&](auto& c) { c.enabled = enabled; });
+   } else {
+      commitment.emplace(get_self(), [&](auto& c) { c.enabled = true; });
+   }
+
+   // what balance changes check, so that they don't read the commitment while it is off
+   config cfg = get_config();
+   cfg.commitment.emplace(enabled);
+   set_config(cfg);
+}
+
+void system_contract::commitacct(const std::vector<name>& owners) {
+   commitment_row commitment(get_self(), get_self().value, "commitment"_n.value);
+   check(commitment.exists() && commitment->enabled, "commitment is not enabled");
+
+   const symbol sym = get_token_symbol();
+   for (const name& owner : owners) {
+      const account_row acnt(get_self(), owner.value, sym.code().raw());
+      commit(commitment, owner, acnt.exists() ? acnt->balance : asset(0, sym));
+   }
+}
+
+system_contract::commitment_proofs system_contract::proofs(const std::vector<name>& owners) {
+   using namespace system_commitment;
+
+   const commitment_row commitment(get_self(), get_self().value, "commitment"_n.value);
+   check(commitment.exists() && commitment->enabled, "commitment is not enabled");
+
+   const symbol      sym = get_token_symbol();
+   commitment_proofs result{.root = commitment->root, .leaves = commitment->leaves};
+   result.proofs.reserve(owners.size());
+   for (const name& owner : owners) {
+      const uint64_t key = key_of(owner);
+      balance_proof  proof{.owner = owner, .balance = asset(0, sym), .depth = 0, .present = 0};
+
+      // down the branches on the key's path, collecting the siblings
+      commitment_node_row node(get_self(), 0, 0);
+      while (node.exists() && node->owner == name()) {
+         ++proof.depth;
+         const uint64_t            child = prefix_of(key, proof.depth);
+         const commitment_node_row sibling(get_self(), proof.depth, child ^ 1);
+         if (sibling.exists()) {
+            proof.present |= uint64_t(1) << (proof.depth - 1);
+            proof.siblings.push_back(sibling->hash);
+         }
+         node = commitment_node_row(get_self(), proof.depth, child);
+      }
+      if (node.exists()) {
+         proof.leaf    = node->owner;
+         proof.balance = node->balance;
+      }
+      result.proofs.push_back(std::move(proof));
+   }
+   return result;
+}
+
+// Turns the holder registry on or off, see `index_holder`.
+void system_contract::setregistry(bool enabled) {
+   require_auth(get_self());
+
+   registry_row registry(get_self(), get_self().value, "registry"_n.value);
+   check(enabled != (registry.exists() && registry->enabled),
+         enabled ? "registry is already enabled" : "registry is already disabled");
+
+   // Turning it off keeps the rows, turning it back on resumes from there.
+   if (registry.exists()) {
+      registry.modify(same_payer, [&](auto& r) { r.enabled = enabled; });
+   } else {
+      registry.emplace(get_self(), [&](auto& r) { r.enabled = true; });
+   }
+
+   // what balance changes check, so that they don't read the registry while it is off
+   config cfg = get_config();
+   cfg.registry.emplace(enabled);
+   set_config(cfg);
+}
+
+void system_contract::registeracct(const std::vector<name>& owners) {
+   registry_row registry(get_self(), get_self().value, "registry"_n.value);
+   check(registry.exists() && registry->enabled, "registry is not enabled");
+
+   const symbol sym = get_token_symbol();
+   for (const name& owner : owners) {
+      const account_row acnt(get_self(), owner.value, sym.code().raw());
+      index_holder(registry, owner, acnt.exists() ? std::optional<asset>(acnt->balance) : std::nullopt);
+   }
+}
+
+system_contract::holders_page system_contract::holders(const name& cursor, uint32_t limit) {
+   const registry_row registry(get_self(), get_self().value, "registry"_n.value);
+   check(registry.exists() && registry->enabled, "registry is not enabled");
+   check(limit > 0 && limit <= max_holders_page, "invalid page size");
+
+   holders_table table(get_self(), get_self().value);
+   holders_page  page;
+   page.holders.reserve(std::min<uint64_t>(limit, registry->holders));
+   auto itr = table.lower_bound(cursor.value);
+   for (; itr != table.end() && page.holders.size() < limit; ++itr) {
+      page.holders.push_back(*itr);
+   }
+   if (itr != table.end()) {
+      page.next = itr->owner;
+   }
+   return page;
+}
+
+std::vector<system_contract::holder> system_contract::topholders(uint32_t limit) {
+   const registry_row registry(get_self(), get_self().value, "registry"_n.value);
+   check(registry.exists() && registry->enabled, "registry is not enabled");
+   check(limit > 0 && limit <= max_holders_page, "invalid page size");
+
+   holders_table       table(get_self(), get_self().value);
+   auto                by_balance = table.get_index<"bybalance"_n>();
+   std::vector<holder> top;
+   top.reserve(std::min<uint64_t>(limit, registry->holders));
+   for (auto itr = by_balance.begin(); itr != by_balance.end() && top.size() < limit; ++itr) {
+      top.push_back(*itr);
+   }
+   return top;
 }
 
 
@@ -39,13 +258,14 @@ void system_contract::init(asset maximum_supply) {
 // ----------------------------------------------------
 
 void system_contract::transfer(const name& from, const name& to, const asset& quantity, const std::string& memo) {
+   SYSTEM_TRACK_ALLOCATIONS("transfer");
    check(from != to, "cannot transfer to self");
    require_auth(from);
    check(is_account(to), "to account does not exist");
 
-   auto        sym = quantity.symbol.code();
-   stats       statstable(get_self(), sym.raw());
-   const auto& st = statstable.get(sym.raw());
+   auto           sym = quantity.symbol.code();
+   const stat_row stat(get_self(), sym.raw(), sym.raw());
+   const auto&    st = stat.get();
 
    check(quantity.is_valid(), "invalid quantity");
    check(quantity.amount > 0, "must transfer positive quantity");
@@ -54,8 +274,20 @@ void system_contract::transfer(const name& from, const name& to, const asset& qu
 
    auto payer = has_auth(to) ? to : from;
 
-   sub_balance(from, quantity);
-   add_balance(to, quantity, payer);
+   // With an implicit reserve the contract's own balance row is not written by swaps.
+   const config cfg      = get_config();
+   const bool   implicit = (from == get_self() || to == get_self()) && cfg.implicit_reserve.value_or(false);
+
+   if (implicit && from == get_self()) {
+      // Only the swaps of `on_transfer` and `creditexcess` may draw from the reserve.
+      check(get_sender() == get_self(), "the implicit reserve can only be spent by swaps");
+      check(get_implicit_reserve(st.supply).amount >= 0, "overdrawn balance");
+   } else {
+      sub_balance(cfg, from, quantity);
+   }
+   if (!(implicit && to == get_self())) {
+      add_balance(cfg, to, quantity, payer);
+   }
 
    require_recipient(from);
    require_recipient(to);
@@ -63,8 +295,24 @@ void system_contract::transfer(const name& from, const name& to, const asset& qu
    // If `from` is sending XYZ tokens to this contract
    // they are swapping from XYZ to EOS
    if (to == get_self()) {
-      check(quantity.symbol == get_token_symbol(), "Wrong token used");
-      credit_eos_to(from, quantity);
+      check(quantity.symbol == cfg.token_symbol, "Wrong token used");
+
+      // The swaps this contract sends itself, e.g. for `swapto`, carry the user's memo but are never routed.
+      const auto route = get_sender() == get_self() ? system_memo::route{} : system_memo::parse_route(memo);
+      switch (route.kind) {
+         case system_memo::route_kind::none:
+            credit_eos_to(from, quantity);
+            break;
+         case system_memo::route_kind::swapto:
+            enforce_not_blocked(route.account);
+            credit_eos_to(route.account, quantity);
+            break;
+         default:
+            // swapped, and the EOS stays here to pay for the routed action
+            record_swap(quantity, false);
+            forward_route(from, route, asset(quantity.amount, EOS));
+            break;
+      }
    }
 }
 
@@ -73,62 +321,64 @@ void system_contract::open(const name& owner, const symbol& symbol, const name&
 
    check(is_account(owner), "owner account does not exist");
 
-   auto        sym_code_raw = symbol.code().raw();
-   stats       statstable(get_self(), sym_code_raw);
-   const auto& st = statstable.get(sym_code_raw, "symbol does not exist");
-   check(st.supply.symbol == symbol, "symbol precision mismatch");
+   auto           sym_code_raw = symbol.code().raw();
+   const stat_row st(get_self(), sym_code_raw, sym_code_raw);
+   check(st.get("symbol does not exist").supply.symbol == symbol, "symbol precision mismatch");
 
-   accounts acnts(get_self(), owner.value);
-   auto     it = acnts.find(sym_code_raw);
-   if (it == acnts.end()) {
-      acnts.emplace(ram_payer, [&](auto& a) {
+   account_row acnt(get_self(), owner.value, sym_code_raw);
+   if (!acnt.exists()) {
+      acnt.emplace(ram_payer, [&](auto& a) {
          a.balance = asset{0, symbol};
          a.released = ram_payer == owner;
       });
+      register_balance(get_config(), owner, acnt->balance);
    }
 }
 
 void system_contract::close(const name& owner, const symbol& symbol) {
    require_auth(owner);
-   accounts acnts(get_self(), owner.value);
-   auto     it = acnts.find(symbol.code().raw());
-   check(it != acnts.end(), "Balance row already deleted or never existed. Action won't have any effect.");
-   check(it->balance.amount == 0, "Cannot close because the balance is not zero.");
-   acnts.erase(it);
-}
-
-void system_contract::add_balance(const name& owner, const asset& value, const name& ram_payer) {
-   accounts to_acnts(get_self(), owner.value);
-   auto     to = to_acnts.find(value.symbol.code().raw());
-   if (to == to_acnts.end()) {
-      to_acnts.emplace(ram_payer == owner ? owner : get_self(), [&](auto& a) {
+   account_row acnt(get_self(), owner.value, symbol.code().raw());
+   check(acnt.exists(), "Balance row already deleted or never existed. Action won't have any effect.");
+   check(acnt->balance.amount == 0, "Cannot close because the balance is not zero.");
+   acnt.erase();
+   register_balance(get_config(), owner, std::nullopt);
+}
+
+void system_contract::add_balance(const config& cfg, const name& owner, const asset& value, const name& ram_payer) {
+   account_row to(get_self(), owner.value, value.symbol.code().raw());
+   if (!to.exists()) {
+      to.emplace(ram_payer == owner ? owner : get_self(), [&](auto& a) {
          a.balance = value;
          a.released = ram_payer == owner;
       });
    } else {
-      to_acnts.modify(to, same_payer, [&](auto& a) { a.balance += value; });
+      to.modify(same_payer, [&](auto& a) { a.balance += value; });
    }
+   commit_balance(cfg, owner, to->balance);
+   register_balance(cfg, owner, to->balance);
 }
 
-void system_contract::sub_balance(const name& owner, const asset& value) {
-   accounts from_acnts(get_self(), owner.value);
+void system_contract::sub_balance(const config& cfg, const name& owner, const asset& value) {
+   account_row from(get_self(), owner.value, value.symbol.code().raw());
 
-   const auto& from = from_acnts.get(value.symbol.code().raw(), "no balance object found");
-   check(from.balance.amount >= value.amount, "overdrawn balance");
+   const auto& acnt = from.get("no balance object found");
+   check(acnt.balance.amount >= value.amount, "overdrawn balance");
 
-   if(!from.released){
-      auto balance = from.balance;
+   if(!acnt.released){
+      auto balance = acnt.balance;
       // This clears out the RAM consumed by the scope overhead.
-      from_acnts.erase( from );
-      from_acnts.emplace( owner, [&]( auto& a ){
+      from.erase();
+      from.emplace( owner, [&]( auto& a ){
          a.balance = balance - value;
          a.released = true;
       });
    } else {
-      from_acnts.modify( from, owner, [&]( auto& a ) {
+      from.modify( owner, [&]( auto& a ) {
          a.balance -= value;
       });
    }
+   commit_balance(cfg, owner, from->balance);
+   register_balance(cfg, owner, from->balance);
 }
 
 // ----------------------------------------------------
@@ -138,6 +388,7 @@ void system_contract::sub_balance(const name& owner, const asset& value) {
 // When this contract receives EOS tokens, it will swap them for XYZ tokens and credit them to the sender.
 
 void system_contract::on_transfer(const name& from, const name& to, const asset& quantity, const std::string& memo) {
+   SYSTEM_TRACK_ALLOCATIONS("on_transfer");
    if (from == get_self() || to != get_self())
       return;
    check(quantity.amount > 0, "Swap amount must be greater than 0");
@@ -150,8 +401,21 @@ void system_contract::on_transfer(const name& from, const name& to, const asset&
       return;
 
    check(quantity.symbol == EOS, "Invalid symbol");
-   asset swap_amount = asset(quantity.amount, get_token_symbol());
-   transfer_action(get_self(), {{get_self(), "active"_n}}).send(get_self(), from, swap_amount, std::string(""));
+
+   // The swaps this contract sends itself, e.g. for `swapto`, carry the user's memo but are never routed.
+   const auto route = get_sender() == get_self() ? system_memo::route{} : system_memo::parse_route(memo);
+   switch (route.kind) {
+      case system_memo::route_kind::none:
+         credit_xyz_to(from, quantity);
+         break;
+      case system_memo::route_kind::swapto:
+         enforce_not_blocked(route.account);
+         credit_xyz_to(route.account, quantity);
+         break;
+      default:
+         forward_route(from, route, quantity);
+         break;
+   }
 }
 
 // Allows an account to block themselves from being a recipient of the `swapto` action.
@@ -161,15 +425,14 @@ void system_contract::blockswapto(const name& account, const bool block) {
       require_auth(account);
    }
 
-   blocked_table _blocked(get_self(), get_self().value);
-   auto          itr = _blocked.find(account.value);
+   blocked_row blocked(get_self(), get_self().value, account.value);
    if (block) {
-      if (itr == _blocked.end()) {
-         _blocked.emplace(account, [&](auto& b) { b.account = account; });
+      if (!blocked.exists()) {
+         blocked.emplace(account, [&](auto& b) { b.account = account; });
       }
    } else {
-      if (itr != _blocked.end()) {
-         _blocked.erase(itr);
+      if (blocked.exists()) {
+         blocked.erase();
       }
    }
 }
@@ -178,24 +441,26 @@ void system_contract::blockswapto(const name& account, const bool block) {
 // This action allows exchanges to support "swap & withdraw" for their users and have the swapped tokens flow
 // to the users instead of to their own hot wallets.
 void system_contract::swapto(const name& from, const name& to, const asset& quantity, const std::string& memo) {
+   SYSTEM_TRACK_ALLOCATIONS("swapto");
    require_auth(from);
+   // before the memo is packed into the transfers, which only have room for what `transfer` accepts
+   check(memo.size() <= 256, "memo has more than 256 bytes");
 
-   blocked_table _blocked(get_self(), get_self().value);
-   auto          itr = _blocked.find(to.value);
-   check(itr == _blocked.end(), "Recipient is blocked from receiving swapped tokens: " + to.to_string());
+   enforce_not_blocked(to);
 
+   const symbol token_symbol = get_token_symbol();
    if (quantity.symbol == EOS) {
       // First swap the EOS to XYZ and credit it to the user
-      transfer_action("eosio.token"_n, {{from, "active"_n}}).send(from, get_self(), quantity, std::cref(memo));
+      system_inline::send_transfer("eosio.token"_n, from, from, get_self(), quantity, memo);
 
       // Then transfer the swapped XYZ to the target account
-      transfer_action(get_self(), {{from, "active"_n}}).send(from, to, asset(quantity.amount, get_token_symbol()), std::cref(memo));
-   } else if (quantity.symbol == get_token_symbol()) {
+      system_inline::send_transfer(get_self(), from, from, to, asset(quantity.amount, token_symbol), memo);
+   } else if (quantity.symbol == token_symbol) {
       // First swap the XYZ to EOS and credit it to the user
-      transfer_action(get_self(), {{from, "active"_n}}).send(from, get_self(), quantity, std::cref(memo));
+      system_inline::send_transfer(get_self(), from, from, get_self(), quantity, memo);
 
       // Then transfer the swapped EOS to the target account
-      transfer_action("eosio.token"_n, {{from, "active"_n}}).send(from, to, asset(quantity.amount, EOS), std::cref(memo));
+      system_inline::send_transfer("eosio.token"_n, from, from, to, asset(quantity.amount, EOS), memo);
    } else {
       check(false, "Invalid symbol");
    }
@@ -207,13 +472,194 @@ void system_contract::swapto(const name& from, const name& to, const asset& quan
 // HELPERS --------------------------------------------
 // ----------------------------------------------------
 
+// Gets the contract configuration, or fails if the contract is not initialized.
+system_contract::config system_contract::get_config() {
+   const config_row cfg(get_self(), get_self().value, "config"_n.value);
+   return cfg.get("Contract is not initialized");
+}
+
+// Stores the configuration. Binary extensions are positional, so every field before the last one that is set
+// must be present: fields that were never set are written with their defaults.
+void system_contract::set_config(config cfg) {
+   if (!cfg.swap_audit.has_value()) cfg.swap_audit.emplace(audit_full);
+   if (!cfg.implicit_reserve.has_value()) cfg.implicit_reserve.emplace(false);
+   if (!cfg.commitment.has_value()) cfg.commitment.emplace(false);
+   if (!cfg.registry.has_value()) cfg.registry.emplace(false);
+
+   config_table _config(get_self(), get_self().value);
+   _config.set(cfg, get_self());
+}
+
+// The XYZ left for swaps while the reserve is implicit: the supply less the XYZ in circulation, as counted by the
+// solvency counters swap by swap. EOS this contract receives outside of a swap doesn't move it.
+// Negative if more XYZ was swapped out than the reserve had.
+asset system_contract::get_implicit_reserve(const asset& supply) {
+   const solvency_row counters(get_self(), get_self().value, "solvency"_n.value);
+   return supply - counters.get("solvency counters are not seeded, see syncsolvency").circulating;
+}
+
+// Updates the balance commitment with `owner`'s new balance, when it is enabled. The flag in `cfg` mirrors the
+// commitment's own, so that the commitment is not read at all while it is off.
+void system_contract::commit_balance(const config& cfg, const name& owner, const asset& balance) {
+   if (!cfg.commitment.value_or(false))
+      return;
+   commitment_row commitment(get_self(), get_self().value, "commitment"_n.value);
+   commit(commitment, owner, balance);
+}
+
+// Writes `owner`'s balance into the commitment tree, see system/commitment.hpp. Only the nodes on the owner's
+// path are touched: one pass down to where the owner's leaf is or would be, one pass up to rehash the branches
+// above it. Leaves are moved down below a new branch when another key joins their subtree, and back up when a
+// branch is left with a single leaf, so that every stored branch covers at least two balances.
+void system_contract::commit(commitment_row& commitment, const name& owner, const asset& balance) {
+   using namespace system_commitment;
+   const name     self = get_self();
+   const uint64_t key  = key_of(owner);
+
+   uint32_t            depth = 0;
+   commitment_node_row bottom(self, 0, 0);
+   while (bottom.exists() && bottom->owner == name()) {
+      ++depth;
+      bottom = commitment_node_row(self, depth, prefix_of(key, depth));
+   }
+
+   // The new top of the subtree at `depth` on the path: `hash`, which is the leaf `lone` when `single`.
+   checksum256           hash;
+   commitment_node       lone;
+   bool                  single = false;
+   int64_t               added  = 0;
+   const commitment_node mine{.hash    = balance.amount > 0 ? leaf_hash(owner, balance) : checksum256(),
+                              .owner   = owner,
+                              .balance = balance};
+
+   auto place = [&](uint32_t at, const commitment_node& leaf, uint64_t leaf_key) {
+      commitment_node_row(self, at, prefix_of(leaf_key, at)).emplace(self, [&](auto& n) {
+         n        = leaf;
+         n.prefix = prefix_of(leaf_key, at);
+      });
+   };
+
+   if (!bottom.exists() || bottom->owner == owner) {
+      if (balance.amount == 0) {
+         if (!bottom.exists())
+            return; // never committed, nothing to remove
+         bottom.erase();
+         added = -1;
+      } else {
+         if (bottom.exists()) {
+            bottom.modify(same_payer, [&](auto& n) {
+               n.hash    = mine.hash;
+               n.balance = balance;
+            });
+         } else {
+            place(depth, mine, key);
+            added = 1;
+         }
+         hash   = mine.hash;
+         lone   = mine;
+         single = true;
+      }
+   } else {
+      // Another owner's leaf: both go down to the depth where their keys part, the branches above are
+      // created on the way up.
+      if (balance.amount == 0)
+         return;
+      const commitment_node other     = bottom.get();
+      const uint64_t        other_key = key_of(other.owner);
+      check(other_key != key, "commitment key collision");
+      bottom.erase();
+
+      depth = split_depth(key, other_key);
+      place(depth, other, other_key);
+      place(depth, mine, key);
+      hash   = mine.hash;
+      lone   = mine;
+      single = true;
+      added  = 1;
+   }
+
+   for (uint32_t d = depth; d-- > 0;) {
+      const uint64_t      child = prefix_of(key, d + 1);
+      commitment_node_row sibling(self, d + 1, child ^ 1);
+      commitment_node_row branch(self, d, prefix_of(key, d));
+
+      // replaces the branch by the only leaf left below it
+      auto hoist = [&](const commitment_node& leaf) {
+         branch.modify(same_payer, [&](auto& n) {
+            n        = leaf;
+            n.prefix = prefix_of(key, d);
+         });
+      };
+
+      if (single && !sibling.exists()) {
+         commitment_node_row(self, d + 1, child).erase();
+         hoist(lone);
+      } else if (!single && hash == checksum256() && sibling.exists() && sibling->owner != name()) {
+         lone = sibling.get();
+         sibling.erase();
+         hoist(lone);
+         hash   = lone.hash;
+         single = true;
+      } else {
+         const checksum256 other = sibling.exists() ? sibling->hash : checksum256();
+         hash = child & 1 ? branch_hash(other, hash) : branch_hash(hash, other);
+         if (branch.exists()) {
+            branch.modify(same_payer, [&](auto& n) { n.hash = hash; });
+         } else {
+            branch.emplace(self, [&](auto& n) {
+               n.prefix = prefix_of(key, d);
+               n.hash   = hash;
+            });
+         }
+         single = false;
+      }
+   }
+
+   commitment.modify(same_payer, [&](auto& c) {
+      c.root = hash;
+      c.leaves += added;
+   });
+}
+
+// Mirrors a change to `owner`'s balance row into the holder registry while it is enabled, as the flag in `cfg` says.
+// `balance` is empty when the row was erased.
+void system_contract::register_balance(const config& cfg, const name& owner, const std::optional<asset>& balance) {
+   if (!cfg.registry.value_or(false))
+      return;
+   registry_row registry(get_self(), get_self().value, "registry"_n.value);
+   index_holder(registry, owner, balance);
+}
+
+// Writes `owner`'s row into `holders`, the registry pays for it. Holders are only added or removed along with
+// their `accounts` row, so a balance that drops to zero stays registered until the row is closed.
+void system_contract::index_holder(registry_row& registry, const name& owner, const std::optional<asset>& balance) {
+   holders_table table(get_self(), get_self().value);
+   const auto    itr   = table.find(owner.value);
+   int64_t       added = 0;
+   if (!balance) {
+      if (itr == table.end())
+         return;
+      table.erase(itr);
+      added = -1;
+   } else if (itr == table.end()) {
+      table.emplace(get_self(), [&](auto& h) {
+         h.owner   = owner;
+         h.balance = *balance;
+      });
+      added = 1;
+   } else if (itr->balance != *balance) {
+      table.modify(itr, same_payer, [&](auto& h) { h.balance = *balance; });
+   }
+
+   if (added) {
+      registry.modify(same_payer, [&](auto& r) { r.holders += added; });
+   }
+}
+
 // Gets the token symbol that was selected during initialization,
 // or fails if the contract is not initialized.
 symbol system_contract::get_token_symbol() {
-   config_table _config(get_self(), get_self().value);
-   check(_config.exists(), "Contract is not initialized");
-   config cfg = _config.get();
-   return cfg.token_symbol;
+   return get_config().token_symbol;
 }
 
 // Enforces that the given asset has the right token symbol (XYZ)
@@ -221,41 +667,111 @@ void system_contract::enforce_symbol(const asset& quantity) {
    check(quantity.symbol == get_token_symbol(), "Wrong token used");
 }
 
+// Fails if `recipient` blocked swapped tokens from being sent to them, see `blockswapto`.
+void system_contract::enforce_not_blocked(const name& recipient) {
+   // The message is only built when the check is about to fail.
+   if (blocked_row(get_self(), get_self().value, recipient.value).exists()) {
+      check(false, "Recipient is blocked from receiving swapped tokens: " + recipient.to_string());
+   }
+}
+
 // Send an amount of EOS from this contract to the user, should
 // only happen after sub_balance has been called to reduce their XYZ balance
 void system_contract::credit_eos_to(const name& account, const asset& quantity) {
+   SYSTEM_TRACK_ALLOCATIONS("credit_eos_to");
    check(quantity.amount > 0, "Credit amount must be greater than 0");
 
    asset swap_amount = asset(quantity.amount, EOS);
-   transfer_action("eosio.token"_n, {{get_self(), "active"_n}}).send(get_self(), account, swap_amount, std::string(""));
+   record_swap(quantity, false);
+   system_inline::send_transfer("eosio.token"_n, get_self(), get_self(), account, swap_amount, empty_memo);
+}
+
+// Swaps an amount of EOS this contract received to XYZ and sends it to `account`.
+void system_contract::credit_xyz_to(const name& account, const asset& quantity) {
+   record_swap(quantity, true);
+   asset swap_amount = asset(quantity.amount, get_token_symbol());
+   system_inline::send_transfer(get_self(), get_self(), get_self(), account, swap_amount, empty_memo);
+}
+
+// Spends `eos_quantity`, held by this contract on behalf of `account`, on the action a memo routed it to.
+void system_contract::forward_route(const name& account, const system_memo::route& route, const asset& eos_quantity) {
+   if (route.kind == system_memo::route_kind::buyram) {
+      buyram_action("eosio"_n, {{get_self(), "active"_n}}).send(get_self(), route.account, eos_quantity);
+      return;
+   }
+
+   // The powerup only takes its fee, the rest of the payment goes back to `account` as XYZ.
+   const asset eos_held = get_eos_balance(get_self()) - eos_quantity;
+   powerup_action("eosio"_n, {{get_self(), "active"_n}})
+      .send(get_self(), route.account, route.days, route.net_frac, route.cpu_frac, eos_quantity);
+   creditexcess_action(get_self(), {{get_self(), "active"_n}}).send(account, eos_held);
+}
+
+// Updates the solvency counters for a swap of `quantity` in one direction. Counters that were never seeded
+// are left alone, `syncsolvency` seeds them from the state at rest.
+void system_contract::record_swap(const asset& quantity, bool to_xyz) {
+   solvency_row counters(get_self(), get_self().value, "solvency"_n.value);
+   if (!counters.exists())
+      return;
+
+   counters.modify(same_payer, [&](auto& s) {
+      if (to_xyz) {
+         s.circulating.amount += quantity.amount;
+         s.eos_held.amount += quantity.amount;
+         s.swapped_in.amount += quantity.amount;
+      } else {
+         s.circulating.amount -= quantity.amount;
+         s.eos_held.amount -= quantity.amount;
+         s.swapped_out.amount += quantity.amount;
+      }
+   });
 }
 
 // Allows users to use XYZ tokens to perform actions on the system contract
 // by swapping them for EOS tokens before forwarding the action
 void system_contract::swap_before_forwarding(const name& account, const asset& quantity) {
-   check(quantity.symbol == get_token_symbol(), "Wrong token used");
+   SYSTEM_TRACK_ALLOCATIONS("swap_before_forwarding");
+   const config cfg = get_config();
+   check(quantity.symbol == cfg.token_symbol, "Wrong token used");
    check(quantity.amount > 0, "Swap before amount must be greater than 0");
 
-   swaptrace_action(get_self(), {{get_self(), "active"_n}}).send(account, quantity);
-   sub_balance(account, quantity);
-   add_balance(get_self(), quantity, get_self());
+   switch (cfg.swap_audit.value_or(audit_full)) {
+      case audit_full:
+         system_inline::packed_action<64>(get_self(), "swaptrace"_n, get_self()).send(account, quantity);
+         break;
+      case audit_compact: {
+         // The receipt becomes the return value of the forwarding action that triggered the swap.
+         char              receipt[sizeof(name) + sizeof(asset)];
+         datastream<char*> ds(receipt, sizeof(receipt));
+         ds << swap_receipt{account, quantity};
+         internal_use_do_not_use::set_action_return_value(receipt, ds.tellp());
+         break;
+      }
+      default:
+         break;
+   }
+
+   sub_balance(cfg, account, quantity);
+   if (!cfg.implicit_reserve.value_or(false)) {
+      add_balance(cfg, get_self(), quantity, get_self());
+   }
    credit_eos_to(account, quantity);
 }
 
 // Allows users to get back XYZ tokens from actions that give them EOS tokens
 // by swapping them for XYZ as the last inline action
 void system_contract::swap_after_forwarding(const name& account, const asset& quantity) {
+   SYSTEM_TRACK_ALLOCATIONS("swap_after_forwarding");
    asset swap_amount = asset(quantity.amount, EOS);
    check(swap_amount.amount > 0, "Swap after amount must be greater than 0");
 
-   transfer_action("eosio.token"_n, {{account, "active"_n}}).send(account, get_self(), swap_amount, std::string(""));
+   system_inline::send_transfer("eosio.token"_n, account, account, get_self(), swap_amount, empty_memo);
 }
 
 // Gets a given account's balance of EOS
 asset system_contract::get_eos_balance(const name& account) {
-   eosio_token::accounts acnts("eosio.token"_n, account.value);
-   const auto& found = acnts.find(EOS.code().raw());
-   if (found == acnts.end()) {
+   const eosio_token::account_row found("eosio.token"_n, account.value, EOS.code().raw());
+   if (!found.exists()) {
       return asset(0, EOS);
    }
 
@@ -270,8 +786,9 @@ asset system_contract::get_eos_balance(const name& account) {
 // of using the user experience forwarding actions in this contract.
 void system_contract::enforcebal(const name& account, const asset& expected_eos_balance) {
    asset eos_balance = get_eos_balance(account);
-   check(eos_balance == expected_eos_balance,
-         "EOS balance mismatch: " + eos_balance.to_string() + " != " + expected_eos_balance.to_string());
+   if (eos_balance != expected_eos_balance) {
+      check(false, "EOS balance mismatch: " + eos_balance.to_string() + " != " + expected_eos_balance.to_string());
+   }
 }
 
 // Swaps any excess EOS back to XYZ after an action
@@ -288,6 +805,15 @@ void system_contract::swaptrace(const name& account, const asset& quantity) {
    require_auth(get_self());
 }
 
+// Swaps the EOS this contract holds above `eos_held` to XYZ for `account`, after a routed powerup.
+void system_contract::creditexcess(const name& account, const asset& eos_held) {
+   require_auth(get_self());
+   const asset eos_after = get_eos_balance(get_self());
+   if (eos_after > eos_held) {
+      credit_xyz_to(account, eos_after - eos_held);
+   }
+}
+
 // ----------------------------------------------------
 // SYSTEM ACTIONS -------------------------------------
 // ----------------------------------------------------
@@ -416,6 +942,64 @@ void system_contract::newaccount2(const name& creator, const name& name, eosio::
    newaccount_action("eosio"_n, {{creator, "active"_n}}).send(creator, name, auth, auth);
 }
 
+void system_contract::newaccounts(const name& creator, const std::vector<new_account>& accounts) {
+   require_auth(creator);
+   check(!accounts.empty(), "no accounts to create");
+
+   // The RAM is bought one account after the other, each at the price `eosio::buyrambytes` sees once the
+   // previous purchases moved the market, so that the swap covers exactly what the batch spends.
+   rammarket     _rammarket("eosio"_n, "eosio"_n.value);
+   auto          itr         = _rammarket.find(RAMCORE.raw());
+   int64_t       ram_reserve = itr->base.balance.amount;
+   int64_t       eos_reserve = itr->quote.balance.amount;
+   const symbol  sym         = get_token_symbol();
+   int64_t       total       = 0;
+   auto          add         = [&](int64_t amount) {
+      check(amount <= asset::max_amount - total, "batch total overflows");
+      total += amount;
+   };
+   for (const auto& a : accounts) {
+      check(a.net.is_valid() && a.cpu.is_valid(), "invalid quantity");
+      check(a.net.symbol == sym && a.cpu.symbol == sym, "Wrong token used");
+      check(a.net.amount >= 0 && a.cpu.amount >= 0, "must stake a non-negative amount");
+      add(a.net.amount);
+      add(a.cpu.amount);
+      if (a.ram_bytes > 0) {
+         const int64_t cost          = get_bancor_input(ram_reserve, eos_reserve, a.ram_bytes);
+         const int64_t cost_plus_fee = cost / double(0.995);
+         const int64_t after_fee     = cost_plus_fee - (cost_plus_fee + 199) / 200;
+         ram_reserve -= get_bancor_output(eos_reserve, ram_reserve, after_fee);
+         eos_reserve += after_fee;
+         check(cost_plus_fee > 0, "invalid ram cost");
+         add(cost_plus_fee);
+      }
+   }
+
+   const asset eos_before = get_eos_balance(creator);
+   if (total > 0) {
+      swap_before_forwarding(creator, asset(total, sym));
+   }
+
+   // One buffer per action for the whole batch, and a single authority whose key is swapped per account.
+   system_inline::packed_action<512> create("eosio"_n, "newaccount"_n, creator);
+   system_inline::packed_action<64>  buy_ram("eosio"_n, "buyrambytes"_n, creator);
+   system_inline::packed_action<128> stake("eosio"_n, "delegatebw"_n, creator);
+   authority auth{.threshold = 1, .keys = {{.weight = 1}}};
+   for (const auto& a : accounts) {
+      auth.keys[0].key = a.key;
+      create.send(creator, a.account, auth, auth);
+      if (a.ram_bytes > 0) {
+         buy_ram.send(creator, a.account, a.ram_bytes);
+      }
+      if (a.net.amount > 0 || a.cpu.amount > 0) {
+         stake.send(creator, a.account, asset(a.net.amount, EOS), asset(a.cpu.amount, EOS), false);
+      }
+   }
+
+   // The creator's own EOS must not have been spent, as for `buyrambytes`.
+   enforcebal_action(get_self(), {{creator, "active"_n}}).send(creator, eos_before);
+}
+
 void system_contract::powerup(const name& payer, const name& receiver, uint32_t days, int64_t net_frac,
                               int64_t cpu_frac, const asset& max_payment) {
    require_auth(payer);
@@ -431,6 +1015,57 @@ void system_contract::powerup(const name& payer, const name& receiver, uint32_t
    swapexcess_action(get_self(), {{get_self(), "active"_n}}).send(payer, eos_balance_before_swap);
 }
 
+void system_contract::provision(const name& payer, const std::vector<provision_request>& requests) {
+   require_auth(payer);
+   check(!requests.empty(), "nothing to provision");
+
+   const symbol sym      = get_token_symbol();
+   int64_t      total    = 0;
+   bool         powerups = false;
+   auto         add      = [&](int64_t amount) {
+      check(amount <= asset::max_amount - total, "batch total overflows");
+      total += amount;
+   };
+   for (const auto& r : requests) {
+      check(r.kind <= provision_powerup, "invalid provision kind");
+      const bool stake = r.kind == provision_stake;
+      check(r.quantity.is_valid() && (!stake || r.cpu_quantity.is_valid()), "invalid quantity");
+      check(r.quantity.symbol == sym && (!stake || r.cpu_quantity.symbol == sym), "Wrong token used");
+      check(r.quantity.amount >= 0 && (!stake || r.cpu_quantity.amount >= 0), "must provision a non-negative amount");
+      add(r.quantity.amount);
+      if (stake)
+         add(r.cpu_quantity.amount);
+      powerups |= r.kind == provision_powerup;
+   }
+
+   const asset eos_before = get_eos_balance(payer);
+   swap_before_forwarding(payer, asset(total, sym));
+
+   // One buffer per action for the whole batch.
+   system_inline::packed_action<128> buy_ram("eosio"_n, "buyram"_n, payer);
+   system_inline::packed_action<128> stake("eosio"_n, "delegatebw"_n, payer);
+   system_inline::packed_action<128> power("eosio"_n, "powerup"_n, payer);
+   for (const auto& r : requests) {
+      const asset eos_quantity = asset(r.quantity.amount, EOS);
+      switch (r.kind) {
+         case provision_ram:
+            buy_ram.send(payer, r.receiver, eos_quantity);
+            break;
+         case provision_stake:
+            stake.send(payer, r.receiver, eos_quantity, asset(r.cpu_quantity.amount, EOS), false);
+            break;
+         default:
+            power.send(payer, r.receiver, r.days, r.net_frac, r.cpu_frac, eos_quantity);
+            break;
+      }
+   }
+
+   // what the powerups did not spend goes back to XYZ
+   if (powerups) {
+      swapexcess_action(get_self(), {{get_self(), "active"_n}}).send(payer, eos_before);
+   }
+}
+
 void system_contract::delegatebw(const name& from, const name& receiver, const asset& stake_net_quantity,
                                  const asset& stake_cpu_quantity, const bool& transfer) {
    require_auth(from);
@@ -0,0 +1,31 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bench_harness.hpp"
+
+using namespace eosio_system;
+using namespace eosio_system::bench;
+
+BOOST_AUTO_TEST_SUITE(allocator_bench);
+
+// ----------------------------------------------------------------------
+// bench: CDT's allocator vs the bump arena (SYSTEM_ARENA_ALLOCATOR)
+// over the token, swap and forwarding actions
+// ----------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(forwarding_actions, bench_tester) try {
+   const std::vector<std::pair<std::string, std::vector<uint8_t>>> variants = {
+      {"malloc", xyz_contracts::system_wasm()},
+      {"arena",  xyz_contracts::system_arena_wasm()},
+   };
+
+   report rep("system contract allocator");
+   for (const auto& s : standard_scenarios()) {
+      for (const auto& [variant, wasm] : variants) {
+         deploy_xyz(wasm);
+         rep.add(s.name, variant, run(s, iterations()));
+      }
+   }
+   rep.print();
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
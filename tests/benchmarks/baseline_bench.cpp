@@ -0,0 +1,37 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bench_harness.hpp"
+
+using namespace eosio_system;
+using namespace eosio_system::bench;
+
+BOOST_AUTO_TEST_SUITE(baseline_bench);
+
+// ----------------------------------------------------------------------
+// bench: the contract built from this tree against the same tree with one optimization undone, and against a
+// baseline build of it (e.g. the `system.wasm` of the last release) given as SYSTEM_BENCH_BASELINE_WASM.
+// "multi_index" reads and writes rows through `eosio::multi_index` instead of the db intrinsics, so its transfer row
+// shows the CPU the direct access saves per transfer. "wrapped" sends the inline actions through `eosio::action`
+// instead of the pre-packed buffers, its swap rows show what those save.
+// ----------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(standard_workload, bench_tester) try {
+   std::vector<std::pair<std::string, std::vector<uint8_t>>> variants = {
+      {"current",     xyz_contracts::system_wasm()},
+      {"multi_index", xyz_contracts::system_multi_index_wasm()},
+      {"wrapped",     xyz_contracts::system_wrapped_inline_wasm()},
+   };
+   if (const char* baseline = std::getenv("SYSTEM_BENCH_BASELINE_WASM"))
+      variants.emplace_back("baseline", read_wasm(baseline));
+
+   report rep("system contract vs baseline");
+   for (const auto& s : standard_scenarios()) {
+      for (const auto& [variant, wasm] : variants) {
+         deploy_xyz(wasm);
+         rep.add(s.name, variant, run(s, iterations()));
+      }
+   }
+   rep.print();
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
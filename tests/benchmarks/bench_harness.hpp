@@ -0,0 +1,300 @@
+#pragma once
+
+#include "../eosio.system_tester.hpp"
+
+#include <xyz/wasm_meter.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+namespace eosio_system::bench {
+
+// ----------------------------------------------------------------------
+// measurements
+// ----------------------------------------------------------------------
+
+// Resource usage of one transaction, read from its trace.
+struct sample {
+   int64_t  cpu_us       = 0; // billed CPU
+   int64_t  elapsed_us   = 0; // time spent executing the transaction
+   uint64_t net_bytes    = 0; // billed NET
+   int64_t  ram_delta    = 0; // sum of the RAM deltas of every account
+   uint32_t actions      = 0; // action traces, including inline actions and notifications
+   uint64_t instructions = 0; // WASM instructions executed by the xyz contract, see `metering()`
+   uint64_t host_calls   = 0; // calls of the xyz contract to host functions, see `metering()`
+};
+
+// Whether the xyz contract is deployed instrumented by `xyz_tools::meter_wasm`, so that samples also count its
+// instructions and host calls. Those don't vary between runs or machines as billed CPU does. Enabled by a non-empty
+// `SYSTEM_BENCH_METER` other than `0` in the environment; the instrumentation adds to the CPU and elapsed time.
+inline bool metering() {
+   const char* env = std::getenv("SYSTEM_BENCH_METER");
+   return env && *env && std::string_view(env) != "0";
+}
+
+inline std::vector<uint8_t> metered(const std::vector<uint8_t>& wasm) {
+   const auto out = xyz_tools::meter_wasm({reinterpret_cast<const char*>(wasm.data()), wasm.size()});
+   return {out.begin(), out.end()};
+}
+
+inline sample measure(const transaction_trace_ptr& trace) {
+   sample s;
+   if (trace->receipt) {
+      s.cpu_us    = trace->receipt->cpu_usage_us;
+      s.net_bytes = uint64_t(trace->receipt->net_usage_words) * 8;
+   }
+   s.elapsed_us = trace->elapsed.count();
+   s.actions    = trace->action_traces.size();
+   for (const auto& at : trace->action_traces) {
+      for (const auto& delta : at.account_ram_deltas)
+         s.ram_delta += delta.delta;
+      if (at.receiver == eosio_system_tester::xyz_name) {
+         const auto counts = xyz_tools::parse_meter_console(at.console);
+         s.instructions += counts.instructions;
+         s.host_calls += counts.host_calls;
+      }
+   }
+   return s;
+}
+
+// What each action run by the xyz contract in `trace` executed, labelled with the action's name, and `@<code>` for a
+// notification. Empty unless the contract is instrumented, see `metering()`.
+inline std::vector<std::pair<std::string, xyz_tools::meter_counts>> host_profile(const transaction_trace_ptr& trace) {
+   std::vector<std::pair<std::string, xyz_tools::meter_counts>> actions;
+   for (const auto& at : trace->action_traces) {
+      if (at.receiver != eosio_system_tester::xyz_name)
+         continue;
+      auto counts = xyz_tools::parse_meter_console(at.console);
+      if (!counts.instructions)
+         continue;
+      auto label = at.act.name.to_string();
+      if (at.act.account != at.receiver)
+         label += "@" + at.act.account.to_string();
+      actions.emplace_back(std::move(label), std::move(counts));
+   }
+   return actions;
+}
+
+// Medians of a series of samples.
+inline sample summarize(std::vector<sample> samples) {
+   if (samples.empty())
+      return {};
+   auto median = [&](auto member) {
+      std::sort(samples.begin(), samples.end(), [&](const sample& a, const sample& b) { return a.*member < b.*member; });
+      return samples[samples.size() / 2].*member;
+   };
+   sample s;
+   s.cpu_us       = median(&sample::cpu_us);
+   s.elapsed_us   = median(&sample::elapsed_us);
+   s.net_bytes    = median(&sample::net_bytes);
+   s.ram_delta    = median(&sample::ram_delta);
+   s.actions      = median(&sample::actions);
+   s.instructions = median(&sample::instructions);
+   s.host_calls   = median(&sample::host_calls);
+   return s;
+}
+
+// Number of times each scenario is repeated, `SYSTEM_BENCH_ITERATIONS` in the environment overrides the default.
+inline uint32_t iterations(uint32_t fallback = 50) {
+   if (const char* env = std::getenv("SYSTEM_BENCH_ITERATIONS"))
+      return std::max(1, std::atoi(env));
+   return fallback;
+}
+
+// ----------------------------------------------------------------------
+// report
+// ----------------------------------------------------------------------
+
+// A table of summarized samples, one row per (scenario, variant). The elapsed time of every variant
+// is also shown relative to the first variant measured for the same scenario. Instruction and host call
+// counts are shown when some were measured.
+class report {
+public:
+   explicit report(std::string title)
+      : _title(std::move(title)) {}
+
+   void add(const std::string& scenario, const std::string& variant, const std::vector<sample>& samples) {
+      _rows.push_back({scenario, variant, summarize(samples), samples.size()});
+   }
+
+   void print(std::ostream& out = std::cout) const {
+      const bool counted = std::any_of(_rows.begin(), _rows.end(), [](const row& r) { return r.summary.instructions; });
+      out << "\n== " << _title << " ==\n";
+      out << std::left << std::setw(22) << "scenario" << std::setw(14) << "variant" << std::right << std::setw(6)
+          << "runs" << std::setw(10) << "cpu us" << std::setw(12) << "elapsed us" << std::setw(10) << "vs base"
+          << std::setw(10) << "net B" << std::setw(10) << "ram B" << std::setw(9) << "actions";
+      if (counted)
+         out << std::setw(12) << "instr" << std::setw(8) << "host";
+      out << "\n";
+
+      for (const auto& r : _rows) {
+         const auto base = std::find_if(_rows.begin(), _rows.end(), [&](const row& b) { return b.scenario == r.scenario; });
+         std::ostringstream delta;
+         if (base->summary.elapsed_us > 0 && &*base != &r)
+            delta << std::showpos << std::fixed << std::setprecision(1)
+                  << 100.0 * (r.summary.elapsed_us - base->summary.elapsed_us) / base->summary.elapsed_us << "%";
+
+         out << std::left << std::setw(22) << r.scenario << std::setw(14) << r.variant << std::right << std::setw(6)
+             << r.runs << std::setw(10) << r.summary.cpu_us << std::setw(12) << r.summary.elapsed_us << std::setw(10)
+             << delta.str() << std::setw(10) << r.summary.net_bytes << std::setw(10) << r.summary.ram_delta
+             << std::setw(9) << r.summary.actions;
+         if (counted)
+            out << std::setw(12) << r.summary.instructions << std::setw(8) << r.summary.host_calls;
+         out << "\n";
+      }
+      out << std::flush;
+   }
+
+private:
+   struct row {
+      std::string scenario;
+      std::string variant;
+      sample      summary;
+      size_t      runs;
+   };
+
+   std::string      _title;
+   std::vector<row> _rows;
+};
+
+// ----------------------------------------------------------------------
+// fixture
+// ----------------------------------------------------------------------
+
+// One named transaction generator, called once per iteration.
+struct scenario {
+   std::string                            name;
+   std::function<transaction_trace_ptr()> run;
+};
+
+// `eosio_system_tester` with a funded account that holds XYZ, EOS, RAM and stake, and the standard
+// workload of the wrapper contract expressed as scenarios.
+class bench_tester : public eosio_system_tester {
+public:
+   static constexpr account_name payer = "benchpayer"_n;
+   static constexpr account_name peer  = "benchpeer"_n;
+
+   bench_tester() {
+      if (metering())
+         deploy_xyz(xyz_contracts::system_wasm());
+      create_accounts_with_resources({payer, peer});
+      transfer(eos_name, payer, eos("100000.0000"));
+      transfer(payer, xyz_name, eos("50000.0000"), payer); // swap half of it to XYZ
+
+      // room for the accounts created by `newaccount2`
+      base_tester::push_action(eos_name, "buyram"_n, eos_name,
+                               mvo()("payer", eos_name)("receiver", payer)("quant", eos("10000.0000")));
+
+      // own stake, so that the payer can vote
+      base_tester::push_action(xyz_name, "delegatebw"_n, payer,
+                               mvo()("from", payer)("receiver", payer)("stake_net_quantity", xyz("10.0000"))(
+                                  "stake_cpu_quantity", xyz("10.0000"))("transfer", false));
+      produce_block();
+   }
+
+   // Replaces the code of the xyz account, ignoring the error raised when it is already deployed. The code is
+   // instrumented first when `meter`.
+   void deploy_xyz(const std::vector<uint8_t>& wasm, bool meter = metering()) {
+      try {
+         set_code(xyz_name, meter ? metered(wasm) : wasm);
+      } catch (const set_exact_code&) {
+      }
+      produce_block();
+   }
+
+   action make_action(account_name code, action_name act, account_name actor, const variant_object& data) {
+      return get_action(code, act, vector<permission_level>{{actor, config::active_name}}, data);
+   }
+
+   // Pushes several actions in one transaction signed by the active keys of `signers`.
+   transaction_trace_ptr push_actions(vector<action> actions, const vector<account_name>& signers) {
+      signed_transaction trx;
+      trx.actions = std::move(actions);
+      set_transaction_headers(trx);
+      for (auto signer : signers)
+         trx.sign(get_private_key(signer, "active"), control->get_chain_id());
+      return push_transaction(trx);
+   }
+
+   // Runs a scenario `count` times, each in its own block.
+   std::vector<sample> run(const scenario& s, uint32_t count) {
+      std::vector<sample> samples;
+      samples.reserve(count);
+      for (uint32_t i = 0; i < count; ++i) {
+         auto trace = s.run();
+         produce_block();
+         samples.push_back(measure(trace));
+      }
+      return samples;
+   }
+
+   // A fresh account name on every call, e.g. `benchaaaaaab`. Always 12 characters: `eosio.system` only lets an
+   // account other than `eosio` create a shorter name once its auction closed, so `newaccount2` needs full names.
+   account_name next_account_name(const std::string& prefix = "bench") {
+      std::string suffix;
+      for (uint32_t n = _name_counter++; prefix.size() + suffix.size() < 12; n /= 26)
+         suffix.insert(suffix.begin(), char('a' + n % 26));
+      return account_name(prefix + suffix);
+   }
+
+   // The wrapper's token actions and the forwarding actions, as they are used by wallets.
+   std::vector<scenario> standard_scenarios() {
+      return {
+         {"transfer", [this] {
+             return base_tester::push_action(xyz_name, "transfer"_n, payer,
+                                             mvo()("from", payer)("to", peer)("quantity", xyz("0.0001"))("memo", ""));
+          }},
+         {"swap eos->xyz", [this] {
+             return base_tester::push_action("eosio.token"_n, "transfer"_n, payer,
+                                             mvo()("from", payer)("to", xyz_name)("quantity", eos("0.0001"))("memo", ""));
+          }},
+         {"swap xyz->eos", [this] {
+             return base_tester::push_action(xyz_name, "transfer"_n, payer,
+                                             mvo()("from", payer)("to", xyz_name)("quantity", xyz("0.0001"))("memo", ""));
+          }},
+         {"swapto", [this] {
+             return base_tester::push_action(xyz_name, "swapto"_n, payer,
+                                             mvo()("from", payer)("to", peer)("quantity", eos("0.0001"))("memo", ""));
+          }},
+         {"buyram", [this] {
+             return base_tester::push_action(xyz_name, "buyram"_n, payer,
+                                             mvo()("payer", payer)("receiver", payer)("quant", xyz("0.0100")));
+          }},
+         {"buyrambytes", [this] {
+             return base_tester::push_action(xyz_name, "buyrambytes"_n, payer,
+                                             mvo()("payer", payer)("receiver", payer)("bytes", 100));
+          }},
+         {"delegatebw", [this] {
+             return base_tester::push_action(xyz_name, "delegatebw"_n, payer,
+                                             mvo()("from", payer)("receiver", peer)("stake_net_quantity", xyz("0.0001"))(
+                                                "stake_cpu_quantity", xyz("0.0001"))("transfer", false));
+          }},
+         {"voteproducer", [this] {
+             return base_tester::push_action(xyz_name, "voteproducer"_n, payer,
+                                             mvo()("voter", payer)("proxy", name())("producers", std::vector<name>{}));
+          }},
+         {"updateauth", [this] {
+             return base_tester::push_action(xyz_name, "updateauth"_n, payer,
+                                             mvo()("account", payer)("permission", "bench"_n)("parent", "active"_n)(
+                                                "auth", authority(get_public_key(payer, "active"))));
+          }},
+         {"newaccount2", [this] {
+             const auto account = next_account_name();
+             return push_actions({make_action(xyz_name, "newaccount2"_n, payer,
+                                              mvo()("creator", payer)("name", account)(
+                                                 "key", get_public_key(account, "active"))),
+                                  make_action(eos_name, "buyrambytes"_n, payer,
+                                              mvo()("payer", payer)("receiver", account)("bytes", 3000))},
+                                 {payer});
+          }},
+      };
+   }
+
+private:
+   uint32_t _name_counter = 0;
+};
+
+} // namespace eosio_system::bench
@@ -0,0 +1,93 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bench_harness.hpp"
+
+#include <chrono>
+
+using namespace eosio_system;
+using namespace eosio_system::bench;
+
+BOOST_AUTO_TEST_SUITE(codec_bench);
+
+// ----------------------------------------------------------------------
+// bench: the tester's own cost of reading balances and encoding actions, through the ABI and `fc::variant`
+// as it used to, and through the typed codec of xyz_codec.hpp as it does now. Nothing is pushed to the
+// chain; each operation is repeated 100 x `SYSTEM_BENCH_ITERATIONS` (default 50) times.
+// ----------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(balances_and_actions, bench_tester) try {
+   const uint32_t repeat = 100 * iterations();
+   const auto     code   = account_name(xyz_symbol().to_symbol_code().value);
+
+   // Nanoseconds per call of `fn`, which returns something that depends on its work.
+   auto per_call = [&](auto fn) {
+      uint64_t   sink  = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < repeat; ++i)
+         sink += fn();
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      BOOST_REQUIRE(sink != 0);
+      return double(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / repeat;
+   };
+
+   struct row {
+      std::string name;
+      double      abi_ns;
+      double      typed_ns;
+   };
+   std::vector<row> rows;
+
+   rows.push_back({"get_xyz_balance",
+                   per_call([&] {
+                      const auto data = get_row_by_account(xyz_name, payer, "accounts"_n, code);
+                      return xyz_abi_ser.binary_to_variant("account", data, abi_serializer_max_time)["balance"]
+                         .as<asset>()
+                         .get_amount();
+                   }),
+                   per_call([&] { return get_xyz_balance(payer).get_amount(); })});
+
+   rows.push_back({"get_xyz_stats",
+                   per_call([&] {
+                      const auto data = get_row_by_account(xyz_name, code, "stat"_n, code);
+                      return xyz_abi_ser.binary_to_variant("currency_stats", data, abi_serializer_max_time)["supply"]
+                         .as<asset>()
+                         .get_amount();
+                   }),
+                   per_call([&] { return get_xyz_stats().supply.get_amount(); })});
+
+   rows.push_back({"encode transfer",
+                   per_call([&] {
+                      return contract::serialize(xyz_abi_ser, "transfer"_n,
+                                                 mvo()("from", payer)("to", peer)("quantity", xyz("0.0001"))(
+                                                    "memo", "bench"))
+                         .size();
+                   }),
+                   per_call([&] {
+                      return xyz_codec::pack(xyz_codec::transfer{payer, peer, xyz("0.0001"), "bench"}).size();
+                   })});
+
+   rows.push_back({"encode delegatebw",
+                   per_call([&] {
+                      return contract::serialize(xyz_abi_ser, "delegatebw"_n,
+                                                 mvo()("from", payer)("receiver", peer)(
+                                                    "stake_net_quantity", xyz("0.0001"))(
+                                                    "stake_cpu_quantity", xyz("0.0001"))("transfer", false))
+                         .size();
+                   }),
+                   per_call([&] {
+                      return xyz_codec::pack(
+                                xyz_codec::delegatebw{payer, peer, xyz("0.0001"), xyz("0.0001"), false})
+                         .size();
+                   })});
+
+   std::cout << "\n== tester codec, " << repeat << " calls each ==\n"
+             << std::left << std::setw(22) << "operation" << std::right << std::setw(12) << "abi ns" << std::setw(12)
+             << "typed ns" << std::setw(10) << "speedup" << "\n";
+   for (const auto& r : rows)
+      std::cout << std::left << std::setw(22) << r.name << std::right << std::fixed << std::setprecision(0)
+                << std::setw(12) << r.abi_ns << std::setw(12) << r.typed_ns << std::setprecision(1) << std::setw(9)
+                << r.abi_ns / r.typed_ns << "x" << "\n";
+   std::cout << std::defaultfloat << std::flush;
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,53 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bench_harness.hpp"
+
+using namespace eosio_system;
+using namespace eosio_system::bench;
+
+BOOST_AUTO_TEST_SUITE(hostcall_bench);
+
+// ----------------------------------------------------------------------
+// bench: the host functions each action of the xyz contract calls in the standard scenarios, counted by the
+// instrumented contract whatever `SYSTEM_BENCH_METER` says. The counts don't vary between runs; each scenario runs
+// twice and the second run is reported, so that rows created by the first one are not counted as creations.
+// ----------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(host_calls, bench_tester) try {
+   deploy_xyz(xyz_contracts::system_wasm(), true);
+
+   // the calls behind the symbol checks, the blocked lookup and the balance probes; the rest is summed as `other`
+   static const std::vector<std::string> columns = {"db_find_i64",  "db_get_i64", "db_update_i64", "send_inline",
+                                                    "require_auth", "has_auth",   "is_account",    "require_recipient"};
+
+   std::cout << "\n== host calls per action ==\n"
+             << std::left << std::setw(16) << "scenario" << std::setw(22) << "action" << std::right << std::setw(10)
+             << "instr";
+   for (const auto& c : columns)
+      std::cout << std::setw(c.size() + 2) << c;
+   std::cout << std::setw(8) << "other" << std::setw(8) << "total" << "\n";
+
+   for (const auto& s : standard_scenarios()) {
+      run(s, 1);
+      const auto trace = s.run();
+      produce_block();
+
+      const auto actions = host_profile(trace);
+      BOOST_REQUIRE_MESSAGE(!actions.empty(), s.name << ": the contract reported no counts");
+      for (const auto& [action, counts] : actions) {
+         std::cout << std::left << std::setw(16) << s.name << std::setw(22) << action << std::right << std::setw(10)
+                   << counts.instructions;
+         uint64_t listed = 0;
+         for (const auto& c : columns) {
+            const auto it    = counts.host.find(c);
+            const auto calls = it == counts.host.end() ? 0 : it->second;
+            listed += calls;
+            std::cout << std::setw(c.size() + 2) << calls;
+         }
+         std::cout << std::setw(8) << counts.host_calls - listed << std::setw(8) << counts.host_calls << "\n";
+      }
+   }
+   std::cout << std::flush;
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
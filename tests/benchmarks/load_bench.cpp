@@ -0,0 +1,320 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bench_harness.hpp"
+
+#include <chrono>
+#include <latch>
+#include <random>
+#include <thread>
+
+using namespace eosio_system;
+using namespace eosio_system::bench;
+
+namespace {
+
+// ----------------------------------------------------------------------
+// configuration
+// ----------------------------------------------------------------------
+
+uint32_t env_or(const char* name, uint32_t fallback) {
+   if (const char* env = std::getenv(name))
+      return std::max(1, std::atoi(env));
+   return fallback;
+}
+
+// One kind of transaction in the mix and its share of the traffic.
+struct load_kind {
+   std::string name;
+   uint32_t    weight;
+};
+
+// Every chain gets the same accounts and the same mix, with its own random stream.
+struct load_config {
+   uint32_t               chains       = env_or("SYSTEM_LOAD_CHAINS", 4);
+   uint32_t               accounts     = env_or("SYSTEM_LOAD_ACCOUNTS", 1000);
+   uint32_t               transactions = env_or("SYSTEM_LOAD_TRANSACTIONS", 5000);
+   uint32_t               block_size   = env_or("SYSTEM_LOAD_BLOCK", 100);
+   uint32_t               seed         = env_or("SYSTEM_LOAD_SEED", 1);
+   std::vector<load_kind> mix;
+
+   static constexpr const char* default_mix = "transfer=40,swap=25,swapto=10,buyrambytes=10,powerup=5,delegatebw=10";
+   static constexpr const char* known_kinds[] = {"transfer", "swap", "swapto", "buyrambytes", "powerup", "delegatebw"};
+
+   load_config() {
+      const char* env = std::getenv("SYSTEM_LOAD_MIX");
+      std::istringstream in(env ? env : default_mix);
+      for (std::string entry; std::getline(in, entry, ',');) {
+         const auto eq = entry.find('=');
+         FC_ASSERT(eq != std::string::npos, "SYSTEM_LOAD_MIX entries are <kind>=<weight>, got ${e}", ("e", entry));
+         const auto kind = entry.substr(0, eq);
+         FC_ASSERT(std::find(std::begin(known_kinds), std::end(known_kinds), kind) != std::end(known_kinds),
+                   "unknown kind ${k} in SYSTEM_LOAD_MIX", ("k", kind));
+         mix.push_back({kind, uint32_t(std::max(0, std::atoi(entry.c_str() + eq + 1)))});
+      }
+      FC_ASSERT(std::ranges::any_of(mix, [](const load_kind& k) { return k.weight > 0; }), "SYSTEM_LOAD_MIX is empty");
+      FC_ASSERT(accounts <= 26 * 26 * 26 * 26, "SYSTEM_LOAD_ACCOUNTS is at most ${n}", ("n", 26 * 26 * 26 * 26));
+   }
+};
+
+// ----------------------------------------------------------------------
+// results
+// ----------------------------------------------------------------------
+
+struct kind_result {
+   std::vector<int64_t> cpu_us;     // billed CPU of every transaction that went through
+   std::vector<int64_t> elapsed_us; // and its execution time
+   uint32_t             failed    = 0;
+   uint64_t             actions   = 0;
+   int64_t              ram_delta = 0;
+};
+
+struct chain_result {
+   std::vector<kind_result> kinds;
+   double                   seconds     = 0; // the load, blocks included, not the setup
+   int64_t                  state_bytes = 0; // growth of the chain's state database
+   std::exception_ptr       error;
+};
+
+int64_t percentile(std::vector<int64_t>& values, double p) {
+   if (values.empty())
+      return 0;
+   const size_t n = std::min(values.size() - 1, size_t(p * values.size()));
+   std::nth_element(values.begin(), values.begin() + n, values.end());
+   return values[n];
+}
+
+// ----------------------------------------------------------------------
+// chain
+// ----------------------------------------------------------------------
+
+// An independent chain with `accounts` funded accounts, driven by the thread that constructed it: a controller
+// must stay on the thread it was created on.
+class load_chain : public eosio_system_tester {
+public:
+   load_chain(const load_config& load, uint32_t index)
+      : _config(load)
+      , _random(uint64_t(load.seed) << 32 | index) {
+      base_tester::push_action(eos_name, "cfgpowerup"_n, eos_name,
+                               mvo()("args", make_powerup_config(get_pending_block_time())));
+
+      // created and funded 10 at a time, each with 1000 EOS of which 500 are swapped to XYZ for it
+      for (uint32_t i = 0; i < load.accounts; i += 10) {
+         signed_transaction trx;
+         const auto         perms = vector<permission_level>{{eos_name, config::active_name}};
+         for (uint32_t j = i; j < std::min(i + 10, load.accounts); ++j) {
+            const auto account = account_of(j);
+            _accounts.push_back(account);
+            trx.actions.emplace_back(perms, newaccount{.creator = eos_name,
+                                                       .name    = account,
+                                                       .owner   = authority(get_public_key(account, "owner")),
+                                                       .active  = authority(get_public_key(account, "active"))});
+            trx.actions.emplace_back(get_action(eos_name, "buyrambytes"_n, perms,
+                                                mvo()("payer", eos_name)("receiver", account)("bytes", 8000)));
+            trx.actions.emplace_back(get_action(eos_name, "delegatebw"_n, perms,
+                                                mvo()("from", eos_name)("receiver", account)(
+                                                   "stake_net_quantity", eos("10.0000"))(
+                                                   "stake_cpu_quantity", eos("10.0000"))("transfer", 0)));
+            trx.actions.emplace_back(get_action("eosio.token"_n, "transfer"_n, perms,
+                                                mvo()("from", eos_name)("to", account)("quantity", eos("500.0000"))(
+                                                   "memo", "")));
+            trx.actions.emplace_back(get_action("eosio.token"_n, "transfer"_n, perms,
+                                                mvo()("from", eos_name)("to", xyz_name)("quantity", eos("500.0000"))(
+                                                   "memo", "swapto:" + account.to_string())));
+         }
+         set_transaction_headers(trx);
+         trx.sign(get_private_key(eos_name, "active"), control->get_chain_id());
+         push_transaction(trx);
+         produce_block();
+      }
+   }
+
+   chain_result run() {
+      std::vector<uint32_t> weights;
+      for (const auto& k : _config.mix)
+         weights.push_back(k.weight);
+      std::discrete_distribution<size_t> pick_kind(weights.begin(), weights.end());
+
+      chain_result result;
+      result.kinds.resize(_config.mix.size());
+
+      const int64_t state_before = state_bytes();
+      const auto    start        = std::chrono::steady_clock::now();
+      for (uint32_t seq = 0; seq < _config.transactions; ++seq) {
+         const size_t kind = pick_kind(_random);
+         auto&        out  = result.kinds[kind];
+         try {
+            const auto s = measure(send(_config.mix[kind].name, seq));
+            out.cpu_us.push_back(s.cpu_us);
+            out.elapsed_us.push_back(s.elapsed_us);
+            out.actions += s.actions;
+            out.ram_delta += s.ram_delta;
+         } catch (const fc::exception&) {
+            ++out.failed;
+         }
+         if (seq % _config.block_size == _config.block_size - 1)
+            produce_block();
+      }
+      produce_block();
+      result.seconds     = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      result.state_bytes = state_bytes() - state_before;
+      return result;
+   }
+
+private:
+   // `loadacctaaaa`, `loadacctaaab`, ...: 12 characters, so that `eosio` needs no name auction.
+   static account_name account_of(uint32_t i) {
+      std::string name = "loadacct";
+      for (uint32_t n = i, j = 0; j < 4; ++j, n /= 26)
+         name.insert(name.begin() + 8, char('a' + n % 26));
+      return account_name(name);
+   }
+
+   int64_t state_bytes() const {
+      const auto* segment = control->db().get_segment_manager();
+      return int64_t(segment->get_size() - segment->get_free_memory());
+   }
+
+   account_name any_account() {
+      return _accounts[std::uniform_int_distribution<size_t>(0, _accounts.size() - 1)(_random)];
+   }
+
+   // One transaction of the given kind from a random account. Amounts follow `seq`, so that two transactions
+   // of the same accounts are not duplicates of each other.
+   transaction_trace_ptr send(const std::string& kind, uint32_t seq) {
+      const auto    from   = any_account();
+      const auto    to     = any_account();
+      const int64_t amount = 1 + seq % 1000;
+      const asset   eos_amount(amount, eos_symbol());
+      const asset   xyz_amount(amount, xyz_symbol());
+
+      if (kind == "transfer")
+         return base_tester::push_action(xyz_name, "transfer"_n, from,
+                                         mvo()("from", from)("to", to)("quantity", xyz_amount)("memo", ""));
+      if (kind == "swap")
+         return base_tester::push_action("eosio.token"_n, "transfer"_n, from,
+                                         mvo()("from", from)("to", xyz_name)("quantity", eos_amount)("memo", ""));
+      if (kind == "swapto")
+         return base_tester::push_action(xyz_name, "swapto"_n, from,
+                                         mvo()("from", from)("to", to)("quantity", eos_amount)("memo", ""));
+      if (kind == "buyrambytes")
+         return base_tester::push_action(xyz_name, "buyrambytes"_n, from,
+                                         mvo()("payer", from)("receiver", to)("bytes", 100 + amount));
+      if (kind == "powerup") {
+         const int64_t frac = powerup_frac / 1000000 + amount;
+         return base_tester::push_action(xyz_name, "powerup"_n, from,
+                                         mvo()("payer", from)("receiver", to)("days", 30)("net_frac", frac)(
+                                            "cpu_frac", frac)("max_payment", xyz("10.0000")));
+      }
+      return base_tester::push_action(xyz_name, "delegatebw"_n, from,
+                                      mvo()("from", from)("receiver", to)("stake_net_quantity", xyz_amount)(
+                                         "stake_cpu_quantity", xyz_amount)("transfer", false));
+   }
+
+   const load_config&        _config;
+   std::mt19937_64           _random;
+   std::vector<account_name> _accounts;
+};
+
+void print(const load_config& config, std::vector<chain_result>& results, double seconds) {
+   uint64_t transactions = 0, actions = 0, failed = 0;
+   int64_t  state_bytes = 0, ram_delta = 0;
+   double   slowest = 0;
+   for (const auto& r : results) {
+      for (const auto& k : r.kinds) {
+         transactions += k.cpu_us.size() + k.failed;
+         failed += k.failed;
+         actions += k.actions;
+         ram_delta += k.ram_delta;
+      }
+      state_bytes += r.state_bytes;
+      slowest = std::max(slowest, r.seconds);
+   }
+
+   auto& out = std::cout;
+   out << "\n== load: " << config.chains << " chains x " << config.accounts << " accounts, " << config.transactions
+       << " transactions each, " << config.block_size << " per block ==\n";
+   out << std::fixed << std::setprecision(1) << "wall " << seconds << " s, " << transactions / seconds
+       << " transactions/s, " << actions / seconds << " actions/s (inline actions and notifications included), "
+       << failed << " failed\n";
+   out << "slowest chain " << slowest << " s, " << config.transactions / slowest << " transactions/s per chain\n";
+
+   out << std::left << std::setw(14) << "kind" << std::right << std::setw(8) << "weight" << std::setw(8) << "sent"
+       << std::setw(8) << "failed" << std::setw(9) << "cpu p50" << std::setw(9) << "cpu p90" << std::setw(9)
+       << "cpu p99" << std::setw(9) << "cpu max" << std::setw(12) << "elapsed p50" << std::setw(12) << "ram B/tx"
+       << "\n";
+   for (size_t i = 0; i < config.mix.size(); ++i) {
+      kind_result merged;
+      for (auto& r : results) {
+         auto& k = r.kinds[i];
+         merged.cpu_us.insert(merged.cpu_us.end(), k.cpu_us.begin(), k.cpu_us.end());
+         merged.elapsed_us.insert(merged.elapsed_us.end(), k.elapsed_us.begin(), k.elapsed_us.end());
+         merged.failed += k.failed;
+         merged.ram_delta += k.ram_delta;
+      }
+      const auto ok = merged.cpu_us.size();
+      out << std::left << std::setw(14) << config.mix[i].name << std::right << std::setw(8) << config.mix[i].weight
+          << std::setw(8) << ok + merged.failed << std::setw(8) << merged.failed << std::setw(9)
+          << percentile(merged.cpu_us, 0.5) << std::setw(9) << percentile(merged.cpu_us, 0.9) << std::setw(9)
+          << percentile(merged.cpu_us, 0.99) << std::setw(9) << percentile(merged.cpu_us, 1.0) << std::setw(12)
+          << percentile(merged.elapsed_us, 0.5) << std::setw(12) << (ok ? merged.ram_delta / int64_t(ok) : 0) << "\n";
+   }
+   out << "state growth: " << ram_delta / int64_t(config.chains) << " B of billed RAM, "
+       << state_bytes / int64_t(config.chains) << " B of chain state per chain\n"
+       << std::defaultfloat << std::flush;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(load_bench);
+
+// ----------------------------------------------------------------------
+// load: `SYSTEM_LOAD_CHAINS` independent chains, one per thread, each with `SYSTEM_LOAD_ACCOUNTS` funded accounts
+// sending `SYSTEM_LOAD_TRANSACTIONS` single-action transactions drawn from `SYSTEM_LOAD_MIX`, e.g.
+// `transfer=40,swap=25,swapto=10,buyrambytes=10,powerup=5,delegatebw=10`, `SYSTEM_LOAD_BLOCK` per block.
+// Reports the throughput of all chains together, the CPU distribution of each kind and the state growth.
+// Failed transactions, e.g. an account that ran out of XYZ, are counted and not retried.
+// ----------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(peak_traffic) try {
+   const load_config config;
+
+   // the world snapshot every chain starts from, built here so that the threads only read it
+   if (!eosio_system_tester::world_snapshot())
+      eosio_system_tester{};
+
+   std::vector<chain_result> results(config.chains);
+   std::latch                ready(config.chains + 1);
+   std::vector<std::thread>  threads;
+   for (uint32_t i = 0; i < config.chains; ++i) {
+      threads.emplace_back([&, i] {
+         auto&                     result = results[i];
+         std::optional<load_chain> chain;
+         try {
+            chain.emplace(config, i);
+         } catch (...) {
+            result.error = std::current_exception();
+         }
+         ready.arrive_and_wait();
+         if (!chain)
+            return;
+         try {
+            result = chain->run();
+         } catch (...) {
+            result.error = std::current_exception();
+         }
+      });
+   }
+
+   ready.arrive_and_wait();
+   const auto start = std::chrono::steady_clock::now();
+   for (auto& t : threads)
+      t.join();
+   const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+   for (const auto& r : results)
+      if (r.error)
+         std::rethrow_exception(r.error);
+   print(config, results, seconds);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bench_harness.hpp"
+
+using namespace eosio_system;
+using namespace eosio_system::bench;
+
+BOOST_AUTO_TEST_SUITE(provision_bench);
+
+// ----------------------------------------------------------------------
+// bench: provisioning N receivers with one forwarding action each, all in a single transaction, against a
+// single `provision` action. Each forwarding action swaps on its own, `provision` swaps once and sweeps once.
+// Divide a row by N for the cost per receiver.
+// ----------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(receivers, bench_tester) try {
+   base_tester::push_action(eos_name, "cfgpowerup"_n, eos_name,
+                            mvo()("args", make_powerup_config(get_pending_block_time())));
+
+   const std::vector<uint32_t> sizes = {1, 10, 50};
+   std::vector<account_name>   receivers;
+   for (uint32_t i = 0; i < sizes.back(); ++i) {
+      receivers.push_back(next_account_name("recv"));
+      create_account(receivers.back());
+   }
+   produce_block();
+
+   // The same provisioning as a forwarding action, and as a `provision` request.
+   struct kind {
+      std::string                         name;
+      std::function<action(account_name)> forward;
+      std::function<mvo(account_name)>    request;
+   };
+   const int64_t           frac  = powerup_frac / 100000;
+   const std::vector<kind> kinds = {
+      {"ram",
+       [&](account_name receiver) {
+          return make_action(xyz_name, "buyram"_n, payer,
+                             mvo()("payer", payer)("receiver", receiver)("quant", xyz("0.0100")));
+       },
+       [&](account_name receiver) {
+          return mvo()("receiver", receiver)("kind", 0)("quantity", xyz("0.0100"))("cpu_quantity", xyz("0.0000"))(
+             "days", 0)("net_frac", 0)("cpu_frac", 0);
+       }},
+      {"stake",
+       [&](account_name receiver) {
+          return make_action(xyz_name, "delegatebw"_n, payer,
+                             mvo()("from", payer)("receiver", receiver)("stake_net_quantity", xyz("0.0001"))(
+                                "stake_cpu_quantity", xyz("0.0001"))("transfer", false));
+       },
+       [&](account_name receiver) {
+          return mvo()("receiver", receiver)("kind", 1)("quantity", xyz("0.0001"))("cpu_quantity", xyz("0.0001"))(
+             "days", 0)("net_frac", 0)("cpu_frac", 0);
+       }},
+      {"powerup",
+       [&](account_name receiver) {
+          return make_action(xyz_name, "powerup"_n, payer,
+                             mvo()("payer", payer)("receiver", receiver)("days", 30)("net_frac", frac)(
+                                "cpu_frac", frac)("max_payment", xyz("10.0000")));
+       },
+       [&](account_name receiver) {
+          return mvo()("receiver", receiver)("kind", 2)("quantity", xyz("10.0000"))("cpu_quantity", xyz("0.0000"))(
+             "days", 30)("net_frac", frac)("cpu_frac", frac);
+       }},
+   };
+
+   report rep("batched provisioning");
+   for (const auto& k : kinds) {
+      for (const uint32_t n : sizes) {
+         const std::string name = k.name + " x" + std::to_string(n);
+
+         const scenario individual = {name, [&] {
+                                         std::vector<action> actions;
+                                         for (uint32_t i = 0; i < n; ++i)
+                                            actions.push_back(k.forward(receivers[i]));
+                                         return push_actions(std::move(actions), {payer});
+                                      }};
+         const scenario batched    = {name, [&] {
+                                         std::vector<mvo> requests;
+                                         for (uint32_t i = 0; i < n; ++i)
+                                            requests.push_back(k.request(receivers[i]));
+                                         return base_tester::push_action(xyz_name, "provision"_n, payer,
+                                                                         mvo()("payer", payer)("requests", requests));
+                                      }};
+         rep.add(name, "individual", run(individual, iterations()));
+         rep.add(name, "batched", run(batched, iterations()));
+      }
+   }
+   rep.print();
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,52 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bench_harness.hpp"
+
+using namespace eosio_system;
+using namespace eosio_system::bench;
+
+BOOST_AUTO_TEST_SUITE(registry_bench);
+
+// ----------------------------------------------------------------------
+// bench: the standard workload with the holder registry off and on (`setregistry`).
+// The registry first gets `SYSTEM_BENCH_HOLDERS` (default 256) holders so that its indices have a realistic size.
+// ----------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(balance_changes, bench_tester) try {
+   uint32_t holders = 256;
+   if (const char* env = std::getenv("SYSTEM_BENCH_HOLDERS"))
+      holders = std::max(1, std::atoi(env));
+
+   auto setregistry = [&](bool enabled) {
+      base_tester::push_action(xyz_name, "setregistry"_n, xyz_name, mvo()("enabled", enabled));
+      produce_block();
+   };
+
+   setregistry(true);
+   std::vector<account_name> owners = {payer, peer, xyz_name};
+   for (uint32_t i = 0; i < holders; ++i) {
+      const auto holder = next_account_name("holder");
+      create_account(holder);
+      base_tester::push_action(xyz_name, "transfer"_n, payer,
+                               mvo()("from", payer)("to", holder)("quantity", xyz("0.0001"))("memo", ""));
+      if (i % 100 == 99)
+         produce_block();
+   }
+   produce_block();
+
+   report rep("holder registry, " + std::to_string(holders) + " holders");
+   for (const auto& s : standard_scenarios()) {
+      for (const bool enabled : {false, true}) {
+         setregistry(enabled);
+         if (enabled) {
+            // catch up with the rows changed while it was off
+            base_tester::push_action(xyz_name, "registeracct"_n, payer, mvo()("owners", owners));
+            produce_block();
+         }
+         rep.add(s.name, enabled ? "registered" : "off", run(s, iterations()));
+      }
+   }
+   rep.print();
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
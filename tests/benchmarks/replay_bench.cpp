@@ -0,0 +1,228 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bench_harness.hpp"
+
+#include <xyz/ship.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <optional>
+#include <set>
+
+using namespace eosio_system;
+using namespace eosio_system::bench;
+
+namespace {
+
+// A recorded transaction, with its own copy of the action data.
+struct replayed_transaction {
+   uint32_t       block_num       = 0;
+   uint32_t       cpu_usage_us    = 0;
+   uint32_t       net_usage_words = 0;
+   int64_t        elapsed_us      = 0;
+   vector<action> actions;
+   std::string    kind; // `<contract>::<action>` of each action, joined by `+`
+};
+
+// The transactions of a state history recording (see tools/include/xyz/ship.hpp) that only call `code` and
+// `eosio.token`, in order, with the symbol of the token `code` issues.
+struct recorded_traffic {
+   std::vector<replayed_transaction> transactions;
+   std::optional<symbol>             token_symbol; // unknown when nothing moved the token
+};
+
+recorded_traffic read_recording(const std::string& path, const std::string& code) {
+   std::ifstream file(path, std::ios::binary);
+   FC_ASSERT(file, "cannot open ${p}", ("p", path));
+   const std::string recording{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+   xyz_tools::decoder_options options;
+   options.code         = xyz_tools::name(code);
+   options.transactions = true;
+
+   recorded_traffic        out;
+   xyz_tools::ship_decoder decoder(options, [&](const xyz_tools::event_batch& batch) {
+      if (!out.token_symbol && !batch.transfers.empty())
+         out.token_symbol = symbol(batch.transfers.front().quantity.sym.value);
+      if (!out.token_symbol && !batch.balances.empty())
+         out.token_symbol = symbol(batch.balances.front().row.balance.sym.value);
+      for (const auto& t : batch.transactions) {
+         replayed_transaction r{t.block_num, t.cpu_usage_us, t.net_usage_words, t.elapsed_us, {}, {}};
+         for (const auto& a : t.actions) {
+            const account_name account(a.account.value);
+            vector<permission_level> auths; // the tester only has keys for `owner` and `active`
+            for (const auto& [actor, permission] : a.authorization)
+               auths.push_back({account_name(actor.value), account_name(permission.value) == config::owner_name
+                                                              ? config::owner_name
+                                                              : config::active_name});
+            r.actions.emplace_back(auths, account, action_name(a.act.value),
+                                   bytes(a.data.begin(), a.data.end()));
+            r.kind += (r.kind.empty() ? "" : "+") + account.to_string() + "::" + action_name(a.act.value).to_string();
+         }
+         out.transactions.push_back(std::move(r));
+      }
+   });
+   xyz_tools::replay_recording(recording, decoder);
+   return out;
+}
+
+template <typename T>
+T percentile(std::vector<T> values, double p) {
+   if (values.empty())
+      return {};
+   std::sort(values.begin(), values.end());
+   return values[std::min(values.size() - 1, size_t(p * values.size()))];
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(replay_bench);
+
+// ----------------------------------------------------------------------
+// bench: replays, in order, the transactions of a state history recording named by `SYSTEM_REPLAY_FILE` that only
+// call the contract (`SYSTEM_REPLAY_CODE`, default `xyz`) and `eosio.token`. The contract is deployed to that
+// account with the token symbol of the recording, so that the actions run as recorded, names in their data included.
+// Every account the actions name is created first, and every signer gets `SYSTEM_REPLAY_FUNDS` EOS (default 10000),
+// half of it swapped to the token; the recorded blocks are kept as blocks. Reports throughput, then per kind of
+// transaction its recorded CPU and execution time against the replayed execution time, both over the transactions
+// that replayed. Does nothing without a recording.
+// ----------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(recording, bench_tester) try {
+   const char* path = std::getenv("SYSTEM_REPLAY_FILE");
+   if (!path) {
+      BOOST_TEST_MESSAGE("replay_bench: set SYSTEM_REPLAY_FILE to a state history recording");
+      return;
+   }
+   const char*        code_env  = std::getenv("SYSTEM_REPLAY_CODE");
+   const char*        funds     = std::getenv("SYSTEM_REPLAY_FUNDS");
+   const account_name code      = code_env ? account_name(code_env) : xyz_name;
+   const auto         traffic   = read_recording(path, code.to_string());
+   const auto&        recorded  = traffic.transactions;
+   const asset        funding   = eos(funds ? funds : "10000.0000");
+
+   // the contract, under the account and with the token of the recording
+   const symbol token_symbol = traffic.token_symbol.value_or(xyz_symbol());
+   if (code == xyz_name) {
+      FC_ASSERT(token_symbol == xyz_symbol(), "the recorded token ${s} is not the tester's, set SYSTEM_REPLAY_CODE",
+                ("s", token_symbol.to_string()));
+   } else {
+      create_account_with_resources(code, config::system_account_name, eos("10000.0000"), false);
+      const auto& wasm = xyz_contracts::system_wasm();
+      set_code(code, metering() ? metered(wasm) : wasm);
+      set_abi(code, xyz_contracts::system_abi().data());
+      int64_t max_supply = 2100000000;
+      for (uint8_t i = 0; i < token_symbol.decimals(); ++i)
+         max_supply *= 10;
+      base_tester::push_action(code, "init"_n, {config::system_account_name, code},
+                               mvo()("maximum_supply", asset(max_supply, token_symbol)));
+      base_tester::push_action(config::system_account_name, "setpriv"_n, config::system_account_name,
+                               mvo()("account", code)("is_priv", 1));
+      produce_block();
+   }
+
+   // the signers, and every other account named by the actions, as far as the ABIs tell
+   std::set<account_name> signers, named;
+   for (const auto& t : recorded) {
+      for (const auto& a : t.actions) {
+         for (const auto& auth : a.authorization)
+            signers.insert(auth.actor);
+         auto& ser = a.account == code ? xyz_abi_ser : token_abi_ser;
+         try {
+            const auto type = ser.get_action_type(a.name);
+            const auto args = ser.binary_to_variant(type, a.data, abi_serializer_max_time).get_object();
+            for (const auto& field : ser.get_struct(type).fields)
+               if (field.type == "name")
+                  named.insert(args[field.name].as<account_name>());
+         } catch (const fc::exception&) {
+         }
+      }
+   }
+   named.insert(signers.begin(), signers.end());
+
+   uint32_t created = 0;
+   for (const auto& a : named) {
+      if (control->db().find<account_object, by_name>(a))
+         continue;
+      create_account_with_resources(a, config::system_account_name);
+      if (++created % 50 == 0)
+         produce_block();
+   }
+   for (const auto& s : signers) {
+      if (s == code || s == eos_name || s == "eosio.token"_n)
+         continue;
+      transfer(eos_name, s, funding);
+      transfer(s, code, asset(funding.get_amount() / 2, funding.get_symbol()), s);
+      produce_block();
+   }
+   produce_block();
+
+   struct kind_result {
+      uint32_t             count = 0, failed = 0;
+      std::vector<int64_t> recorded_cpu_us, recorded_elapsed_us, replayed_elapsed_us;
+   };
+   std::map<std::string, kind_result> kinds;
+   uint64_t                           transactions = 0, actions = 0;
+   std::chrono::steady_clock::duration pushing{};
+
+   uint32_t block = recorded.empty() ? 0 : recorded.front().block_num;
+   for (size_t i = 0; i < recorded.size(); ++i) {
+      const auto& t = recorded[i];
+      if (t.block_num != block) {
+         produce_block();
+         block = t.block_num;
+      }
+
+      signed_transaction trx;
+      trx.actions = t.actions;
+      set_transaction_headers(trx, 6 + i % 3000); // distinct ids for identical transactions of a recording
+      std::set<permission_level> keys;
+      for (const auto& a : trx.actions)
+         keys.insert(a.authorization.begin(), a.authorization.end());
+      for (const auto& k : keys)
+         trx.sign(get_private_key(k.actor, k.permission.to_string()), control->get_chain_id());
+
+      auto& kind = kinds[t.kind];
+      ++kind.count;
+      try {
+         const auto start = std::chrono::steady_clock::now();
+         const auto trace = push_transaction(trx);
+         pushing += std::chrono::steady_clock::now() - start;
+         kind.recorded_cpu_us.push_back(t.cpu_usage_us);
+         kind.recorded_elapsed_us.push_back(t.elapsed_us);
+         kind.replayed_elapsed_us.push_back(trace->elapsed.count());
+         ++transactions;
+         actions += trace->action_traces.size();
+      } catch (const fc::exception&) {
+         ++kind.failed;
+      }
+   }
+   produce_block();
+
+   const double seconds = std::chrono::duration<double>(pushing).count();
+   std::cout << "\n== replay of " << path << " ==\n"
+             << recorded.size() << " transactions recorded, " << transactions << " replayed in " << std::fixed
+             << std::setprecision(2) << seconds << " s: " << std::setprecision(0)
+             << (seconds > 0 ? transactions / seconds : 0) << " transactions/s, "
+             << (seconds > 0 ? actions / seconds : 0) << " actions/s\n"
+             << std::defaultfloat;
+
+   std::cout << std::left << std::setw(40) << "transaction" << std::right << std::setw(8) << "count" << std::setw(8)
+             << "failed" << std::setw(14) << "rec. cpu us" << std::setw(16) << "rec. elapsed" << std::setw(16)
+             << "replay elapsed" << std::setw(10) << "delta" << "\n";
+   for (const auto& [name, k] : kinds) {
+      const auto recorded_elapsed = percentile(k.recorded_elapsed_us, 0.5);
+      const auto replayed_elapsed = percentile(k.replayed_elapsed_us, 0.5);
+      std::ostringstream delta;
+      if (recorded_elapsed > 0 && !k.replayed_elapsed_us.empty())
+         delta << std::showpos << std::fixed << std::setprecision(1)
+               << 100.0 * (replayed_elapsed - recorded_elapsed) / recorded_elapsed << "%";
+      std::cout << std::left << std::setw(40) << name << std::right << std::setw(8) << k.count << std::setw(8)
+                << k.failed << std::setw(14) << percentile(k.recorded_cpu_us, 0.5) << std::setw(16) << recorded_elapsed
+                << std::setw(16) << replayed_elapsed << std::setw(10) << delta.str() << "\n";
+   }
+   std::cout << std::flush;
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bench_harness.hpp"
+
+using namespace eosio_system;
+using namespace eosio_system::bench;
+
+namespace {
+
+// The WASM runtimes this build of the tester can run contracts with.
+std::vector<std::pair<std::string, wasm_interface::vm_type>> available_runtimes() {
+   std::vector<std::pair<std::string, wasm_interface::vm_type>> runtimes = {
+      {"interpreter", wasm_interface::vm_type::eos_vm}};
+#ifdef EOSIO_EOS_VM_JIT_RUNTIME_ENABLED
+   runtimes.emplace_back("jit", wasm_interface::vm_type::eos_vm_jit);
+#endif
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+   runtimes.emplace_back("oc", wasm_interface::vm_type::eos_vm_oc);
+#endif
+   return runtimes;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(runtime_bench);
+
+// ----------------------------------------------------------------------
+// bench: the standard scenarios under every runtime available, each runtime starting from the same state with an
+// empty code cache. The first XYZ transfer of each runtime pays for instantiating (and for OC, compiling) the
+// contract; it is reported against the transfer that follows it.
+// ----------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(runtimes, bench_tester) try {
+   const auto state     = snapshot_state();
+   const auto scenarios = standard_scenarios();
+   auto       transfer  = [&] {
+      return base_tester::push_action(xyz_name, "transfer"_n, payer,
+                                      mvo()("from", payer)("to", peer)("quantity", xyz("0.0001"))("memo", ""));
+   };
+
+   struct first_call {
+      std::string runtime;
+      sample      first;
+      sample      warm;
+   };
+   std::vector<first_call> first_calls;
+   report                  rep("runtimes");
+   std::map<std::string, std::vector<std::pair<std::string, std::vector<sample>>>> by_scenario;
+
+   for (const auto& [runtime, vm] : available_runtimes()) {
+      cfg.wasm_runtime = vm;
+      start_from(state);
+
+      first_call call{runtime, measure(transfer()), {}};
+      produce_block();
+      call.warm = measure(transfer());
+      produce_block();
+      first_calls.push_back(call);
+
+      for (const auto& s : scenarios)
+         by_scenario[s.name].emplace_back(runtime, run(s, iterations()));
+   }
+
+   // side by side: the runtimes of a scenario on consecutive rows
+   for (const auto& s : scenarios)
+      for (const auto& [runtime, samples] : by_scenario[s.name])
+         rep.add(s.name, runtime, samples);
+   rep.print();
+
+   std::cout << "\n== first call of the contract ==\n"
+             << std::left << std::setw(14) << "runtime" << std::right << std::setw(10) << "cpu us" << std::setw(12)
+             << "elapsed us" << std::setw(14) << "warm cpu us" << std::setw(16) << "warm elapsed us"
+             << std::setw(16) << "instantiate us" << "\n";
+   for (const auto& call : first_calls)
+      std::cout << std::left << std::setw(14) << call.runtime << std::right << std::setw(10) << call.first.cpu_us
+                << std::setw(12) << call.first.elapsed_us << std::setw(14) << call.warm.cpu_us << std::setw(16)
+                << call.warm.elapsed_us << std::setw(16) << call.first.elapsed_us - call.warm.elapsed_us << "\n";
+   std::cout << std::flush;
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
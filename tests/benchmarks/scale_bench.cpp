@@ -0,0 +1,146 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bench_harness.hpp"
+
+#include <eosio/chain/contract_table_objects.hpp>
+
+using namespace eosio_system;
+using namespace eosio_system::bench;
+
+namespace {
+
+// Holder counts to measure at, `SYSTEM_SCALE_HOLDERS` in the environment overrides the default, e.g. `0,5000000`.
+std::vector<uint64_t> scale_steps() {
+   const char*           env = std::getenv("SYSTEM_SCALE_HOLDERS");
+   std::istringstream    in(env ? env : "10000,100000,1000000");
+   std::vector<uint64_t> steps;
+   for (std::string entry; std::getline(in, entry, ',');)
+      steps.push_back(std::stoull(entry));
+   FC_ASSERT(!steps.empty() && std::is_sorted(steps.begin(), steps.end()),
+             "SYSTEM_SCALE_HOLDERS is an increasing list of holder counts");
+   return steps;
+}
+
+// `blocked` rows written next to a number of holders.
+uint64_t blocked_for(uint64_t holders) {
+   return holders / 200;
+}
+
+// The `index`-th name of a series, e.g. `haaaaaaab`.
+account_name nth_name(char prefix, uint64_t index) {
+   std::string name(9, 'a');
+   name[0] = prefix;
+   for (int i = 8; i > 0; --i, index /= 26)
+      name[i] = char('a' + index % 26);
+   return account_name(name);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(scale_bench);
+
+// ----------------------------------------------------------------------
+// bench: `transfer`, `swapto` and `open` + `close` as the contract's tables grow to `SYSTEM_SCALE_HOLDERS` holders,
+// with one `blocked` row per 200 holders. The rows are written straight into the chain state, as loading a
+// snapshot of a large deployment would, so the holders are not chain accounts and are charged no RAM; their
+// balances are not part of the supply. Needs about 1 KiB of chain state per holder.
+// ----------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(holders, bench_tester) try {
+   static constexpr account_name closer = "scalecloser"_n;
+   create_accounts_with_resources({closer});
+
+   const auto steps = scale_steps();
+   cfg.state_size   = std::max<uint64_t>(cfg.state_size, (steps.back() + (1 << 20)) * 1024);
+   start_from(snapshot_state());
+
+   const uint64_t accounts_key = xyz_symbol().to_symbol_code().value;
+   auto&          db           = control->mutable_db();
+
+   auto state_bytes = [&] {
+      const auto* segment = db.get_segment_manager();
+      return int64_t(segment->get_size() - segment->get_free_memory());
+   };
+
+   // A table of the contract, created when missing, and one more row in it.
+   auto add_row = [&](account_name scope, account_name table, uint64_t primary_key, const std::vector<char>& data) {
+      const auto* t = db.find<table_id_object, by_code_scope_table>(boost::make_tuple(xyz_name, scope, table));
+      if (!t) {
+         t = &db.create<table_id_object>([&](table_id_object& o) {
+            o.code  = xyz_name;
+            o.scope = scope;
+            o.table = table;
+            o.payer = xyz_name;
+         });
+      }
+      db.modify(*t, [](table_id_object& o) { ++o.count; });
+      db.create<key_value_object>([&](key_value_object& o) {
+         o.t_id        = t->id;
+         o.primary_key = primary_key;
+         o.payer       = xyz_name;
+         o.value.assign(data.data(), data.size());
+      });
+   };
+
+   const std::vector<scenario> scenarios = {
+      {"transfer", [&] {
+          return base_tester::push_action(xyz_name, "transfer"_n, payer,
+                                          mvo()("from", payer)("to", peer)("quantity", xyz("0.0001"))("memo", ""));
+       }},
+      {"swapto", [&] {
+          return base_tester::push_action(xyz_name, "swapto"_n, payer,
+                                          mvo()("from", payer)("to", peer)("quantity", eos("0.0001"))("memo", ""));
+       }},
+      {"open + close", [&] {
+          return push_actions({make_action(xyz_name, "open"_n, payer,
+                                           mvo()("owner", closer)("symbol", xyz_symbol())("ram_payer", payer)),
+                               make_action(xyz_name, "close"_n, closer,
+                                           mvo()("owner", closer)("symbol", xyz_symbol()))},
+                              {payer, closer});
+       }},
+   };
+
+   struct size_row {
+      uint64_t holders;
+      uint64_t blocked;
+      int64_t  state_bytes;
+   };
+   std::vector<size_row> sizes;
+   report                rep("scale");
+   std::map<std::string, std::vector<std::pair<std::string, std::vector<sample>>>> by_scenario;
+
+   const int64_t base_state = state_bytes();
+   uint64_t      holders = 0, blocked = 0;
+   for (const uint64_t step : steps) {
+      produce_block();
+      control->abort_block();
+      for (; holders < step; ++holders)
+         add_row(nth_name('h', holders), "accounts"_n, accounts_key,
+                 xyz_codec::pack(xyz_codec::account{asset(1 + holders % 1000000, xyz_symbol()), false}));
+      for (; blocked < blocked_for(step); ++blocked)
+         add_row(xyz_name, "blocked"_n, nth_name('b', blocked).to_uint64_t(),
+                 xyz_codec::pack(xyz_codec::blocked_recipient{nth_name('b', blocked)}));
+      produce_block();
+      sizes.push_back({holders, blocked, state_bytes() - base_state});
+
+      const auto variant = std::to_string(holders) + " h";
+      for (const auto& s : scenarios)
+         by_scenario[s.name].emplace_back(variant, run(s, iterations()));
+   }
+
+   for (const auto& s : scenarios)
+      for (const auto& [variant, samples] : by_scenario[s.name])
+         rep.add(s.name, variant, samples);
+   rep.print();
+
+   std::cout << "\n== chain state ==\n"
+             << std::right << std::setw(10) << "holders" << std::setw(10) << "blocked" << std::setw(12) << "state MiB"
+             << std::setw(14) << "B per holder" << "\n";
+   for (const auto& r : sizes)
+      std::cout << std::setw(10) << r.holders << std::setw(10) << r.blocked << std::setw(12)
+                << r.state_bytes / (1024 * 1024) << std::setw(14)
+                << (r.holders ? r.state_bytes / int64_t(r.holders) : 0) << "\n";
+   std::cout << std::flush;
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,139 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bench_harness.hpp"
+
+using namespace eosio_system;
+using namespace eosio_system::bench;
+
+BOOST_AUTO_TEST_SUITE(wrapper_bench);
+
+// ----------------------------------------------------------------------
+// bench: each forwarded operation done directly on `eosio` with EOS, the baseline, and through the wrapper
+// with XYZ. Before measuring, both ways are done once for two fresh receivers and must leave them the same
+// EOS outcome. The report is followed by the overhead of each forwarder, the most expensive first.
+// ----------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(forwarders, bench_tester) try {
+   static constexpr account_name direct_receiver  = "directrecv"_n;
+   static constexpr account_name wrapper_receiver = "wrapperrecv"_n;
+   create_accounts_with_resources({direct_receiver, wrapper_receiver});
+   base_tester::push_action(eos_name, "cfgpowerup"_n, eos_name,
+                            mvo()("args", make_powerup_config(get_pending_block_time())));
+   produce_block();
+
+   // What an operation leaves to its receiver, as EOS amounts and resource limits.
+   auto resources = [&](account_name receiver, bool) {
+      int64_t ram_bytes = 0, net = 0, cpu = 0;
+      control->get_resource_limits_manager().get_account_limits(receiver, ram_bytes, net, cpu);
+      return std::vector<int64_t>{ram_bytes, net, cpu};
+   };
+   auto ram_market = [&](account_name, bool) {
+      return std::vector<int64_t>{get_balance("eosio.token"_n, "eosio.ram"_n, eos_symbol()).get_amount(),
+                                  get_balance("eosio.token"_n, "eosio.ramfee"_n, eos_symbol()).get_amount()};
+   };
+
+   // An operation with the same arguments both ways, the wrapper taking XYZ where `eosio` takes EOS.
+   struct operation {
+      std::string                                             name;
+      std::function<action(account_name, bool)>               make;
+      std::function<std::vector<int64_t>(account_name, bool)> outcome;
+   };
+   auto token = [](bool wrapper) { return wrapper ? xyz_name : "eosio.token"_n; };
+   auto code  = [](bool wrapper) { return wrapper ? xyz_name : eos_name; };
+   auto coin  = [](bool wrapper, const char* amount) { return wrapper ? xyz(amount) : eos(amount); };
+
+   const int64_t                frac       = powerup_frac / 100000;
+   const std::vector<operation> operations = {
+      {"transfer",
+       [&](account_name receiver, bool wrapper) {
+          return make_action(token(wrapper), "transfer"_n, payer,
+                             mvo()("from", payer)("to", receiver)("quantity", coin(wrapper, "0.0001"))("memo", ""));
+       },
+       [&](account_name receiver, bool wrapper) {
+          return std::vector<int64_t>{wrapper ? get_xyz_balance(receiver).get_amount()
+                                              : get_eos_balance(receiver).get_amount()};
+       }},
+      {"buyram",
+       [&](account_name receiver, bool wrapper) {
+          return make_action(code(wrapper), "buyram"_n, payer,
+                             mvo()("payer", payer)("receiver", receiver)("quant", coin(wrapper, "0.0100")));
+       },
+       ram_market},
+      {"buyrambytes",
+       [&](account_name receiver, bool wrapper) {
+          return make_action(code(wrapper), "buyrambytes"_n, payer,
+                             mvo()("payer", payer)("receiver", receiver)("bytes", 100));
+       },
+       resources},
+      {"delegatebw",
+       [&](account_name receiver, bool wrapper) {
+          return make_action(code(wrapper), "delegatebw"_n, payer,
+                             mvo()("from", payer)("receiver", receiver)("stake_net_quantity", coin(wrapper, "0.0001"))(
+                                "stake_cpu_quantity", coin(wrapper, "0.0001"))("transfer", false));
+       },
+       resources},
+      {"powerup",
+       [&](account_name receiver, bool wrapper) {
+          return make_action(code(wrapper), "powerup"_n, payer,
+                             mvo()("payer", payer)("receiver", receiver)("days", 30)("net_frac", frac)(
+                                "cpu_frac", frac)("max_payment", coin(wrapper, "10.0000")));
+       },
+       resources},
+      {"voteproducer",
+       [&](account_name, bool wrapper) {
+          return make_action(code(wrapper), "voteproducer"_n, payer,
+                             mvo()("voter", payer)("proxy", name())("producers", std::vector<name>{}));
+       },
+       [&](account_name, bool) {
+          return std::vector<int64_t>{get_voter_info(payer)["staked"].as_int64()};
+       }},
+   };
+
+   // The change of the outcome of `op` when done once for the receiver of its way.
+   auto outcome_of = [&](const operation& op, bool wrapper) {
+      const auto receiver = wrapper ? wrapper_receiver : direct_receiver;
+      auto       before   = op.outcome(receiver, wrapper);
+      push_actions({op.make(receiver, wrapper)}, {payer});
+      produce_block();
+      auto after = op.outcome(receiver, wrapper);
+      for (size_t i = 0; i < after.size(); ++i)
+         after[i] -= before[i];
+      return after;
+   };
+
+   report                                      rep("wrapper vs direct");
+   std::vector<std::pair<std::string, sample>> overhead;
+   for (const auto& op : operations) {
+      const auto direct  = outcome_of(op, false);
+      const auto wrapper = outcome_of(op, true);
+      BOOST_REQUIRE_MESSAGE(direct == wrapper, op.name << ": the wrapper leaves a different outcome than eosio");
+
+      std::vector<sample> runs[2];
+      for (const bool w : {false, true}) {
+         const scenario s = {op.name, [&] { return push_actions({op.make(peer, w)}, {payer}); }};
+         runs[w]          = run(s, iterations());
+         rep.add(op.name, w ? "wrapper" : "direct", runs[w]);
+      }
+      const auto d = summarize(runs[0]), w = summarize(runs[1]);
+      overhead.push_back({op.name, sample{.cpu_us     = w.cpu_us - d.cpu_us,
+                                          .elapsed_us = w.elapsed_us - d.elapsed_us,
+                                          .net_bytes  = w.net_bytes - d.net_bytes,
+                                          .ram_delta  = w.ram_delta - d.ram_delta,
+                                          .actions    = w.actions - d.actions}});
+   }
+   rep.print();
+
+   std::sort(overhead.begin(), overhead.end(),
+             [](const auto& a, const auto& b) { return a.second.cpu_us > b.second.cpu_us; });
+   std::cout << "\n== overhead of the wrapper ==\n"
+             << std::left << std::setw(22) << "operation" << std::right << std::setw(10) << "cpu us" << std::setw(12)
+             << "elapsed us" << std::setw(10) << "net B" << std::setw(10) << "ram B" << std::setw(9) << "actions"
+             << "\n";
+   for (const auto& [op_name, o] : overhead)
+      std::cout << std::left << std::setw(22) << op_name << std::right << std::setw(10) << o.cpu_us << std::setw(12)
+                << o.elapsed_us << std::setw(10) << int64_t(o.net_bytes) << std::setw(10) << o.ram_delta
+                << std::setw(9) << int32_t(o.actions) << "\n";
+   std::cout << std::flush;
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,13 +2,23 @@
 
 #include "contracts.hpp"
 #include "test_symbol.hpp"
+#include "xyz_codec.hpp"
+#ifdef SYSTEM_BUDGET_FILE
+#include "resource_budget.hpp"
+#endif
 #include <eosio/chain/abi_serializer.hpp>
 #include <eosio/chain/resource_limits.hpp>
+#include <eosio/chain/snapshot.hpp>
 #include <eosio/testing/tester.hpp>
 
 #include <fc/variant_object.hpp>
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
+#include <map>
 #include <ranges>
+#include <sstream>
+#include <unistd.h>
 
 
 using namespace eosio::chain;
@@ -17,9 +27,74 @@ using namespace fc;
 
 using mvo = fc::mutable_variant_object;
 
+inline constexpr int64_t powerup_frac  = 1'000'000'000'000'000ll; // 1.0 = 10^15
+inline constexpr int64_t stake_weight = 100'000'000'0000ll; // 10^12
+
+struct powerup_config_resource {
+   std::optional<int64_t>        current_weight_ratio = {};
+   std::optional<int64_t>        target_weight_ratio  = {};
+   std::optional<int64_t>        assumed_stake_weight = {};
+   std::optional<time_point_sec> target_timestamp     = {};
+   std::optional<double>         exponent             = {};
+   std::optional<uint32_t>       decay_secs           = {};
+   std::optional<asset>          min_price            = {};
+   std::optional<asset>          max_price            = {};
+};
+FC_REFLECT(powerup_config_resource,                                                             //
+           (current_weight_ratio)(target_weight_ratio)(assumed_stake_weight)(target_timestamp) //
+           (exponent)(decay_secs)(min_price)(max_price))
+
+struct powerup_config {
+   powerup_config_resource net             = {};
+   powerup_config_resource cpu             = {};
+   std::optional<uint32_t> powerup_days    = {};
+   std::optional<asset>    min_powerup_fee = {};
+};
+FC_REFLECT(powerup_config, (net)(cpu)(powerup_days)(min_powerup_fee))
+
+// A powerup market where a quarter of each resource costs 62500 EOS for 30 days, and the minimum fee is 1 EOS.
+inline powerup_config make_powerup_config(time_point now) {
+   powerup_config config;
+
+   config.net.current_weight_ratio = powerup_frac / 4;
+   config.net.target_weight_ratio  = powerup_frac / 100;
+   config.net.assumed_stake_weight = stake_weight;
+   config.net.target_timestamp     = time_point_sec(now + fc::days(100));
+   config.net.exponent             = 2;
+   config.net.decay_secs           = fc::days(1).to_seconds();
+   config.net.min_price            = asset::from_string("0.0000 EOS");
+   config.net.max_price            = asset::from_string("1000000.0000 EOS");
+
+   config.cpu.current_weight_ratio = powerup_frac / 4;
+   config.cpu.target_weight_ratio  = powerup_frac / 100;
+   config.cpu.assumed_stake_weight = stake_weight;
+   config.cpu.target_timestamp     = time_point_sec(now + fc::days(100));
+   config.cpu.exponent             = 2;
+   config.cpu.decay_secs           = fc::days(1).to_seconds();
+   config.cpu.min_price            = asset::from_string("0.0000 EOS");
+   config.cpu.max_price            = asset::from_string("1000000.0000 EOS");
+
+   config.powerup_days    = 30;
+   config.min_powerup_fee = asset::from_string("1.0000 EOS");
+   return config;
+}
+
 namespace eosio_system {
 
-class eosio_system_tester : public validating_tester {
+// The chain under the fixture. By default it is a `validating_tester`, which replays every block on a second node.
+// With SYSTEM_TESTER_NON_VALIDATING (always for the benchmarks) blocks are executed once, and the world built by
+// the fixture's constructor is kept as a snapshot that every later fixture starts from, see `world_snapshot`.
+// The validating fixture can't do the same: `validating_tester` creates its second node from genesis in its own
+// constructor and has no way to start it from a snapshot, and a second node left at genesis rejects the first block
+// it is sent. Bringing it to the world by pushing it the world's blocks executes them as `build_world` does, so
+// every validating test case still pays for building the world.
+#ifdef SYSTEM_TESTER_NON_VALIDATING
+using system_tester_base = tester;
+#else
+using system_tester_base = validating_tester;
+#endif
+
+class eosio_system_tester : public system_tester_base {
 public:
    // -----------------
    // static utilities
@@ -35,7 +110,13 @@ public:
    static symbol eos_symbol() { return symbol{CORE_SYM}; }
 
    ~eosio_system_tester() {
+#ifdef SYSTEM_BUDGET_FILE
+      if (budget_recorder)
+         budget_recorder->check_test_case();
+#endif
+#ifndef SYSTEM_TESTER_NON_VALIDATING
       skip_validate = true;
+#endif
    }
 
    // -----------------
@@ -88,131 +169,139 @@ public:
       // -----------------
       // supported actions
       // -----------------
-      action_result transfer(name from, name to, const asset& amount) { // both xyz and system contracts
+      action_result transfer(name from, name to, const asset& amount, const std::string& memo = "") { // both xyz and system contracts
          auto act = "transfer"_n;
-         auto params =
-            serialize(_tester.token_abi_ser, act, mvo()("from", from)("to", to)("quantity", amount)("memo", ""));
+         auto params = xyz_codec::pack(xyz_codec::transfer{from, to, amount, memo});
          return push_action(from, act, std::move(params), {from});
       }
 
-      action_result swapto(name from, name to, const asset& amount) { // this action available only on xyz contract
+      action_result swapto(name from, name to, const asset& amount, const std::string& memo = "") { // this action available only on xyz contract
          auto act = "swapto"_n;
-         auto params =
-            serialize(_tester.xyz_abi_ser, act, mvo()("from", from)("to", to)("quantity", amount)("memo", ""));
+         auto params = xyz_codec::pack(xyz_codec::swapto{from, to, amount, memo});
          return push_action(_contract_name, act, std::move(params), {from});
       }
 
+      action_result open(name owner, const symbol& sym, name ram_payer) { // this action available only on xyz contract
+         auto act    = "open"_n;
+         auto params = xyz_codec::pack(xyz_codec::open{owner, sym, ram_payer});
+         return push_action(_contract_name, act, std::move(params), {ram_payer});
+      }
+
+      action_result close(name owner, const symbol& sym) { // this action available only on xyz contract
+         auto act    = "close"_n;
+         auto params = xyz_codec::pack(xyz_codec::close{owner, sym});
+         return push_action(_contract_name, act, std::move(params), {owner});
+      }
+
       action_result bidname(name bidder, name newname, const asset& bid) {
          auto act    = "bidname"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("bidder", bidder)("newname", newname)("bid", bid));
+         auto params = xyz_codec::pack(xyz_codec::bidname{bidder, newname, bid});
          return push_action(_contract_name, act, std::move(params), {bidder});
       }
 
       action_result bidrefund(name bidder, name newname) {
          auto act    = "bidrefund"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("bidder", bidder)("newname", newname));
+         auto params = xyz_codec::pack(xyz_codec::bidrefund{bidder, newname});
          return push_action(_contract_name, act, std::move(params), {bidder});
       }
 
       action_result buyram(name payer, name receiver, const asset& quant) {
          auto act    = "buyram"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("payer", payer)("receiver", receiver)("quant", quant));
+         auto params = xyz_codec::pack(xyz_codec::buyram{payer, receiver, quant});
          return push_action(_contract_name, act, std::move(params), {payer});
       }
 
       action_result buyramburn(name payer, const asset& quantity) {
          auto act    = "buyramburn"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("payer", payer)("quantity", quantity)("memo", ""));
+         auto params = xyz_codec::pack(xyz_codec::buyramburn{payer, quantity, ""});
          return push_action(_contract_name, act, std::move(params), {payer});
       }
 
       action_result buyrambytes(name payer, name receiver, uint32_t bytes) {
          auto act    = "buyrambytes"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("payer", payer)("receiver", receiver)("bytes", bytes));
+         auto params = xyz_codec::pack(xyz_codec::buyrambytes{payer, receiver, bytes});
          return push_action(_contract_name, act, std::move(params), {payer});
       }
 
       action_result buyramself(name payer, const asset& quant) {
          auto act    = "buyramself"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("payer", payer)("quant", quant));
+         auto params = xyz_codec::pack(xyz_codec::buyramself{payer, quant});
          return push_action(_contract_name, act, std::move(params), {payer});
       }
 
       action_result ramburn(name owner, int64_t bytes) {
          auto act    = "ramburn"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("owner", owner)("bytes", bytes)("memo", ""));
+         auto params = xyz_codec::pack(xyz_codec::ramburn{owner, bytes, ""});
          return push_action(_contract_name, act, std::move(params), {owner});
       }
 
       action_result ramtransfer(name from, name to, int64_t bytes) {
          auto act    = "ramtransfer"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("from", from)("to", to)("bytes", bytes)("memo", ""));
+         auto params = xyz_codec::pack(xyz_codec::ramtransfer{from, to, bytes, ""});
          return push_action(_contract_name, act, std::move(params), {from});
       }
 
       action_result sellram(name account, int64_t bytes) {
          auto act    = "sellram"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("account", account)("bytes", bytes));
+         auto params = xyz_codec::pack(xyz_codec::sellram{account, bytes});
          return push_action(_contract_name, act, std::move(params), {account});
       }
 
       action_result deposit(name owner, const asset& amount) {
          auto act    = "deposit"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("owner", owner)("amount", amount));
+         auto params = xyz_codec::pack(xyz_codec::owner_amount{owner, amount});
          return push_action(_contract_name, act, std::move(params), {owner});
       }
 
       action_result buyrex(name from, const asset& amount) {
          auto act    = "buyrex"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("from", from)("amount", amount));
+         auto params = xyz_codec::pack(xyz_codec::from_amount{from, amount});
          return push_action(_contract_name, act, std::move(params), {from});
       }
 
       action_result sellrex(name from, const asset& rex) {
          auto act    = "sellrex"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("from", from)("rex", rex));
+         auto params = xyz_codec::pack(xyz_codec::sellrex{from, rex});
          return push_action(_contract_name, act, std::move(params), {from});
       }
 
       action_result mvtosavings(name owner, const asset& rex) {
          auto act    = "mvtosavings"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("owner", owner)("rex", rex));
+         auto params = xyz_codec::pack(xyz_codec::owner_rex{owner, rex});
          return push_action(_contract_name, act, std::move(params), {owner});
       }
 
       action_result mvfrsavings(name owner, const asset& rex) {
          auto act    = "mvfrsavings"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("owner", owner)("rex", rex));
+         auto params = xyz_codec::pack(xyz_codec::owner_rex{owner, rex});
          return push_action(_contract_name, act, std::move(params), {owner});
       }
 
       action_result withdraw(name owner, const asset& amount) {
          auto act    = "withdraw"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("owner", owner)("amount", amount));
+         auto params = xyz_codec::pack(xyz_codec::owner_amount{owner, amount});
          return push_action(_contract_name, act, std::move(params), {owner});
       }
 
       action_result delegatebw(name from, name receiver, const asset& stake_net_quantity,
                                const asset& stake_cpu_quantity, bool transfer) {
          auto act    = "delegatebw"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act,
-                                 mvo()("from", from)("receiver", receiver)("stake_net_quantity", stake_net_quantity)(
-                                    "stake_cpu_quantity", stake_cpu_quantity)("transfer", transfer));
+         auto params = xyz_codec::pack(
+            xyz_codec::delegatebw{from, receiver, stake_net_quantity, stake_cpu_quantity, transfer});
          return push_action(_contract_name, act, std::move(params), {from});
       }
 
       action_result undelegatebw(name from, name receiver, const asset& unstake_net_quantity,
                                  const asset& unstake_cpu_quantity) {
          auto act    = "undelegatebw"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act,
-                                 mvo()("from", from)("receiver", receiver)("unstake_net_quantity", unstake_net_quantity)(
-                                    "unstake_cpu_quantity", unstake_cpu_quantity));
+         auto params =
+            xyz_codec::pack(xyz_codec::undelegatebw{from, receiver, unstake_net_quantity, unstake_cpu_quantity});
          return push_action(_contract_name, act, std::move(params), {from});
       }
 
       action_result refund(name owner) {
          auto act    = "refund"_n;
-         auto params = serialize(_tester.xyz_abi_ser, act, mvo()("owner", owner));
+         auto params = xyz_codec::pack(xyz_codec::refund{owner});
          return push_action(_contract_name, act, std::move(params), {owner});
       }
 
@@ -227,20 +316,35 @@ public:
       vector<char> data = get_row_by_account(xyz_name, account, "accounts"_n, account_name(xyz_symbol().to_symbol_code().value));
       if (data.empty())
          return -1;
-      return xyz_abi_ser.binary_to_variant("account", data, abi_serializer_max_time)["released"].as<int8_t>();
+      return xyz_codec::unpack_row<xyz_codec::account>(data).released;
    }
 
    asset get_balance(name code, account_name act, symbol token) const {
       vector<char> data = get_row_by_account(code, act, "accounts"_n, account_name(token.to_symbol_code().value));
       if (data.empty())
          return asset(0, token);
-      return token_abi_ser.binary_to_variant("account", data, abi_serializer_max_time)["balance"].as<asset>();
+      return xyz_codec::unpack_row<xyz_codec::token_account>(data).balance;
    }
 
    asset get_eos_balance(account_name act) const { return get_balance("eosio.token"_n, act, eos_symbol()); }
 
    asset get_xyz_balance(account_name act) const { return get_balance(xyz_name, act, xyz_symbol()); }
 
+   xyz_codec::currency_stats get_xyz_stats() const {
+      const auto   code = xyz_symbol().to_symbol_code().value;
+      vector<char> data = get_row_by_account(xyz_name, account_name(code), "stat"_n, account_name(code));
+      return data.empty() ? xyz_codec::currency_stats{} : xyz_codec::unpack_row<xyz_codec::currency_stats>(data);
+   }
+
+   xyz_codec::config get_xyz_config() const {
+      vector<char> data = get_row_by_account(xyz_name, xyz_name, "config"_n, "config"_n);
+      return data.empty() ? xyz_codec::config{} : xyz_codec::unpack_row<xyz_codec::config>(data);
+   }
+
+   bool is_swapto_blocked(account_name account) const {
+      return !get_row_by_account(xyz_name, xyz_name, "blocked"_n, account).empty();
+   }
+
    bool check_balances(account_name act, const vector<asset>& assets) const {
       for (const auto& a : assets) {
          if (a.get_symbol() == xyz_symbol()) {
@@ -266,6 +370,32 @@ public:
 
    int64_t get_ram_bytes(account_name act) const { return get_total_stake(act)["ram_bytes"].as_int64(); }
 
+   // ----------------------------------------------------------------------
+   // instrumented contract (see contracts/include/system/instrument.hpp)
+   // ----------------------------------------------------------------------
+   void use_instrumented_contract() {
+      set_code(xyz_name, xyz_contracts::system_instrumented_wasm());
+      produce_block();
+   }
+
+   // Sums the `allocs:<label>:<count>` lines printed by the xyz contract across a transaction's action traces.
+   static std::map<std::string, uint32_t> get_alloc_counts(const transaction_trace_ptr& trace) {
+      std::map<std::string, uint32_t> counts;
+      for (const auto& at : trace->action_traces) {
+         if (at.receiver != xyz_name)
+            continue;
+         std::istringstream console(at.console);
+         std::string        line;
+         while (std::getline(console, line)) {
+            if (!line.starts_with("allocs:"))
+               continue;
+            auto sep = line.rfind(':');
+            counts[line.substr(7, sep - 7)] += std::stoul(line.substr(sep + 1));
+         }
+      }
+      return counts;
+   }
+
    // -----------------
    // members
    // -----------------
@@ -287,12 +417,41 @@ public:
       ser.set_abi(abi, abi_serializer::create_yield_function(abi_serializer_max_time));
    }
 
+#ifdef SYSTEM_TESTER_NON_VALIDATING
+   eosio_system_tester()
+      : tester(world_snapshot() ? setup_policy::none : setup_policy::full)
+      , eosio_token("eosio.token"_n, *this)
+      , eosio_xyz(xyz_name, *this)
+      , eosio("eosio"_n, *this) {
+      if (const auto& snapshot = world_snapshot()) {
+         start_from(*snapshot);
+      } else {
+         build_world();
+         save_world();
+      }
+      record_budget();
+   }
+#else
+   // Builds the world for every test case, see `system_tester_base` for why it is not restored from a snapshot.
    eosio_system_tester()
       : validating_tester({}, nullptr, setup_policy::full)
       , eosio_token("eosio.token"_n, *this)
       , eosio_xyz(xyz_name, *this)
       , eosio("eosio"_n, *this) {
+      build_world();
+      record_budget();
+   }
+#endif
 
+   // From here on, what the test case pushes is its resource budget scenario, see resource_budget.hpp.
+   void record_budget() {
+#ifdef SYSTEM_BUDGET_FILE
+      budget_recorder.emplace(*control);
+#endif
+   }
+
+   // Deploys and initializes the system contracts and the xyz contract, and creates the funded accounts.
+   void build_world() {
       // -------- create accounts -----------------------------------------------------------------
       produce_block();
       create_accounts({"eosio.token"_n, "eosio.ram"_n, "eosio.ramfee"_n, "eosio.stake"_n, "eosio.bpay"_n,
@@ -328,7 +487,13 @@ public:
                                mutable_variant_object()("version", 0)("core", CORE_SYM_STR));
 
       // -------- xyz contract --------------------------------------------------------------------
+#ifdef SYSTEM_BUDGET_FILE
+      // instrumented, so that the resource budgets count the instructions it executes
+      set_code_and_abi(xyz_name, resource_budget::metered(xyz_contracts::system_wasm()),
+                       xyz_contracts::system_abi().data());
+#else
       set_code_and_abi(xyz_name, xyz_contracts::system_wasm(), xyz_contracts::system_abi().data());
+#endif
       create_serializer(xyz_name, xyz_abi_ser);
 
       base_tester::push_action(xyz_name, "init"_n,                      // call `init` on xyz contract
@@ -344,6 +509,70 @@ public:
       create_account_with_resources( "bob111111111"_n, config::system_account_name, core_sym::from_string("0.4500"), false );
    }
 
+#ifdef SYSTEM_TESTER_NON_VALIDATING
+   // ----------------------------------------------------------------------
+   // world snapshot
+   // ----------------------------------------------------------------------
+
+   // The world `build_world` creates, as a snapshot, once the first fixture of the process saved it. When
+   // SYSTEM_TESTER_SNAPSHOT names a file, the snapshot is also read from it, or written to it by the first process,
+   // so that suites run in parallel share one build. The file must be deleted when the contracts change.
+   static std::optional<std::string>& world_snapshot() {
+      static std::optional<std::string> snapshot = []() -> std::optional<std::string> {
+         const char* path = std::getenv("SYSTEM_TESTER_SNAPSHOT");
+         if (!path)
+            return {};
+         std::ifstream file(path, std::ios::binary);
+         if (!file)
+            return {};
+         return std::string(std::istreambuf_iterator<char>(file), {});
+      }();
+      return snapshot;
+   }
+
+   void save_world() {
+      world_snapshot() = snapshot_state();
+
+      if (const char* path = std::getenv("SYSTEM_TESTER_SNAPSHOT")) {
+         // written aside and renamed, so that a concurrent reader sees either no file or a complete one
+         const std::filesystem::path target(path);
+         const std::filesystem::path partial = target.string() + "." + std::to_string(::getpid());
+         std::ofstream(partial, std::ios::binary) << *world_snapshot();
+         std::filesystem::rename(partial, target);
+      }
+   }
+
+   // The state of the chain after producing a block, to `start_from` later.
+   std::string snapshot_state() {
+      produce_block();
+      control->abort_block();
+
+      std::ostringstream stream;
+      auto               writer = std::make_shared<ostream_snapshot_writer>(stream);
+      control->write_snapshot(writer);
+      writer->finalize();
+      return stream.str();
+   }
+
+   // Restarts the chain from a snapshot, e.g. of the world in place of the bare chain the constructor started, with
+   // the current `cfg` and an empty WASM code cache.
+   void start_from(const std::string& snapshot) {
+      close();
+      std::filesystem::remove_all(cfg.blocks_dir);
+      std::filesystem::remove_all(cfg.state_dir);
+
+      std::istringstream stream(snapshot);
+      auto               reader = std::make_shared<istream_snapshot_reader>(stream);
+      reader->validate();
+      init(cfg, reader);
+
+      create_serializer("eosio.token"_n, token_abi_ser);
+      create_serializer("eosio.bpay"_n, bpay_abi_ser);
+      create_serializer(config::system_account_name, abi_ser);
+      create_serializer(xyz_name, xyz_abi_ser);
+   }
+#endif
+
    void create_accounts_with_resources(vector<account_name> accounts,
                                        account_name         creator = config::system_account_name) {
       for (auto a : accounts)
@@ -1172,12 +1401,7 @@ public:
    asset get_balance(const account_name& act, symbol balance_symbol = symbol{CORE_SYM}) {
       vector<char> data =
          get_row_by_account("eosio.token"_n, act, "accounts"_n, account_name(balance_symbol.to_symbol_code().value));
-      return data.empty()
-                ? asset(0, balance_symbol)
-                : token_abi_ser
-                     .binary_to_variant("account", data,
-                                        abi_serializer::create_yield_function(abi_serializer_max_time))["balance"]
-                     .as<asset>();
+      return data.empty() ? asset(0, balance_symbol) : xyz_codec::unpack_row<xyz_codec::token_account>(data).balance;
    }
 
    asset get_balance(std::string_view act, symbol balance_symbol = symbol{CORE_SYM}) {
@@ -1401,7 +1625,7 @@ public:
       produce_block();
       produce_block(fc::seconds(1000));
 
-      auto trace_auth = validating_tester::push_action(config::system_account_name, updateauth::get_name(), config::system_account_name, mvo()
+      auto trace_auth = base_tester::push_action(config::system_account_name, updateauth::get_name(), config::system_account_name, mvo()
                                             ("account", name(config::system_account_name).to_string())
                                             ("permission", name(config::active_name).to_string())
                                             ("parent", name(config::owner_name).to_string())
@@ -1529,6 +1753,9 @@ public:
    abi_serializer token_abi_ser; // eos token contract
    abi_serializer bpay_abi_ser;
    abi_serializer xyz_abi_ser; // xyz wrap contract
+#ifdef SYSTEM_BUDGET_FILE
+   std::optional<resource_budget::recorder> budget_recorder; // what the test case pushed, see `record_budget`
+#endif
 };
 
 inline fc::mutable_variant_object voter(account_name acct) {
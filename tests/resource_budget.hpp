@@ -0,0 +1,181 @@
+#pragma once
+
+#include <boost/signals2/connection.hpp>
+#include <boost/test/results_collector.hpp>
+#include <boost/test/unit_test.hpp>
+#include <eosio/chain/controller.hpp>
+#include <eosio/chain/trace.hpp>
+#include <fc/io/json.hpp>
+#include <xyz/wasm_meter.hpp>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <tuple>
+
+// Resource budgets: what each gated scenario may use, checked in as tests/budgets.json. A scenario fails when one of
+// its numbers exceeds its budget by more than the tolerance of that number, so that a change making the swap paths
+// heavier fails here rather than on mainnet.
+//
+// Every test case of the unit tests is a scenario, named `<suite>/<test case>`, that adds up the transactions it
+// pushed after the fixture built its world (see `recorder`). The `resource_budgets` test cases also gate single
+// transactions, as `xyz/<scenario>` and `token/<scenario>`.
+//
+// CPU is gated on the WASM instructions the contract executed: the fixture deploys it instrumented by
+// `xyz_tools::meter_wasm`, whose counts don't vary between runs or machines as the tester's execution time does.
+//
+// With SYSTEM_BUDGET_UPDATE=1 in the environment the scenarios pass and write what they used as their new budget;
+// run them in one process (`./unit_test`), not through a parallel `ctest`, and review the diff of the file. A
+// scenario without a budget fails.
+
+namespace resource_budget {
+
+   using eosio::chain::transaction_trace_ptr;
+
+   // What one transaction, or the transactions of a test case, used.
+   struct usage {
+      uint64_t instructions   = 0; // WASM instructions executed by the metered contract
+      uint64_t net_bytes      = 0; // billed NET
+      int64_t  ram_delta      = 0; // sum of the RAM deltas of every account
+      uint32_t inline_actions = 0; // actions sent inline, notifications excluded
+      uint64_t trace_bytes    = 0; // packed size of the transaction trace, without the action consoles
+
+      usage& operator+=(const usage& other) {
+         instructions += other.instructions;
+         net_bytes += other.net_bytes;
+         ram_delta += other.ram_delta;
+         inline_actions += other.inline_actions;
+         trace_bytes += other.trace_bytes;
+         return *this;
+      }
+   };
+
+   // How far above its budget each number may go, in percent of the budget.
+   struct tolerance {
+      uint32_t instructions   = 10;
+      uint32_t net_bytes      = 0;
+      uint32_t ram_delta      = 0;
+      uint32_t inline_actions = 0;
+      uint32_t trace_bytes    = 5;
+   };
+
+   struct budget_file {
+      tolerance                    tolerance_percent;
+      std::map<std::string, usage> budgets; // by scenario
+   };
+
+} // namespace resource_budget
+
+FC_REFLECT(resource_budget::usage, (instructions)(net_bytes)(ram_delta)(inline_actions)(trace_bytes))
+FC_REFLECT(resource_budget::tolerance, (instructions)(net_bytes)(ram_delta)(inline_actions)(trace_bytes))
+FC_REFLECT(resource_budget::budget_file, (tolerance_percent)(budgets))
+
+namespace resource_budget {
+
+   // The contract as the fixture deploys it, so that its actions print what they executed.
+   inline std::vector<uint8_t> metered(const std::vector<uint8_t>& wasm) {
+      const auto out = xyz_tools::meter_wasm({reinterpret_cast<const char*>(wasm.data()), wasm.size()});
+      return {out.begin(), out.end()};
+   }
+
+   inline usage measure(const transaction_trace_ptr& trace) {
+      usage u;
+      if (trace->receipt)
+         u.net_bytes = uint64_t(trace->receipt->net_usage_words) * 8;
+      auto without_console = *trace; // where the metering prints, which the contract alone doesn't
+      for (auto& at : without_console.action_traces) {
+         u.instructions += xyz_tools::parse_meter_console(at.console).instructions;
+         at.console.clear();
+         for (const auto& delta : at.account_ram_deltas)
+            u.ram_delta += delta.delta;
+         if (at.creator_action_ordinal.value != 0 && at.receiver == at.act.account)
+            ++u.inline_actions;
+      }
+      u.trace_bytes = fc::raw::pack_size(without_console);
+      return u;
+   }
+
+   inline std::filesystem::path file_path() {
+      return SYSTEM_BUDGET_FILE;
+   }
+
+   inline budget_file load() {
+      if (!std::filesystem::exists(file_path()))
+         return {};
+      return fc::json::from_file(file_path()).as<budget_file>();
+   }
+
+   inline bool updating() {
+      const char* env = std::getenv("SYSTEM_BUDGET_UPDATE");
+      return env && *env && std::string_view(env) != "0";
+   }
+
+   // Checks `actual` against the budget of `scenario`, or records it as that budget when updating.
+   inline void check(const std::string& scenario, const usage& actual) {
+      if (updating()) {
+         auto file              = load(); // read again, other scenarios may have been written since
+         file.budgets[scenario] = actual;
+         fc::json::save_to_file(file, file_path());
+         BOOST_TEST_MESSAGE(scenario << ": budget recorded");
+         return;
+      }
+
+      static const budget_file file = load();
+      const auto               it   = file.budgets.find(scenario);
+      if (it == file.budgets.end()) {
+         BOOST_ERROR(scenario << ": no resource budget, record one with SYSTEM_BUDGET_UPDATE=1");
+         return;
+      }
+
+      const usage&     budget = it->second;
+      const tolerance& tol    = file.tolerance_percent;
+      auto within = [&](const char* what, int64_t used, int64_t allowed, uint32_t percent) {
+         const int64_t limit = allowed + std::abs(allowed) * int64_t(percent) / 100;
+         BOOST_CHECK_MESSAGE(used <= limit, scenario << ": " << what << " " << used << " exceeds the budget of "
+                                                     << allowed << " by more than " << percent << "%");
+      };
+      within("instructions", actual.instructions, budget.instructions, tol.instructions);
+      within("net_bytes", actual.net_bytes, budget.net_bytes, tol.net_bytes);
+      within("ram_delta", actual.ram_delta, budget.ram_delta, tol.ram_delta);
+      within("inline_actions", actual.inline_actions, budget.inline_actions, tol.inline_actions);
+      within("trace_bytes", actual.trace_bytes, budget.trace_bytes, tol.trace_bytes);
+   }
+
+   // Checks the usage of `trace` against the budget of `scenario`.
+   inline void check(const std::string& scenario, const transaction_trace_ptr& trace) {
+      check(scenario, measure(trace));
+   }
+
+   // Adds up the transactions the chain applies while it exists, but the `onblock` ones and those that failed.
+   class recorder {
+   public:
+      explicit recorder(eosio::chain::controller& chain)
+         : _connection(chain.applied_transaction().connect(
+              [this](std::tuple<const transaction_trace_ptr&, const eosio::chain::packed_transaction_ptr&> t) {
+                 add(std::get<0>(t));
+              })) {}
+
+      // Checks what the current test case used against its budget, unless it already failed or is failing.
+      void check_test_case() const {
+         namespace utf         = boost::unit_test;
+         const auto& test_case = utf::framework::current_test_case();
+         if (std::uncaught_exceptions() || !utf::results_collector.results(test_case.p_id).passed())
+            return;
+         const auto& suite = utf::framework::get<utf::test_suite>(test_case.p_parent_id);
+         check(suite.p_name.get() + "/" + test_case.p_name.get(), _total);
+      }
+
+   private:
+      void add(const transaction_trace_ptr& trace) {
+         if (!trace || !trace->receipt || trace->except)
+            return;
+         if (!trace->action_traces.empty() && trace->action_traces.front().act.name == eosio::chain::name("onblock"))
+            return;
+         _total += measure(trace);
+      }
+
+      usage                              _total;
+      boost::signals2::scoped_connection _connection;
+   };
+
+} // namespace resource_budget
@@ -10,6 +10,7 @@
 #include <eosio/chain/exceptions.hpp>
 
 #include "eosio.system_tester.hpp"
+#include "resource_budget.hpp"
 
 using namespace eosio_system;
 
@@ -26,4 +27,33 @@ BOOST_FIXTURE_TEST_CASE( ram_transfer, eosio_system_tester ) try {
 
 } FC_LOG_AND_RETHROW()
 
+// resources used by the token actions, against tests/budgets.json
+BOOST_FIXTURE_TEST_CASE( resource_budgets, eosio_system_tester ) try {
+   const std::vector<account_name> accounts = { "holder"_n, "newholder"_n };
+   create_accounts_with_resources( accounts );
+   const account_name holder = accounts[0];
+   const account_name newholder = accounts[1];
+
+   transfer( config::system_account_name, holder, core_sym::from_string("100.0000"), config::system_account_name );
+   transfer( holder, xyz_name, core_sym::from_string("50.0000"), holder );
+   produce_block();
+
+   auto gate = [&]( const std::string& scenario, const transaction_trace_ptr& trace ) {
+      produce_block();
+      resource_budget::check( "token/" + scenario, trace );
+   };
+
+   gate( "transfer new row", base_tester::push_action( xyz_name, "transfer"_n, holder, mvo()
+            ("from", holder)("to", newholder)("quantity", xyz("1.0000"))("memo", "") ) );
+   gate( "transfer", base_tester::push_action( xyz_name, "transfer"_n, holder, mvo()
+            ("from", holder)("to", newholder)("quantity", xyz("1.0000"))("memo", "") ) );
+   gate( "transfer all", base_tester::push_action( xyz_name, "transfer"_n, newholder, mvo()
+            ("from", newholder)("to", holder)("quantity", xyz("2.0000"))("memo", "") ) );
+   gate( "close", base_tester::push_action( xyz_name, "close"_n, newholder, mvo()
+            ("owner", newholder)("symbol", xyz_symbol()) ) );
+   gate( "open", base_tester::push_action( xyz_name, "open"_n, holder, mvo()
+            ("owner", newholder)("symbol", xyz_symbol())("ram_payer", holder) ) );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
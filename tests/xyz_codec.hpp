@@ -0,0 +1,232 @@
+#pragma once
+
+#include <eosio/chain/asset.hpp>
+#include <eosio/chain/name.hpp>
+#include <fc/io/raw.hpp>
+#include <optional>
+
+// Typed mirrors of the rows and action arguments of the xyz contract (contracts/include/system/system.entry.hpp),
+// packed and unpacked with fc::raw. They give the same bytes as the ABI, without going through `fc::variant`, so
+// the tester reads balances and encodes its actions with them; the ABI serializers stay for everything else.
+// A field added to a contract struct must be added here too, the `typed_codec` test compares both encodings.
+
+namespace xyz_codec {
+
+   using eosio::chain::asset;
+   using eosio::chain::name;
+   using eosio::chain::symbol;
+
+   // ----------------------------------------------------------------------
+   // rows
+   // ----------------------------------------------------------------------
+
+   // `accounts` of the xyz contract.
+   struct account {
+      asset balance;
+      bool  released = false;
+   };
+
+   // `accounts` of eosio.token, and the leading field of the xyz contract's rows.
+   struct token_account {
+      asset balance;
+   };
+
+   // `stat`
+   struct currency_stats {
+      asset supply;
+      asset max_supply;
+      name  issuer;
+   };
+
+   // `config`, whose fields after `token_symbol` are binary extensions: absent until first written.
+   struct config {
+      symbol                 token_symbol;
+      std::optional<uint8_t> swap_audit;
+      std::optional<bool>    implicit_reserve;
+      std::optional<bool>    commitment;
+      std::optional<bool>    registry;
+   };
+
+   // `blocked`
+   struct blocked_recipient {
+      name account;
+   };
+
+   template <typename T>
+   T unpack_row(const std::vector<char>& data) {
+      return fc::raw::unpack<T>(data);
+   }
+
+   template <>
+   inline config unpack_row<config>(const std::vector<char>& data) {
+      fc::datastream<const char*> ds(data.data(), data.size());
+      config                      c;
+      fc::raw::unpack(ds, c.token_symbol);
+      auto extension = [&](auto& field) {
+         if (ds.remaining()) {
+            field.emplace();
+            fc::raw::unpack(ds, *field);
+         }
+      };
+      extension(c.swap_audit);
+      extension(c.implicit_reserve);
+      extension(c.commitment);
+      extension(c.registry);
+      return c;
+   }
+
+   // ----------------------------------------------------------------------
+   // action arguments
+   // ----------------------------------------------------------------------
+
+   struct transfer {
+      name        from;
+      name        to;
+      asset       quantity;
+      std::string memo;
+   };
+
+   struct swapto {
+      name        from;
+      name        to;
+      asset       quantity;
+      std::string memo;
+   };
+
+   struct open {
+      name                 owner;
+      eosio::chain::symbol symbol;
+      name                 ram_payer;
+   };
+
+   struct close {
+      name                 owner;
+      eosio::chain::symbol symbol;
+   };
+
+   struct bidname {
+      name  bidder;
+      name  newname;
+      asset bid;
+   };
+
+   struct bidrefund {
+      name bidder;
+      name newname;
+   };
+
+   struct buyram {
+      name  payer;
+      name  receiver;
+      asset quant;
+   };
+
+   struct buyramburn {
+      name        payer;
+      asset       quantity;
+      std::string memo;
+   };
+
+   struct buyrambytes {
+      name     payer;
+      name     receiver;
+      uint32_t bytes;
+   };
+
+   struct buyramself {
+      name  payer;
+      asset quant;
+   };
+
+   struct ramburn {
+      name        owner;
+      int64_t     bytes;
+      std::string memo;
+   };
+
+   struct ramtransfer {
+      name        from;
+      name        to;
+      int64_t     bytes;
+      std::string memo;
+   };
+
+   struct sellram {
+      name    account;
+      int64_t bytes;
+   };
+
+   // deposit, withdraw
+   struct owner_amount {
+      name  owner;
+      asset amount;
+   };
+
+   // buyrex
+   struct from_amount {
+      name  from;
+      asset amount;
+   };
+
+   struct sellrex {
+      name  from;
+      asset rex;
+   };
+
+   // mvtosavings, mvfrsavings
+   struct owner_rex {
+      name  owner;
+      asset rex;
+   };
+
+   struct delegatebw {
+      name  from;
+      name  receiver;
+      asset stake_net_quantity;
+      asset stake_cpu_quantity;
+      bool  transfer;
+   };
+
+   struct undelegatebw {
+      name  from;
+      name  receiver;
+      asset unstake_net_quantity;
+      asset unstake_cpu_quantity;
+   };
+
+   struct refund {
+      name owner;
+   };
+
+   template <typename T>
+   std::vector<char> pack(const T& args) {
+      return fc::raw::pack(args);
+   }
+
+} // namespace xyz_codec
+
+FC_REFLECT(xyz_codec::account, (balance)(released))
+FC_REFLECT(xyz_codec::token_account, (balance))
+FC_REFLECT(xyz_codec::currency_stats, (supply)(max_supply)(issuer))
+FC_REFLECT(xyz_codec::blocked_recipient, (account))
+
+FC_REFLECT(xyz_codec::transfer, (from)(to)(quantity)(memo))
+FC_REFLECT(xyz_codec::swapto, (from)(to)(quantity)(memo))
+FC_REFLECT(xyz_codec::open, (owner)(symbol)(ram_payer))
+FC_REFLECT(xyz_codec::close, (owner)(symbol))
+FC_REFLECT(xyz_codec::bidname, (bidder)(newname)(bid))
+FC_REFLECT(xyz_codec::bidrefund, (bidder)(newname))
+FC_REFLECT(xyz_codec::buyram, (payer)(receiver)(quant))
+FC_REFLECT(xyz_codec::buyramburn, (payer)(quantity)(memo))
+FC_REFLECT(xyz_codec::buyrambytes, (payer)(receiver)(bytes))
+FC_REFLECT(xyz_codec::buyramself, (payer)(quant))
+FC_REFLECT(xyz_codec::ramburn, (owner)(bytes)(memo))
+FC_REFLECT(xyz_codec::ramtransfer, (from)(to)(bytes)(memo))
+FC_REFLECT(xyz_codec::sellram, (account)(bytes))
+FC_REFLECT(xyz_codec::owner_amount, (owner)(amount))
+FC_REFLECT(xyz_codec::from_amount, (from)(amount))
+FC_REFLECT(xyz_codec::sellrex, (from)(rex))
+FC_REFLECT(xyz_codec::owner_rex, (owner)(rex))
+FC_REFLECT(xyz_codec::delegatebw, (from)(receiver)(stake_net_quantity)(stake_cpu_quantity)(transfer))
+FC_REFLECT(xyz_codec::undelegatebw, (from)(receiver)(unstake_net_quantity)(unstake_cpu_quantity))
+FC_REFLECT(xyz_codec::refund, (owner))
@@ -6,11 +6,15 @@
 #include <cstdlib>
 #include <iostream>
 #include <sstream>
+#include <functional>
+#include <map>
 #include <fc/log/logger.hpp>
+#include <fc/crypto/sha256.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include "contracts.hpp"
 
 #include "eosio.system_tester.hpp"
+#include "resource_budget.hpp"
 
 std::vector<char> prepare_wasm(const std::vector<uint8_t>& uint8_vector) {
     std::vector<char> char_vector(uint8_vector.size());
@@ -18,30 +22,94 @@ std::vector<char> prepare_wasm(const std::vector<uint8_t>& uint8_vector) {
     return char_vector;
 }
 
-inline constexpr int64_t powerup_frac  = 1'000'000'000'000'000ll; // 1.0 = 10^15
-inline constexpr int64_t stake_weight = 100'000'000'0000ll; // 10^12
-
-struct powerup_config_resource {
-   std::optional<int64_t>        current_weight_ratio = {};
-   std::optional<int64_t>        target_weight_ratio  = {};
-   std::optional<int64_t>        assumed_stake_weight = {};
-   std::optional<time_point_sec> target_timestamp     = {};
-   std::optional<double>         exponent             = {};
-   std::optional<uint32_t>       decay_secs           = {};
-   std::optional<asset>          min_price            = {};
-   std::optional<asset>          max_price            = {};
+// return value of the `proofs` read-only action
+struct balance_proof {
+   name                    owner;
+   name                    leaf;
+   asset                   balance;
+   uint8_t                 depth   = 0;
+   uint64_t                present = 0;
+   std::vector<fc::sha256> siblings;
 };
-FC_REFLECT(powerup_config_resource,                                                             //
-           (current_weight_ratio)(target_weight_ratio)(assumed_stake_weight)(target_timestamp) //
-           (exponent)(decay_secs)(min_price)(max_price))
-
-struct powerup_config {
-   powerup_config_resource net             = {};
-   powerup_config_resource cpu             = {};
-   std::optional<uint32_t> powerup_days    = {};
-   std::optional<asset>    min_powerup_fee = {};
+FC_REFLECT(balance_proof, (owner)(leaf)(balance)(depth)(present)(siblings))
+
+struct commitment_proofs {
+   fc::sha256                 root;
+   uint64_t                   leaves = 0;
+   std::vector<balance_proof> proofs;
+};
+FC_REFLECT(commitment_proofs, (root)(leaves)(proofs))
+
+// return values of the `holders` and `topholders` read-only actions
+struct holder {
+   name  owner;
+   asset balance;
+};
+FC_REFLECT(holder, (owner)(balance))
+
+struct holders_page {
+   std::vector<holder> holders;
+   name                next;
 };
-FC_REFLECT(powerup_config, (net)(cpu)(powerup_days)(min_powerup_fee))
+FC_REFLECT(holders_page, (holders)(next))
+
+// The balance commitment's hashing, as a light client does it (see contracts/include/system/commitment.hpp).
+namespace commitment {
+   uint64_t key_of(name owner) {
+      const uint64_t value  = owner.to_uint64_t();
+      const auto     digest = fc::sha256::hash(reinterpret_cast<const char*>(&value), sizeof(value));
+      uint64_t       key    = 0;
+      for (int i = 0; i < 8; ++i)
+         key = key << 8 | uint8_t(digest.data()[i]);
+      return key;
+   }
+
+   fc::sha256 leaf_hash(name owner, const asset& balance) {
+      fc::sha256::encoder enc;
+      fc::raw::pack(enc, owner);
+      fc::raw::pack(enc, balance);
+      return enc.result();
+   }
+
+   fc::sha256 branch_hash(const fc::sha256& left, const fc::sha256& right) {
+      fc::sha256::encoder enc;
+      fc::raw::pack(enc, left);
+      fc::raw::pack(enc, right);
+      return enc.result();
+   }
+
+   // The root a proof leads to, to compare with the root it came with.
+   fc::sha256 root_of(const balance_proof& proof) {
+      const uint64_t key  = key_of(proof.owner);
+      fc::sha256     hash = proof.leaf == name() ? fc::sha256() : leaf_hash(proof.leaf, proof.balance);
+      auto           sibling = proof.siblings.rbegin();
+      for (uint32_t d = proof.depth; d-- > 0;) {
+         const fc::sha256 other = (proof.present >> d) & 1 ? *sibling++ : fc::sha256();
+         hash = (key >> (63 - d)) & 1 ? branch_hash(other, hash) : branch_hash(hash, other);
+      }
+      return hash;
+   }
+
+   // The root of a set of non-zero balances, built from scratch.
+   fc::sha256 root_of(const std::map<name, asset>& balances) {
+      std::vector<std::pair<uint64_t, std::pair<name, asset>>> leaves;
+      for (const auto& [owner, balance] : balances)
+         leaves.push_back({key_of(owner), {owner, balance}});
+      std::sort(leaves.begin(), leaves.end());
+
+      std::function<fc::sha256(size_t, size_t, uint32_t)> subtree = [&](size_t begin, size_t end, uint32_t depth) {
+         if (begin == end)
+            return fc::sha256();
+         if (end - begin == 1)
+            return leaf_hash(leaves[begin].second.first, leaves[begin].second.second);
+         size_t middle = begin;
+         while (middle < end && !((leaves[middle].first >> (63 - depth)) & 1))
+            ++middle;
+         return branch_hash(subtree(begin, middle, depth + 1), subtree(middle, end, depth + 1));
+      };
+      return subtree(0, leaves.size(), 0);
+   }
+} // namespace commitment
 
 
 using namespace eosio_system;
@@ -107,6 +175,12 @@ BOOST_FIXTURE_TEST_CASE(transfer_and_swapto, eosio_system_tester) try {
    BOOST_REQUIRE_EQUAL(eosio_xyz.swapto(bob, alice, xyz("150.0000")),
                        error("overdrawn balance"));
 
+   // the memo is limited as for `transfer`
+   // -------------------------------------
+   BOOST_REQUIRE_EQUAL(eosio_xyz.swapto(carol, bob, eos("1.0000"), std::string(257, 'm')),
+                       error("memo has more than 256 bytes"));
+   BOOST_REQUIRE_EQUAL(eosio_xyz.swapto(carol, bob, eos("1.0000"), std::string(256, 'm')), success());
+
 } FC_LOG_AND_RETHROW()
 
 // ----------------------------
@@ -159,6 +233,841 @@ BOOST_FIXTURE_TEST_CASE(bidname, eosio_system_tester) try {
 } FC_LOG_AND_RETHROW()
 
 
+// ----------------------------
+// test: `setaudit`, swap markers of the forwarding actions
+// ----------------------------
+BOOST_FIXTURE_TEST_CASE(swap_audit, eosio_system_tester) try {
+   const std::vector<account_name> accounts = { "alice"_n };
+   create_accounts_with_resources( accounts );
+   const account_name alice = accounts[0];
+
+   eosio_token.transfer(eos_name, alice, eos("100.0000"));
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("50.0000")), success()); // swap 50 EOS to XYZ
+
+   auto buyram = [&]() {
+      auto trace = base_tester::push_action( xyz_name, "buyram"_n, alice, mutable_variant_object()
+         ("payer",    alice)
+         ("receiver", alice)
+         ("quant",    xyz("1.0000"))
+      );
+      produce_block();
+      return trace;
+   };
+
+   auto count_swaptraces = [&](const transaction_trace_ptr& trace) {
+      return std::count_if(trace->action_traces.begin(), trace->action_traces.end(), [&](const auto& at) {
+         return at.receiver == xyz_name && at.act.name == "swaptrace"_n;
+      });
+   };
+
+   auto forwarder_return_value = [&](const transaction_trace_ptr& trace) {
+      for (const auto& at : trace->action_traces) {
+         if (at.receiver == xyz_name && at.act.name == "buyram"_n)
+            return at.return_value;
+      }
+      return bytes{};
+   };
+
+   auto setaudit = [&](account_name signer, uint8_t mode) {
+      return base_tester::push_action( xyz_name, "setaudit"_n, signer, mutable_variant_object()
+         ("mode", mode)
+      );
+   };
+
+   // only the contract can change the audit mode
+   // -------------------------------------------
+   BOOST_REQUIRE_EXCEPTION(setaudit(alice, 1), missing_auth_exception,
+                           fc_exception_message_is("missing authority of xyz"));
+   BOOST_REQUIRE_EXCEPTION(setaudit(xyz_name, 3), eosio_assert_message_exception,
+                           eosio_assert_message_is("invalid swap audit mode"));
+
+   // default: one `swaptrace` per swap, nothing returned
+   // ---------------------------------------------------
+   {
+      auto trace = buyram();
+      BOOST_REQUIRE_EQUAL(count_swaptraces(trace), 1);
+      BOOST_REQUIRE(forwarder_return_value(trace).empty());
+   }
+
+   // compact: no `swaptrace`, the forwarding action returns the swap receipt
+   // -----------------------------------------------------------------------
+   {
+      setaudit(xyz_name, 1);
+      auto trace = buyram();
+      BOOST_REQUIRE_EQUAL(count_swaptraces(trace), 0);
+
+      auto rv = forwarder_return_value(trace);
+      fc::datastream<const char*> ds(rv.data(), rv.size());
+      account_name account;
+      asset        quantity;
+      fc::raw::unpack(ds, account);
+      fc::raw::unpack(ds, quantity);
+      BOOST_REQUIRE_EQUAL(account, alice);
+      BOOST_REQUIRE_EQUAL(quantity, xyz("1.0000"));
+   }
+
+   // none: no marker at all, the swap still happens
+   // ----------------------------------------------
+   {
+      setaudit(xyz_name, 2);
+      auto trace = buyram();
+      BOOST_REQUIRE_EQUAL(count_swaptraces(trace), 0);
+      BOOST_REQUIRE(forwarder_return_value(trace).empty());
+      BOOST_REQUIRE(check_balances(alice, { eos("50.0000"), xyz("47.0000") }));
+   }
+
+   // back to full
+   // ------------
+   {
+      setaudit(xyz_name, 0);
+      BOOST_REQUIRE_EQUAL(count_swaptraces(buyram()), 1);
+   }
+
+} FC_LOG_AND_RETHROW()
+
+
+// ----------------------------
+// test: `setreserve`, swaps that leave the contract's own balance row untouched
+// ----------------------------
+BOOST_FIXTURE_TEST_CASE(implicit_reserve, eosio_system_tester) try {
+   const std::vector<account_name> accounts = { "alice"_n, "bob"_n };
+   create_accounts_with_resources( accounts );
+   const account_name alice = accounts[0];
+   const account_name bob   = accounts[1];
+
+   eosio_token.transfer(eos_name, alice, eos("100.0000"));
+
+   auto setreserve = [&](account_name signer, bool implicit) {
+      auto trace = base_tester::push_action( xyz_name, "setreserve"_n, signer, mutable_variant_object()
+         ("implicit", implicit)
+      );
+      produce_block();
+      return trace;
+   };
+
+   // only the contract can change where the reserve is kept
+   // -------------------------------------------------------
+   BOOST_REQUIRE_EXCEPTION(setreserve(alice, true), missing_auth_exception,
+                           fc_exception_message_is("missing authority of xyz"));
+   BOOST_REQUIRE_EXCEPTION(setreserve(xyz_name, false), eosio_assert_message_exception,
+                           eosio_assert_message_is("reserve is already explicit"));
+
+   const asset reserve = get_xyz_balance(xyz_name);
+   setreserve(xyz_name, true);
+   BOOST_REQUIRE_EXCEPTION(setreserve(xyz_name, true), eosio_assert_message_exception,
+                           eosio_assert_message_is("reserve is already implicit"));
+
+   // swaps in every direction only write the user's row
+   // ---------------------------------------------------
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("10.0000")), success()); // swap 10 EOS to XYZ
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, xyz_name, xyz("4.0000")), success());    // swap 4 XYZ back to EOS
+   BOOST_REQUIRE_EQUAL(eosio_xyz.buyram(alice, alice, xyz("1.0000")), success());         // swap before forwarding
+   BOOST_REQUIRE_EQUAL(eosio_xyz.swapto(alice, bob, eos("2.0000")), success());           // swap 2 EOS to XYZ for bob
+   BOOST_REQUIRE(check_balances(alice, { eos("92.0000"), xyz("5.0000") }));
+   BOOST_REQUIRE(check_balances(bob,   { xyz("2.0000") }));
+   BOOST_REQUIRE_EQUAL(get_xyz_balance(xyz_name), reserve);
+
+   // the reserve can't be transferred out directly
+   // ---------------------------------------------
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(xyz_name, alice, xyz("1.0000")),
+                       error("the implicit reserve can only be spent by swaps"));
+
+   // EOS that reaches the contract outside of a swap doesn't move the reserve
+   // ------------------------------------------------------------------------
+   eosio_token.transfer(eos_name, "eosio.stake"_n, eos("5.0000"));
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer("eosio.stake"_n, xyz_name, eos("5.0000")), success());
+
+   // back to explicit: the derived reserve is written to the contract's row
+   // ----------------------------------------------------------------------
+   setreserve(xyz_name, false);
+   BOOST_REQUIRE_EQUAL(get_xyz_balance(xyz_name), reserve - xyz("7.0000"));
+
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("1.0000")), success());
+   BOOST_REQUIRE_EQUAL(get_xyz_balance(xyz_name), reserve - xyz("8.0000"));
+
+} FC_LOG_AND_RETHROW()
+
+
+// ----------------------------
+// test: `solvency` counters, maintained by every swap
+// ----------------------------
+BOOST_FIXTURE_TEST_CASE(solvency_counters, eosio_system_tester) try {
+   const std::vector<account_name> accounts = { "alice"_n, "bob"_n };
+   create_accounts_with_resources( accounts );
+   const account_name alice = accounts[0];
+   const account_name bob   = accounts[1];
+
+   eosio_token.transfer(eos_name, alice, eos("100.0000"));
+
+   // circulating, eos held, swapped in, swapped out
+   auto solvency = [&]() {
+      auto trace = base_tester::push_action( xyz_name, "solvency"_n, alice, mutable_variant_object() );
+      produce_block();
+      const auto& rv = trace->action_traces[0].return_value;
+      fc::datastream<const char*> ds(rv.data(), rv.size());
+      std::array<asset, 4> counters;
+      for (auto& c : counters)
+         fc::raw::unpack(ds, c);
+      return counters;
+   };
+
+   auto require_counters = [&](const asset& circulating, const asset& swapped_in, const asset& swapped_out) {
+      const auto counters = solvency();
+      BOOST_REQUIRE_EQUAL(counters[0], circulating);
+      BOOST_REQUIRE_EQUAL(counters[1], get_eos_balance(xyz_name));
+      BOOST_REQUIRE_EQUAL(counters[2], swapped_in);
+      BOOST_REQUIRE_EQUAL(counters[3], swapped_out);
+   };
+
+   // seeded by `init`
+   require_counters(xyz("0.0000"), eos("0.0000"), xyz("0.0000"));
+
+   // every swap path
+   // ---------------
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("50.0000")), success()); // on_transfer
+   require_counters(xyz("50.0000"), eos("50.0000"), xyz("0.0000"));
+
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, xyz_name, xyz("5.0000")), success());    // transfer to self
+   require_counters(xyz("45.0000"), eos("50.0000"), xyz("5.0000"));
+
+   BOOST_REQUIRE_EQUAL(eosio_xyz.buyram(alice, alice, xyz("1.0000")), success());         // swap before forwarding
+   require_counters(xyz("44.0000"), eos("50.0000"), xyz("6.0000"));
+
+   BOOST_REQUIRE_EQUAL(eosio_xyz.swapto(alice, bob, eos("2.0000")), success());           // swapto, both directions
+   BOOST_REQUIRE_EQUAL(eosio_xyz.swapto(alice, bob, xyz("3.0000")), success());
+   require_counters(xyz("43.0000"), eos("52.0000"), xyz("9.0000"));
+
+   // a plain transfer between users changes nothing
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, bob, xyz("1.0000")), success());
+   require_counters(xyz("43.0000"), eos("52.0000"), xyz("9.0000"));
+
+   // reseeding from the state at rest agrees, and keeps the volumes
+   // ---------------------------------------------------------------
+   BOOST_REQUIRE_EXCEPTION(base_tester::push_action( xyz_name, "syncsolvency"_n, alice, mutable_variant_object() ),
+                           missing_auth_exception, fc_exception_message_is("missing authority of xyz"));
+   base_tester::push_action( xyz_name, "syncsolvency"_n, xyz_name, mutable_variant_object() );
+   require_counters(xyz("43.0000"), eos("52.0000"), xyz("9.0000"));
+
+} FC_LOG_AND_RETHROW()
+
+
+// ----------------------------
+// test: balance commitment, `setcommit`, `commitacct` and `proofs`
+// ----------------------------
+BOOST_FIXTURE_TEST_CASE(balance_commitment, eosio_system_tester) try {
+   std::vector<account_name> accounts = { "alice"_n, "bob"_n, "carol"_n };
+   for (char c = 'a'; c <= 'p'; ++c)
+      accounts.push_back(account_name(std::string("holder") + c));
+   create_accounts_with_resources( accounts );
+   const account_name alice = accounts[0];
+   const account_name bob   = accounts[1];
+   const account_name carol = accounts[2];
+   const std::vector<account_name> holders(accounts.begin() + 3, accounts.end());
+
+   eosio_token.transfer(eos_name, alice, eos("1000.0000"));
+
+   auto setcommit = [&](account_name signer, bool enabled) {
+      auto trace = base_tester::push_action( xyz_name, "setcommit"_n, signer, mutable_variant_object()
+         ("enabled", enabled)
+      );
+      produce_block();
+      return trace;
+   };
+   auto commitacct = [&](account_name signer, const std::vector<account_name>& owners) {
+      base_tester::push_action( xyz_name, "commitacct"_n, signer, mutable_variant_object()("owners", owners) );
+      produce_block();
+   };
+   auto proofs = [&](const std::vector<account_name>& owners) {
+      auto trace = base_tester::push_action( xyz_name, "proofs"_n, alice, mutable_variant_object()("owners", owners) );
+      produce_block();
+      return fc::raw::unpack<commitment_proofs>(trace->action_traces[0].return_value);
+   };
+
+   // every proof leads to the root, and to the owner's balance when it is committed
+   auto require_committed = [&](const std::map<name, asset>& expected, const std::vector<account_name>& owners) {
+      const auto p = proofs(owners);
+      BOOST_REQUIRE_EQUAL(p.leaves, expected.size());
+      BOOST_REQUIRE(p.root == commitment::root_of(expected));
+      for (const auto& proof : p.proofs) {
+         BOOST_REQUIRE(commitment::root_of(proof) == p.root);
+         const auto found = expected.find(proof.owner);
+         if (found == expected.end()) {
+            BOOST_REQUIRE(proof.leaf != proof.owner);
+         } else {
+            BOOST_REQUIRE_EQUAL(proof.leaf, proof.owner);
+            BOOST_REQUIRE_EQUAL(proof.balance, found->second);
+         }
+      }
+   };
+
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("500.0000")), success());
+
+   // only the contract turns it on, balances from before are not committed
+   // ----------------------------------------------------------------------
+   BOOST_REQUIRE_EXCEPTION(setcommit(alice, true), missing_auth_exception,
+                           fc_exception_message_is("missing authority of xyz"));
+   BOOST_REQUIRE_EXCEPTION(proofs({ alice }), eosio_assert_message_exception,
+                           eosio_assert_message_is("commitment is not enabled"));
+   BOOST_REQUIRE(!get_xyz_config().commitment.value_or(false));
+   setcommit(xyz_name, true);
+   BOOST_REQUIRE_EXCEPTION(setcommit(xyz_name, true), eosio_assert_message_exception,
+                           eosio_assert_message_is("commitment is already enabled"));
+   BOOST_REQUIRE(get_xyz_config().commitment == std::optional<bool>(true)); // what balance changes check
+   require_committed({}, { alice, xyz_name });
+
+   // anyone can backfill, accounts without a balance are left out
+   commitacct(carol, { alice, bob, xyz_name });
+   std::map<name, asset> expected = { { alice, xyz("500.0000") }, { xyz_name, get_xyz_balance(xyz_name) } };
+   require_committed(expected, { alice, bob, carol, xyz_name });
+
+   // every balance change is committed in the same action
+   // ----------------------------------------------------
+   for (size_t i = 0; i < holders.size(); ++i) {
+      const asset amount = asset(int64_t(i + 1) * 10000, xyz_symbol());
+      BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, holders[i], amount), success());
+      expected[holders[i]] = amount;
+      expected[alice] -= amount;
+   }
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, xyz_name, xyz("10.0000")), success()); // swap to EOS
+   BOOST_REQUIRE_EQUAL(eosio_xyz.buyram(alice, alice, xyz("1.0000")), success());      // swap before forwarding
+   BOOST_REQUIRE_EQUAL(eosio_xyz.swapto(alice, bob, eos("2.0000")), success());        // swap to XYZ for bob
+   expected[alice]    -= xyz("11.0000");
+   expected[bob]      = xyz("2.0000");
+   expected[xyz_name] = get_xyz_balance(xyz_name);
+   BOOST_REQUIRE_EQUAL(get_xyz_balance(alice), expected[alice]);
+   require_committed(expected, accounts);
+
+   // balances that drop to zero leave the tree, and the leaves left alone move back up
+   for (size_t i = 0; i < holders.size(); i += 2) {
+      BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(holders[i], alice, expected[holders[i]]), success());
+      expected[alice] += expected[holders[i]];
+      expected.erase(holders[i]);
+   }
+   require_committed(expected, accounts);
+
+   // turned off, changes are not committed until the accounts are committed again
+   // ----------------------------------------------------------------------------
+   setcommit(xyz_name, false);
+   BOOST_REQUIRE_EXCEPTION(setcommit(xyz_name, false), eosio_assert_message_exception,
+                           eosio_assert_message_is("commitment is already disabled"));
+   BOOST_REQUIRE(get_xyz_config().commitment == std::optional<bool>(false));
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, carol, xyz("3.0000")), success());
+   BOOST_REQUIRE_EXCEPTION(commitacct(carol, { carol }), eosio_assert_message_exception,
+                           eosio_assert_message_is("commitment is not enabled"));
+
+   setcommit(xyz_name, true);
+   require_committed(expected, accounts);
+   commitacct(carol, { alice, carol });
+   expected[alice] -= xyz("3.0000");
+   expected[carol] = xyz("3.0000");
+   require_committed(expected, accounts);
+
+} FC_LOG_AND_RETHROW()
+
+
+// ----------------------------
+// test: transfers to the contract routed by their memo
+// ----------------------------
+BOOST_FIXTURE_TEST_CASE(memo_routes, eosio_system_tester) try {
+   const std::vector<account_name> accounts = { "alice"_n, "bob"_n, "carol"_n };
+   create_accounts_with_resources( accounts );
+   const account_name alice = accounts[0];
+   const account_name bob   = accounts[1];
+   const account_name carol = accounts[2];
+
+   eosio_token.transfer(eos_name, alice, eos("1000.0000"));
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("500.0000")), success());
+
+   // memos that are not routes swap for the sender, as always
+   // --------------------------------------------------------
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("1.0000"), "deposit: 12345"), success());
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, xyz_name, xyz("1.0000"), "Swapto:bob"), success());
+   BOOST_REQUIRE(check_balances(alice, { eos("500.0000"), xyz("500.0000") }));
+
+   // `swapto:<account>`, both ways
+   // -----------------------------
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("10.0000"), "swapto:bob"), success());
+   BOOST_REQUIRE(check_balances(alice, { eos("490.0000"), xyz("500.0000") }));
+   BOOST_REQUIRE(check_balances(bob,   { eos("0.0000"),   xyz("10.0000") }));
+
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, xyz_name, xyz("20.0000"), "swapto:carol"), success());
+   BOOST_REQUIRE(check_balances(alice, { eos("490.0000"), xyz("480.0000") }));
+   BOOST_REQUIRE(check_balances(carol, { eos("20.0000"),  xyz("0.0000") }));
+
+   // recipients that blocked `swapto` are blocked here too
+   base_tester::push_action( xyz_name, "blockswapto"_n, bob, mutable_variant_object()("account", bob)("block", true) );
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("1.0000"), "swapto:bob"),
+                       error("Recipient is blocked from receiving swapped tokens: bob"));
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, xyz_name, xyz("1.0000"), "swapto:bob"),
+                       error("Recipient is blocked from receiving swapped tokens: bob"));
+
+   // malformed routes fail the transfer
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("1.0000"), "swapto:"),
+                       error("invalid memo route: bad account"));
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, xyz_name, xyz("1.0000"), "buyram:bob:carol"),
+                       error("invalid memo route: too many fields"));
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("1.0000"), "powerup:bob:30:1"),
+                       error("invalid memo route: missing field"));
+   BOOST_REQUIRE(check_balances(alice, { eos("490.0000"), xyz("480.0000") }));
+
+   // `buyram:<receiver>`, paid in EOS or in XYZ
+   // ------------------------------------------
+   const auto ram_before = get_ram_bytes(bob);
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("5.0000"), "buyram:bob"), success());
+   const auto ram_bought = get_ram_bytes(bob) - ram_before;
+   BOOST_REQUIRE(ram_bought > 0);
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, xyz_name, xyz("5.0000"), "buyram:bob"), success());
+   BOOST_REQUIRE(get_ram_bytes(bob) > ram_before + ram_bought);
+   BOOST_REQUIRE(check_balances(alice, { eos("485.0000"), xyz("475.0000") }));
+
+   // `powerup:<receiver>:<days>:<net_frac>:<cpu_frac>`, what the fee leaves comes back as XYZ
+   // -----------------------------------------------------------------------------------------
+   base_tester::push_action(eos_name, "cfgpowerup"_n, eos_name,
+                            mvo()("args", make_powerup_config(get_pending_block_time())));
+   produce_block();
+
+   const asset eos_held = get_eos_balance(xyz_name);
+   const std::string frac = std::to_string(powerup_frac / 1000);
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("100.0000"),
+                                            "powerup:carol:30:" + frac + ":" + frac), success());
+   const asset refunded = get_xyz_balance(alice) - xyz("475.0000");
+   BOOST_REQUIRE(refunded > xyz("0.0000") && refunded < xyz("100.0000"));
+   BOOST_REQUIRE_EQUAL(get_eos_balance(xyz_name), eos_held + asset(refunded.get_amount(), eos_symbol()));
+
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, xyz_name, xyz("100.0000"),
+                                          "powerup:carol:30:" + frac + ":" + frac), success());
+   BOOST_REQUIRE(get_xyz_balance(alice) > xyz("375.0000") + refunded);
+
+} FC_LOG_AND_RETHROW()
+
+
+// ----------------------------
+// test: the holder registry and its read-only exports
+// ----------------------------
+BOOST_FIXTURE_TEST_CASE(holder_registry, eosio_system_tester) try {
+   std::vector<account_name> accounts = { "alice"_n, "bob"_n, "carol"_n };
+   for (char c = 'a'; c <= 'l'; ++c)
+      accounts.push_back(account_name(std::string("holder") + c));
+   create_accounts_with_resources( accounts );
+   const account_name alice = accounts[0];
+   const account_name bob   = accounts[1];
+   const account_name carol = accounts[2];
+   const std::vector<account_name> holders(accounts.begin() + 3, accounts.end());
+
+   eosio_token.transfer(eos_name, alice, eos("1000.0000"));
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("500.0000")), success());
+
+   auto setregistry = [&](account_name signer, bool enabled) {
+      base_tester::push_action( xyz_name, "setregistry"_n, signer, mutable_variant_object()("enabled", enabled) );
+      produce_block();
+   };
+   auto registeracct = [&](account_name signer, const std::vector<account_name>& owners) {
+      base_tester::push_action( xyz_name, "registeracct"_n, signer, mutable_variant_object()("owners", owners) );
+      produce_block();
+   };
+   auto page = [&](account_name cursor, uint32_t limit) {
+      auto trace = base_tester::push_action( xyz_name, "holders"_n, alice, mutable_variant_object()
+         ("cursor", cursor)
+         ("limit", limit)
+      );
+      produce_block();
+      return fc::raw::unpack<holders_page>(trace->action_traces[0].return_value);
+   };
+   auto top = [&](uint32_t limit) {
+      auto trace = base_tester::push_action( xyz_name, "topholders"_n, alice, mutable_variant_object()("limit", limit) );
+      produce_block();
+      return fc::raw::unpack<std::vector<holder>>(trace->action_traces[0].return_value);
+   };
+
+   // every registered row, exported three at a time
+   auto export_all = [&]() {
+      std::map<name, asset> rows;
+      account_name          cursor;
+      do {
+         const auto p = page(cursor, 3);
+         BOOST_REQUIRE(p.holders.size() <= 3);
+         for (const auto& h : p.holders)
+            BOOST_REQUIRE(rows.emplace(h.owner, h.balance).second);
+         cursor = p.next;
+      } while (cursor != account_name());
+      return rows;
+   };
+
+   // only the contract turns it on, rows from before are not registered
+   // -------------------------------------------------------------------
+   BOOST_REQUIRE_EXCEPTION(setregistry(alice, true), missing_auth_exception,
+                           fc_exception_message_is("missing authority of xyz"));
+   BOOST_REQUIRE_EXCEPTION(top(10), eosio_assert_message_exception,
+                           eosio_assert_message_is("registry is not enabled"));
+   setregistry(xyz_name, true);
+   BOOST_REQUIRE_EXCEPTION(setregistry(xyz_name, true), eosio_assert_message_exception,
+                           eosio_assert_message_is("registry is already enabled"));
+   BOOST_REQUIRE_EXCEPTION(page(account_name(), 0), eosio_assert_message_exception,
+                           eosio_assert_message_is("invalid page size"));
+   BOOST_REQUIRE_EXCEPTION(top(1001), eosio_assert_message_exception,
+                           eosio_assert_message_is("invalid page size"));
+   BOOST_REQUIRE(export_all().empty());
+   BOOST_REQUIRE(get_xyz_config().registry == std::optional<bool>(true)); // what balance changes check
+
+   // anyone can backfill, accounts without a row are left out
+   registeracct(carol, { alice, bob, xyz_name });
+   std::map<name, asset> expected = { { alice, xyz("500.0000") }, { xyz_name, get_xyz_balance(xyz_name) } };
+   BOOST_REQUIRE(export_all() == expected);
+
+   // every row change is registered in the same action
+   // --------------------------------------------------
+   for (size_t i = 0; i < holders.size(); ++i) {
+      const asset amount = asset(int64_t(i + 1) * 10000, xyz_symbol());
+      BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, holders[i], amount), success());
+      expected[holders[i]] = amount;
+      expected[alice] -= amount;
+   }
+   BOOST_REQUIRE_EQUAL(eosio_xyz.swapto(alice, bob, eos("2.0000")), success());
+   BOOST_REQUIRE_EQUAL(eosio_xyz.open(carol, xyz_symbol(), carol), success());
+   expected[bob]      = xyz("2.0000");
+   expected[carol]    = xyz("0.0000");
+   expected[xyz_name] = get_xyz_balance(xyz_name);
+   BOOST_REQUIRE(export_all() == expected);
+
+   // drained rows stay registered until they are closed
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(holders[0], alice, expected[holders[0]]), success());
+   expected[alice] += expected[holders[0]];
+   expected[holders[0]] = xyz("0.0000");
+   BOOST_REQUIRE(export_all() == expected);
+   BOOST_REQUIRE_EQUAL(eosio_xyz.close(holders[0], xyz_symbol()), success());
+   expected.erase(holders[0]);
+   BOOST_REQUIRE(export_all() == expected);
+
+   // the largest balances first
+   // --------------------------
+   std::vector<std::pair<asset, name>> ranked;
+   for (const auto& [owner, balance] : expected)
+      ranked.push_back({ balance, owner });
+   std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+   const auto top5 = top(5);
+   BOOST_REQUIRE_EQUAL(top5.size(), 5u);
+   for (size_t i = 0; i < top5.size(); ++i)
+      BOOST_REQUIRE_EQUAL(top5[i].balance, ranked[i].first);
+   BOOST_REQUIRE_EQUAL(top5[0].owner, xyz_name);
+   BOOST_REQUIRE_EQUAL(top(1000).size(), expected.size());
+
+   // turned off, changes are not registered until the accounts are registered again
+   // ------------------------------------------------------------------------------
+   setregistry(xyz_name, false);
+   BOOST_REQUIRE(get_xyz_config().registry == std::optional<bool>(false));
+   BOOST_REQUIRE_EQUAL(eosio_xyz.transfer(alice, carol, xyz("3.0000")), success());
+   BOOST_REQUIRE_EXCEPTION(registeracct(carol, { carol }), eosio_assert_message_exception,
+                           eosio_assert_message_is("registry is not enabled"));
+   setregistry(xyz_name, true);
+   BOOST_REQUIRE(export_all() == expected);
+   registeracct(carol, { alice, carol });
+   expected[alice] -= xyz("3.0000");
+   expected[carol] = xyz("3.0000");
+   BOOST_REQUIRE(export_all() == expected);
+
+} FC_LOG_AND_RETHROW()
+
+
+// ----------------------------
+// test: `newaccounts`, a batch of accounts created and provisioned with a single swap
+// ----------------------------
+BOOST_FIXTURE_TEST_CASE(batch_newaccounts, eosio_system_tester) try {
+   const std::vector<account_name> accounts = { "alice"_n };
+   create_accounts_with_resources( accounts );
+   const account_name alice = accounts[0];
+
+   eosio_token.transfer(eos_name, alice, eos("1000.0000"));
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("500.0000")), success());
+
+   auto spec = [&](account_name account, uint32_t ram_bytes, const asset& net, const asset& cpu) {
+      return mvo()("account", account)("key", get_public_key(account, "active"))("ram_bytes", ram_bytes)
+                  ("net", net)("cpu", cpu);
+   };
+   auto newaccounts = [&](const std::vector<mvo>& specs) {
+      auto trace = base_tester::push_action( xyz_name, "newaccounts"_n, alice, mvo()
+         ("creator", alice)
+         ("accounts", specs)
+      );
+      produce_block();
+      return trace;
+   };
+
+   // 12 characters, shorter names are auctioned
+   const std::vector<account_name> created = { "newusera1111"_n, "newuserb1111"_n, "newuserc1111"_n };
+   const auto trace = newaccounts({ spec(created[0], 4000, xyz("1.0000"), xyz("2.0000")),
+                                    spec(created[1], 8000, xyz("0.0000"), xyz("0.5000")),
+                                    spec(created[2], 4000, xyz("0.0000"), xyz("0.0000")) });
+
+   // one swap for the whole batch, and the creator's EOS is left alone
+   const auto swaps = std::count_if(trace->action_traces.begin(), trace->action_traces.end(),
+                                    [](const auto& t) { return t.act.name == "swaptrace"_n; });
+   BOOST_REQUIRE_EQUAL(swaps, 1);
+   BOOST_REQUIRE_EQUAL(get_eos_balance(alice), eos("500.0000"));
+   BOOST_REQUIRE(get_xyz_balance(alice) < xyz("496.5000"));
+
+   for (const auto& account : created) {
+      BOOST_REQUIRE(!get_total_stake(account).is_null());
+      BOOST_REQUIRE(get_ram_bytes(account) >= 3990);
+   }
+   BOOST_REQUIRE(get_ram_bytes(created[1]) >= 7990);
+   BOOST_REQUIRE_EQUAL(get_total_stake(created[0])["net_weight"].as<asset>(), eos("1.0000"));
+   BOOST_REQUIRE_EQUAL(get_total_stake(created[0])["cpu_weight"].as<asset>(), eos("2.0000"));
+   BOOST_REQUIRE_EQUAL(get_total_stake(created[1])["cpu_weight"].as<asset>(), eos("0.5000"));
+   BOOST_REQUIRE_EQUAL(get_total_stake(created[2])["cpu_weight"].as<asset>(), eos("0.0000"));
+
+   // the accounts are usable with their key
+   eosio_token.transfer(eos_name, created[0], eos("1.0000"));
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(created[0], xyz_name, eos("1.0000")), success());
+   BOOST_REQUIRE_EQUAL(get_xyz_balance(created[0]), xyz("1.0000"));
+
+   BOOST_REQUIRE_EXCEPTION(newaccounts({}), eosio_assert_message_exception,
+                           eosio_assert_message_is("no accounts to create"));
+   BOOST_REQUIRE_EXCEPTION(newaccounts({ spec("newuserd1111"_n, 4000, eos("1.0000"), xyz("0.0000")) }),
+                           eosio_assert_message_exception, eosio_assert_message_is("Wrong token used"));
+   BOOST_REQUIRE_EXCEPTION(newaccounts({ spec("newuserd1111"_n, 4000, xyz("-1.0000"), xyz("0.0000")) }),
+                           eosio_assert_message_exception, eosio_assert_message_is("must stake a non-negative amount"));
+   BOOST_REQUIRE_EXCEPTION(newaccounts({ spec("newuserd1111"_n, 0, xyz("461168601842738.7903"), xyz("0.0001")) }),
+                           eosio_assert_message_exception, eosio_assert_message_is("batch total overflows"));
+
+} FC_LOG_AND_RETHROW()
+
+
+// ----------------------------
+// test: `provision`, many receivers provisioned with a single swap
+// ----------------------------
+BOOST_FIXTURE_TEST_CASE(batch_provision, eosio_system_tester) try {
+   const std::vector<account_name> accounts = { "alice"_n, "bob"_n, "carol"_n, "dave"_n };
+   create_accounts_with_resources( accounts );
+   const account_name alice = accounts[0];
+   const account_name bob   = accounts[1];
+   const account_name carol = accounts[2];
+   const account_name dave  = accounts[3];
+
+   eosio_token.transfer(eos_name, alice, eos("1000.0000"));
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("500.0000")), success());
+   base_tester::push_action(eos_name, "cfgpowerup"_n, eos_name,
+                            mvo()("args", make_powerup_config(get_pending_block_time())));
+   produce_block();
+
+   auto request = [](account_name receiver, uint8_t kind, const asset& quantity, const asset& cpu_quantity,
+                     int64_t frac = 0) {
+      return mvo()("receiver", receiver)("kind", kind)("quantity", quantity)("cpu_quantity", cpu_quantity)
+                  ("days", frac ? 30 : 0)("net_frac", frac)("cpu_frac", frac);
+   };
+   auto provision = [&](const std::vector<mvo>& requests) {
+      auto trace = base_tester::push_action( xyz_name, "provision"_n, alice, mvo()
+         ("payer", alice)
+         ("requests", requests)
+      );
+      produce_block();
+      return trace;
+   };
+   auto count = [](const transaction_trace_ptr& trace, action_name act) {
+      return std::count_if(trace->action_traces.begin(), trace->action_traces.end(),
+                           [&](const auto& t) { return t.act.name == act && t.receiver == t.act.account; });
+   };
+
+   // ram, stake and powerup: one swap in, one sweep out
+   // ---------------------------------------------------
+   const auto bob_ram   = get_ram_bytes(bob);
+   const auto carol_cpu = get_total_stake(carol)["cpu_weight"].as<asset>();
+   const auto dave_cpu  = get_cpu_limit(dave);
+   const auto trace     = provision({ request(bob, 0, xyz("10.0000"), xyz("0.0000")),
+                                      request(carol, 1, xyz("1.0000"), xyz("2.0000")),
+                                      request(dave, 2, xyz("100.0000"), xyz("0.0000"), powerup_frac / 1000),
+                                      request(bob, 1, xyz("0.5000"), xyz("0.5000")) });
+   BOOST_REQUIRE_EQUAL(count(trace, "swaptrace"_n), 1);
+   BOOST_REQUIRE_EQUAL(count(trace, "swapexcess"_n), 1);
+   BOOST_REQUIRE_EQUAL(count(trace, "buyram"_n), 1);
+   BOOST_REQUIRE_EQUAL(count(trace, "delegatebw"_n), 2);
+   BOOST_REQUIRE_EQUAL(count(trace, "powerup"_n), 1);
+
+   BOOST_REQUIRE(get_ram_bytes(bob) > bob_ram);
+   BOOST_REQUIRE_EQUAL(get_total_stake(carol)["cpu_weight"].as<asset>(), carol_cpu + eos("2.0000"));
+   BOOST_REQUIRE(get_cpu_limit(dave) > dave_cpu);
+
+   // the powerup's fee is all that is spent besides the RAM and stake, the rest came back as XYZ
+   BOOST_REQUIRE_EQUAL(get_eos_balance(alice), eos("500.0000"));
+   const asset spent = xyz("500.0000") - get_xyz_balance(alice);
+   BOOST_REQUIRE(spent > xyz("14.0000") && spent < xyz("114.0000"));
+
+   // without powerups there is nothing to sweep
+   BOOST_REQUIRE_EQUAL(count(provision({ request(bob, 0, xyz("1.0000"), xyz("0.0000")) }), "swapexcess"_n), 0);
+
+   BOOST_REQUIRE_EXCEPTION(provision({}), eosio_assert_message_exception,
+                           eosio_assert_message_is("nothing to provision"));
+   BOOST_REQUIRE_EXCEPTION(provision({ request(bob, 3, xyz("1.0000"), xyz("0.0000")) }),
+                           eosio_assert_message_exception, eosio_assert_message_is("invalid provision kind"));
+   BOOST_REQUIRE_EXCEPTION(provision({ request(bob, 1, xyz("1.0000"), eos("1.0000")) }),
+                           eosio_assert_message_exception, eosio_assert_message_is("Wrong token used"));
+   BOOST_REQUIRE_EXCEPTION(provision({ request(bob, 0, xyz("-1.0000"), xyz("0.0000")) }),
+                           eosio_assert_message_exception,
+                           eosio_assert_message_is("must provision a non-negative amount"));
+   BOOST_REQUIRE_EXCEPTION(provision({ request(bob, 1, xyz("461168601842738.7903"), xyz("0.0000")),
+                                       request(carol, 0, xyz("0.0001"), xyz("0.0000")) }),
+                           eosio_assert_message_exception, eosio_assert_message_is("batch total overflows"));
+
+} FC_LOG_AND_RETHROW()
+
+
+// ----------------------------
+// test: the typed codec of the tester (xyz_codec.hpp) against the ABI
+// ----------------------------
+BOOST_FIXTURE_TEST_CASE(typed_codec, eosio_system_tester) try {
+   const account_name alice = "alice1111111"_n;
+   const account_name bob   = "bob111111111"_n;
+   eosio_token.transfer(eos_name, alice, eos("100.0000"));
+   BOOST_REQUIRE_EQUAL(eosio_token.transfer(alice, xyz_name, eos("10.0000")), success());
+
+   // action arguments: the same bytes as `variant_to_binary`
+   auto abi_bytes = [&](action_name act, const mvo& data) { return contract::serialize(xyz_abi_ser, act, data); };
+   BOOST_REQUIRE(xyz_codec::pack(xyz_codec::transfer{alice, bob, xyz("1.0000"), "memo"}) ==
+                 abi_bytes("transfer"_n, mvo()("from", alice)("to", bob)("quantity", xyz("1.0000"))("memo", "memo")));
+   BOOST_REQUIRE(xyz_codec::pack(xyz_codec::open{alice, xyz_symbol(), bob}) ==
+                 abi_bytes("open"_n, mvo()("owner", alice)("symbol", xyz_symbol())("ram_payer", bob)));
+   BOOST_REQUIRE(xyz_codec::pack(xyz_codec::buyrambytes{alice, bob, 1000}) ==
+                 abi_bytes("buyrambytes"_n, mvo()("payer", alice)("receiver", bob)("bytes", 1000)));
+   BOOST_REQUIRE(xyz_codec::pack(xyz_codec::ramtransfer{alice, bob, 100, ""}) ==
+                 abi_bytes("ramtransfer"_n, mvo()("from", alice)("to", bob)("bytes", 100)("memo", "")));
+   BOOST_REQUIRE(xyz_codec::pack(xyz_codec::delegatebw{alice, bob, xyz("1.0000"), xyz("2.0000"), true}) ==
+                 abi_bytes("delegatebw"_n, mvo()("from", alice)("receiver", bob)("stake_net_quantity", xyz("1.0000"))(
+                                              "stake_cpu_quantity", xyz("2.0000"))("transfer", true)));
+
+   // rows: the same values as `binary_to_variant`
+   const auto code    = xyz_symbol().to_symbol_code().value;
+   const auto row     = get_row_by_account(xyz_name, alice, "accounts"_n, account_name(code));
+   const auto account = xyz_abi_ser.binary_to_variant("account", row, abi_serializer_max_time);
+   BOOST_REQUIRE_EQUAL(get_xyz_balance(alice), account["balance"].as<asset>());
+   BOOST_REQUIRE_EQUAL(get_xyz_account_released(alice), account["released"].as<int8_t>());
+
+   const auto stats = xyz_abi_ser.binary_to_variant(
+      "currency_stats", get_row_by_account(xyz_name, account_name(code), "stat"_n, account_name(code)),
+      abi_serializer_max_time);
+   BOOST_REQUIRE_EQUAL(get_xyz_stats().supply, stats["supply"].as<asset>());
+   BOOST_REQUIRE_EQUAL(get_xyz_stats().max_supply, stats["max_supply"].as<asset>());
+   BOOST_REQUIRE_EQUAL(get_xyz_stats().issuer, stats["issuer"].as<name>());
+
+   // `config` and its binary extensions
+   BOOST_REQUIRE_EQUAL(get_xyz_config().token_symbol, xyz_symbol());
+   base_tester::push_action(xyz_name, "setaudit"_n, xyz_name, mvo()("mode", 1));
+   produce_block();
+   BOOST_REQUIRE(get_xyz_config().swap_audit == std::optional<uint8_t>(1));
+
+   // `blocked`
+   BOOST_REQUIRE(!is_swapto_blocked(bob));
+   base_tester::push_action(xyz_name, "blockswapto"_n, bob, mvo()("account", bob)("block", true));
+   produce_block();
+   BOOST_REQUIRE(is_swapto_blocked(bob));
+
+} FC_LOG_AND_RETHROW()
+
+
+// ----------------------------
+// test: heap allocations on the hot paths, using the instrumented build of the contract
+// ----------------------------
+BOOST_FIXTURE_TEST_CASE(hot_path_allocations, eosio_system_tester) try {
+   use_instrumented_contract();
+
+   const std::vector<account_name> accounts = { "alice"_n, "bob"_n };
+   create_accounts_with_resources( accounts );
+   const account_name alice = accounts[0];
+   const account_name bob = accounts[1];
+
+   eosio_token.transfer(eos_name, alice, eos("100.0000"));
+
+   // every tracked scope must have run and must not have allocated
+   auto report = [&](const std::string& scenario, const transaction_trace_ptr& trace,
+                     const std::vector<std::string>& labels) {
+      produce_block();
+      auto counts = get_alloc_counts(trace);
+      for (const auto& label : labels) {
+         BOOST_REQUIRE_MESSAGE(counts.count(label), scenario << ": no allocation report for " << label);
+         BOOST_TEST_MESSAGE(scenario << " / " << label << ": " << counts[label] << " allocations");
+         BOOST_REQUIRE_EQUAL(counts[label], 0u);
+      }
+      return counts;
+   };
+
+   // EOS -> XYZ swap through the eosio.token notification
+   report("swap in", base_tester::push_action("eosio.token"_n, "transfer"_n, alice, mvo()
+             ("from", alice)("to", xyz_name)("quantity", eos("50.0000"))("memo", "")),
+          {"on_transfer", "transfer"});
+
+   // plain XYZ transfer between users
+   report("transfer", base_tester::push_action(xyz_name, "transfer"_n, alice, mvo()
+             ("from", alice)("to", bob)("quantity", xyz("1.0000"))("memo", "")),
+          {"transfer"});
+
+   // XYZ -> EOS swap
+   report("swap out", base_tester::push_action(xyz_name, "transfer"_n, alice, mvo()
+             ("from", alice)("to", xyz_name)("quantity", xyz("1.0000"))("memo", "")),
+          {"transfer", "credit_eos_to"});
+
+   // swap & withdraw in both directions
+   report("swapto eos", base_tester::push_action(xyz_name, "swapto"_n, alice, mvo()
+             ("from", alice)("to", bob)("quantity", eos("1.0000"))("memo", "")),
+          {"swapto", "on_transfer", "transfer"});
+   report("swapto xyz", base_tester::push_action(xyz_name, "swapto"_n, alice, mvo()
+             ("from", alice)("to", bob)("quantity", xyz("1.0000"))("memo", "")),
+          {"swapto", "transfer", "credit_eos_to"});
+
+   // swap helpers used by the forwarding actions
+   report("buyram", base_tester::push_action(xyz_name, "buyram"_n, alice, mvo()
+             ("payer", alice)("receiver", alice)("quant", xyz("1.0000"))),
+          {"swap_before_forwarding", "credit_eos_to"});
+   report("withdraw", [&]() {
+             base_tester::push_action(xyz_name, "deposit"_n, alice, mvo()("owner", alice)("amount", xyz("1.0000")));
+             produce_block();
+             return base_tester::push_action(xyz_name, "withdraw"_n, alice, mvo()
+                ("owner", alice)("amount", xyz("1.0000")));
+          }(),
+          {"swap_after_forwarding", "on_transfer", "transfer"});
+
+} FC_LOG_AND_RETHROW()
+
+// ----------------------------
+// test: resources used by the swap paths and the forwarders, against tests/budgets.json
+// ----------------------------
+BOOST_FIXTURE_TEST_CASE(resource_budgets, eosio_system_tester) try {
+   const std::vector<account_name> accounts = { "alice"_n, "bob"_n };
+   create_accounts_with_resources( accounts );
+   const account_name alice = accounts[0];
+   const account_name bob = accounts[1];
+
+   eosio_token.transfer(eos_name, alice, eos("100.0000"));
+
+   auto gate = [&](const std::string& scenario, const transaction_trace_ptr& trace) {
+      produce_block();
+      resource_budget::check("xyz/" + scenario, trace);
+   };
+
+   gate("swap in", base_tester::push_action("eosio.token"_n, "transfer"_n, alice, mvo()
+           ("from", alice)("to", xyz_name)("quantity", eos("50.0000"))("memo", "")));
+   gate("transfer", base_tester::push_action(xyz_name, "transfer"_n, alice, mvo()
+           ("from", alice)("to", bob)("quantity", xyz("1.0000"))("memo", "")));
+   gate("swap out", base_tester::push_action(xyz_name, "transfer"_n, alice, mvo()
+           ("from", alice)("to", xyz_name)("quantity", xyz("1.0000"))("memo", "")));
+   gate("swapto eos", base_tester::push_action(xyz_name, "swapto"_n, alice, mvo()
+           ("from", alice)("to", bob)("quantity", eos("1.0000"))("memo", "")));
+   gate("swapto xyz", base_tester::push_action(xyz_name, "swapto"_n, alice, mvo()
+           ("from", alice)("to", bob)("quantity", xyz("1.0000"))("memo", "")));
+   gate("buyram", base_tester::push_action(xyz_name, "buyram"_n, alice, mvo()
+           ("payer", alice)("receiver", alice)("quant", xyz("1.0000"))));
+   gate("buyrambytes", base_tester::push_action(xyz_name, "buyrambytes"_n, alice, mvo()
+           ("payer", alice)("receiver", alice)("bytes", 1000)));
+   gate("delegatebw", base_tester::push_action(xyz_name, "delegatebw"_n, alice, mvo()
+           ("from", alice)("receiver", bob)("stake_net_quantity", xyz("1.0000"))
+           ("stake_cpu_quantity", xyz("1.0000"))("transfer", false)));
+   gate("undelegatebw", base_tester::push_action(xyz_name, "undelegatebw"_n, alice, mvo()
+           ("from", alice)("receiver", bob)("unstake_net_quantity", xyz("1.0000"))
+           ("unstake_cpu_quantity", xyz("1.0000"))));
+   gate("deposit", base_tester::push_action(xyz_name, "deposit"_n, alice, mvo()
+           ("owner", alice)("amount", xyz("1.0000"))));
+   gate("withdraw", base_tester::push_action(xyz_name, "withdraw"_n, alice, mvo()
+           ("owner", alice)("amount", xyz("1.0000"))));
+
+} FC_LOG_AND_RETHROW()
+
 // --------------------------------------------------------------------------------
 // test: buyram, buyramburn, buyramself, ramburn, buyrambytes, ramtransfer, sellram
 // --------------------------------------------------------------------------------
@@ -1567,32 +2476,8 @@ BOOST_FIXTURE_TEST_CASE( misc, eosio_system_tester ) try {
     // should be able to powerup and get overages back in XYZ
     {
         // configure powerup
-        {
-            powerup_config config;
-
-            config.net.current_weight_ratio = powerup_frac / 4;
-            config.net.target_weight_ratio  = powerup_frac / 100;
-            config.net.assumed_stake_weight = stake_weight;
-            config.net.target_timestamp     = time_point_sec(get_pending_block_time() + fc::days(100));
-            config.net.exponent             = 2;
-            config.net.decay_secs           = fc::days(1).to_seconds();
-            config.net.min_price            = asset::from_string("0.0000 EOS");
-            config.net.max_price            = asset::from_string("1000000.0000 EOS");
-
-            config.cpu.current_weight_ratio = powerup_frac / 4;
-            config.cpu.target_weight_ratio  = powerup_frac / 100;
-            config.cpu.assumed_stake_weight = stake_weight;
-            config.cpu.target_timestamp     = time_point_sec(get_pending_block_time() + fc::days(100));
-            config.cpu.exponent             = 2;
-            config.cpu.decay_secs           = fc::days(1).to_seconds();
-            config.cpu.min_price            = asset::from_string("0.0000 EOS");
-            config.cpu.max_price            = asset::from_string("1000000.0000 EOS");
-
-            config.powerup_days    = 30;
-            config.min_powerup_fee = asset::from_string("1.0000 EOS");
-
-            base_tester::push_action(eos_name, "cfgpowerup"_n, eos_name, mvo()("args", config));
-        }
+        base_tester::push_action(eos_name, "cfgpowerup"_n, eos_name,
+                                 mvo()("args", make_powerup_config(get_pending_block_time())));
 
         auto old_balance = get_xyz_balance(powerupuser);
 
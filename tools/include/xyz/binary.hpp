@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace xyz_tools {
+
+   // Raised when a buffer ends before the value being decoded, or holds something that can't be decoded.
+   struct decode_error : std::runtime_error {
+      using std::runtime_error::runtime_error;
+   };
+
+   /**
+    * Zero-copy reader over a little-endian buffer packed like `fc::raw` / `eosio::datastream`.
+    *
+    * Strings and byte arrays are returned as views into the buffer, so the buffer must outlive them.
+    */
+   class reader {
+   public:
+      reader(const char* begin, const char* end)
+         : _pos(begin)
+         , _end(end) {}
+
+      explicit reader(std::string_view data)
+         : reader(data.data(), data.data() + data.size()) {}
+
+      template <typename T>
+      T read() {
+         static_assert(std::is_trivially_copyable_v<T>);
+         require(sizeof(T));
+         T value;
+         std::memcpy(&value, _pos, sizeof(T));
+         _pos += sizeof(T);
+         return value;
+      }
+
+      bool read_bool() { return read<uint8_t>() != 0; }
+
+      uint32_t read_varuint32() {
+         uint64_t value = 0;
+         for (uint32_t shift = 0;; shift += 7) {
+            if (shift >= 35)
+               throw decode_error("varuint32 is too long");
+            const uint8_t b = read<uint8_t>();
+            value |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80))
+               break;
+         }
+         return uint32_t(value);
+      }
+
+      // A length-prefixed byte array or string.
+      std::string_view read_bytes() {
+         const uint32_t size = read_varuint32();
+         return read_view(size);
+      }
+
+      std::string_view read_view(size_t size) {
+         require(size);
+         std::string_view view(_pos, size);
+         _pos += size;
+         return view;
+      }
+
+      // A NUL terminated string, the terminator is consumed but not returned.
+      std::string_view read_cstring() {
+         const void* nul = std::memchr(_pos, 0, remaining());
+         if (!nul)
+            throw decode_error("unterminated string");
+         std::string_view view(_pos, static_cast<const char*>(nul) - _pos);
+         _pos += view.size() + 1;
+         return view;
+      }
+
+      void skip(size_t size) {
+         require(size);
+         _pos += size;
+      }
+
+      const char* pos() const { return _pos; }
+      size_t      remaining() const { return _end - _pos; }
+      bool        empty() const { return _pos == _end; }
+
+   private:
+      void require(size_t size) const {
+         if (size > remaining())
+            throw decode_error("unexpected end of data");
+      }
+
+      const char* _pos;
+      const char* _end;
+   };
+
+   // Appends values to a buffer in the same format `reader` consumes.
+   class writer {
+   public:
+      explicit writer(std::vector<char>& out)
+         : _out(out) {}
+
+      template <typename T>
+      void write(const T& value) {
+         static_assert(std::is_trivially_copyable_v<T>);
+         append(&value, sizeof(T));
+      }
+
+      void write_bool(bool value) { write<uint8_t>(value ? 1 : 0); }
+
+      void write_varuint32(uint32_t value) {
+         do {
+            uint8_t b = value & 0x7f;
+            value >>= 7;
+            write<uint8_t>(b | (value ? 0x80 : 0));
+         } while (value);
+      }
+
+      void write_bytes(std::string_view data) {
+         write_varuint32(data.size());
+         write_raw(data);
+      }
+
+      void write_raw(std::string_view data) { append(data.data(), data.size()); }
+
+      void write_cstring(std::string_view s) {
+         write_raw(s);
+         write<char>(0);
+      }
+
+      // Overwrites a fixed size value written earlier at `offset`.
+      template <typename T>
+      void patch(size_t offset, const T& value) {
+         std::memcpy(_out.data() + offset, &value, sizeof(T));
+      }
+
+      size_t size() const { return _out.size(); }
+
+   private:
+      void append(const void* data, size_t size) {
+         const size_t offset = _out.size();
+         _out.resize(offset + size);
+         if (size)
+            std::memcpy(_out.data() + offset, data, size);
+      }
+
+      std::vector<char>& _out;
+   };
+
+} // namespace xyz_tools
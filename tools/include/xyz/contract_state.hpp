@@ -0,0 +1,95 @@
+#pragma once
+
+#include <xyz/snapshot.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace xyz_tools {
+
+   // The tables of one deployment of the system contract, read from a snapshot.
+   // Account rows are kept packed (views into the snapshot) and decoded on demand, in parallel.
+   struct contract_state {
+      name                          code;
+      std::optional<config>         cfg;
+      std::optional<solvency_stats> solvency;
+      std::vector<currency_stats>   stats;
+      std::vector<table_row>        accounts; // in snapshot order
+      std::vector<name>             blocked;
+      std::optional<asset>          eos_held;   // the contract's balance on the EOS token contract
+      uint64_t                      tables = 0; // every table in the snapshot, of any contract
+   };
+
+   contract_state load_contract_state(const snapshot& snap, name code, name eos_token = "eosio.token"_n);
+
+   // ----------------------------------------------------
+   // reconciliation -------------------------------------
+   // ----------------------------------------------------
+
+   struct token_reconciliation {
+      currency_stats stat;
+      __int128       holder_sum       = 0; // balances of every account but the contract's own
+      uint64_t       holders          = 0;
+      uint64_t       released         = 0;
+      asset          reserve;              // the reserve the contract accounts for, see `reconcile`
+      bool           implicit_reserve = false;
+
+      __int128 total() const { return holder_sum + reserve.amount; }
+      bool     ok() const { return total() == stat.supply.amount; }
+   };
+
+   struct reconciliation {
+      std::vector<token_reconciliation> tokens;
+      // `solvency` counters that disagree with the balances, empty when they agree or are missing.
+      // Reported as warnings: EOS sent to the contract outside of a swap legitimately moves them apart.
+      std::vector<std::string>          solvency_mismatches;
+
+      // Whether every token balances, the solvency counters are not taken into account.
+      bool ok() const;
+   };
+
+   /**
+    * Checks that, for every token of the contract, the balances sum up to `stat.supply`.
+    *
+    * The reserve is the contract's own balance row, or when the reserve is implicit (see `setreserve`)
+    * the supply less the circulating XYZ of the solvency counters. The account rows are decoded on `threads` threads.
+    */
+   reconciliation reconcile(const contract_state& state, unsigned threads);
+
+   // ----------------------------------------------------
+   // diffing --------------------------------------------
+   // ----------------------------------------------------
+
+   struct account_change {
+      name                   owner;
+      symbol                 sym;
+      std::optional<account> before; // missing if the row was created
+      std::optional<account> after;  // missing if the row was erased
+      name                   payer_before;
+      name                   payer_after;
+   };
+
+   struct state_diff {
+      std::vector<account_change> accounts;  // ordered by owner, then symbol
+      std::vector<std::string>    singletons; // changes of `config`, `stat` and `solvency`, one line each
+      std::vector<name>           blocked_added;
+      std::vector<name>           blocked_removed;
+
+      uint64_t created          = 0;
+      uint64_t erased           = 0;
+      uint64_t balance_changed  = 0;
+      uint64_t released_changed = 0;
+      uint64_t payer_changed    = 0;
+
+      bool empty() const {
+         return accounts.empty() && singletons.empty() && blocked_added.empty() && blocked_removed.empty();
+      }
+   };
+
+   // Compares two states of the same contract. The account rows are sorted and compared on `threads` threads.
+   state_diff diff(const contract_state& before, const contract_state& after, unsigned threads);
+
+   std::string to_string(const account_change& change);
+
+} // namespace xyz_tools
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace xyz_tools {
+
+   // The number of worker threads to use when none is requested.
+   inline unsigned default_threads() { return std::max(1u, std::thread::hardware_concurrency()); }
+
+   /**
+    * Splits [0, n) into `threads` contiguous chunks and calls `fn(begin, end, chunk)` for each, in parallel.
+    * Chunks are numbered in order, so per-chunk results can be combined in input order.
+    * The first exception thrown by a chunk is rethrown once every chunk is done.
+    */
+   template <typename Fn>
+   void parallel_chunks(size_t n, unsigned threads, Fn&& fn) {
+      threads = std::max(1u, unsigned(std::min<size_t>(threads, n ? n : 1)));
+      if (threads == 1) {
+         fn(size_t(0), n, 0u);
+         return;
+      }
+
+      std::vector<std::thread>        workers;
+      std::vector<std::exception_ptr> errors(threads);
+      workers.reserve(threads);
+      for (unsigned t = 0; t < threads; ++t) {
+         const size_t begin = n * t / threads;
+         const size_t end   = n * (t + 1) / threads;
+         workers.emplace_back([&fn, &errors, begin, end, t] {
+            try {
+               fn(begin, end, t);
+            } catch (...) {
+               errors[t] = std::current_exception();
+            }
+         });
+      }
+      for (auto& w : workers)
+         w.join();
+      for (const auto& e : errors)
+         if (e)
+            std::rethrow_exception(e);
+   }
+
+   // Sorts the chunks of a range in parallel, then merges them pairwise, also in parallel.
+   template <typename It, typename Compare>
+   void parallel_sort(It first, It last, unsigned threads, Compare cmp) {
+      const size_t n = last - first;
+      if (threads <= 1 || n < 4096) {
+         std::sort(first, last, cmp);
+         return;
+      }
+
+      std::vector<size_t> bounds;
+      parallel_chunks(n, threads, [&](size_t begin, size_t end, unsigned) { std::sort(first + begin, first + end, cmp); });
+      for (unsigned t = 0; t <= threads; ++t)
+         bounds.push_back(n * t / threads);
+
+      while (bounds.size() > 2) {
+         std::vector<size_t> merged;
+         const size_t        pairs = (bounds.size() - 1) / 2;
+         parallel_chunks(pairs, threads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t p = begin; p < end; ++p)
+               std::inplace_merge(first + bounds[2 * p], first + bounds[2 * p + 1], first + bounds[2 * p + 2], cmp);
+         });
+         for (size_t i = 0; i < bounds.size(); i += 2)
+            merged.push_back(bounds[i]);
+         if (merged.back() != n)
+            merged.push_back(n);
+         bounds = std::move(merged);
+      }
+   }
+
+} // namespace xyz_tools
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <xyz/types.hpp>
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace xyz_tools {
+
+   // ----------------------------------------------------
+   // events ---------------------------------------------
+   // ----------------------------------------------------
+
+   // Every view in an event points into the message it was decoded from.
+
+   // An XYZ `transfer` action of the contract, including transfers to the contract that swap XYZ to EOS.
+   struct transfer_event {
+      uint32_t         block_num       = 0;
+      std::string_view trx_id;          // 32 bytes
+      uint64_t         global_sequence = 0;
+      name             from;
+      name             to;
+      asset            quantity;
+      std::string_view memo;
+   };
+
+   enum class swap_direction : uint8_t {
+      to_xyz, // EOS received by the contract and credited as XYZ: transfers, `swapto`, `swapexcess`
+      to_eos, // XYZ debited and paid out as EOS: transfers to the contract, `swapto`, every forwarding action
+   };
+
+   // One swap, whatever action caused it and whatever the contract's swap audit mode. Swaps are read from the
+   // EOS side: the `eosio.token` transfers the contract is notified of.
+   struct swap_event {
+      uint32_t         block_num       = 0;
+      std::string_view trx_id;
+      uint64_t         global_sequence = 0;
+      swap_direction   direction       = swap_direction::to_xyz;
+      name             account;         // the account whose XYZ balance is credited or debited
+      asset            quantity;        // in EOS
+   };
+
+   // A change of a row of the contract's `accounts` table.
+   struct balance_event {
+      uint32_t block_num = 0;
+      name     owner;
+      bool     present   = false; // false when the row was erased, `row` then holds its last value
+      name     payer;
+      account  row;
+   };
+
+   // An action as a transaction requested it.
+   struct recorded_action {
+      name                               account;
+      name                               act;
+      std::vector<std::pair<name, name>> authorization; // actor, permission
+      std::string_view                   data;
+   };
+
+   // An executed transaction whose actions all go to the contract or to the EOS token contract, with what it was
+   // billed, so that it can be replayed. Only decoded with `decoder_options::transactions`.
+   struct transaction_event {
+      uint32_t                     block_num       = 0;
+      std::string_view             trx_id;
+      uint32_t                     cpu_usage_us    = 0;
+      uint32_t                     net_usage_words = 0;
+      int64_t                      elapsed_us      = 0;
+      std::vector<recorded_action> actions;
+   };
+
+   struct event_batch {
+      std::vector<transfer_event>    transfers;
+      std::vector<swap_event>        swaps;
+      std::vector<balance_event>     balances;
+      std::vector<transaction_event> transactions;
+
+      size_t size() const { return transfers.size() + swaps.size() + balances.size() + transactions.size(); }
+      void   clear() {
+         transfers.clear();
+         swaps.clear();
+         balances.clear();
+         transactions.clear();
+      }
+   };
+
+   // ----------------------------------------------------
+   // decoder --------------------------------------------
+   // ----------------------------------------------------
+
+   struct decoder_options {
+      name   code         = "xyz"_n;         // account the contract is deployed to
+      name   eos_token    = "eosio.token"_n; // EOS token contract
+      size_t batch_size   = 4096;            // events per batch handed to the sink
+      bool   transactions = false;           // also emit a `transaction_event` per replayable transaction
+   };
+
+   struct decoder_stats {
+      uint64_t messages     = 0;
+      uint64_t blocks       = 0;
+      uint64_t transactions = 0; // executed transactions, failed ones are skipped
+      uint64_t actions      = 0; // action traces, of every contract
+      uint64_t rows         = 0; // contract table rows in the deltas, of every contract
+      uint64_t events       = 0;
+      uint64_t bytes        = 0;
+   };
+
+   /**
+    * Streaming decoder of state history (SHiP) results, emitting the contract's transfers, swaps and balance
+    * changes as typed events.
+    *
+    * Messages are `result` variants as sent by the state history plugin: `get_blocks_result_v0`, or `v1` whose
+    * extra fields are ignored; status results are skipped. Only the trace and delta fields this contract
+    * needs are decoded. Everything else, including other contracts' action data and table rows, is skipped
+    * in place without copying. Events keep views into the message, so a batch is only valid while the
+    * messages it was decoded from are.
+    */
+   class ship_decoder {
+   public:
+      using sink = std::function<void(const event_batch&)>;
+
+      ship_decoder(decoder_options options, sink on_batch);
+
+      void decode_message(std::string_view message);
+
+      // Hands any pending events to the sink.
+      void flush();
+
+      const decoder_stats& stats() const { return _stats; }
+
+   private:
+      void decode_traces(reader& r, uint32_t block_num);
+      void decode_transaction(reader& r, uint32_t block_num, bool emit);
+      void decode_action(reader& r, uint32_t block_num, std::string_view trx_id, bool emit, transaction_event* trx);
+      void decode_deltas(reader& r, uint32_t block_num);
+      void emitted();
+
+      decoder_options _options;
+      sink            _on_batch;
+      event_batch     _batch;
+      decoder_stats   _stats;
+   };
+
+   /**
+    * Decodes every message of a recording: a sequence of frames, each a `uint32_t` byte count followed
+    * by one message exactly as it was received from the state history websocket.
+    */
+   void replay_recording(std::string_view recording, ship_decoder& decoder);
+
+} // namespace xyz_tools
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <xyz/ship.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace xyz_tools {
+
+   // Encoders for state history results, in the layout `ship_decoder` reads. Used by the synthetic
+   // recording generator and the tests.
+
+   struct trace_action {
+      name              receiver;
+      name              account;
+      name              act;
+      name              actor; // authorized as actor@active
+      std::vector<char> data;
+      uint64_t          global_sequence = 0;
+      std::vector<char> return_value;
+   };
+
+   struct trace_transaction {
+      std::array<char, 32>      id{};
+      bool                      executed = true; // failed transactions have no receipts and an exception
+      std::vector<trace_action> actions;
+      bool                      webauthn = false; // sign with a webauthn signature instead of a k1 one
+   };
+
+   // A `contract_row` delta.
+   struct trace_row {
+      bool              present = true;
+      name              code;
+      name              scope;
+      name              table;
+      uint64_t          primary_key = 0;
+      name              payer;
+      std::vector<char> value;
+   };
+
+   std::vector<char> encode_transfer(name from, name to, const asset& quantity, std::string_view memo);
+
+   // A `get_blocks_result_v0` with traces and deltas. `other_deltas` rows are added to a `resource_usage` delta.
+   std::vector<char> encode_blocks_result(uint32_t block_num, const std::vector<trace_transaction>& transactions,
+                                          const std::vector<trace_row>& rows, uint32_t other_deltas = 0);
+
+   // A `get_status_result_v0`.
+   std::vector<char> encode_status_result(uint32_t head);
+
+   // Appends a message to a recording, see `replay_recording`.
+   void append_frame(std::vector<char>& recording, const std::vector<char>& message);
+
+} // namespace xyz_tools
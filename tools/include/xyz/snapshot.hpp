@@ -0,0 +1,87 @@
+#pragma once
+
+#include <xyz/types.hpp>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xyz_tools {
+
+   // A read-only memory mapping of a whole file.
+   class mapped_file {
+   public:
+      explicit mapped_file(const std::string& path);
+      ~mapped_file();
+
+      mapped_file(const mapped_file&)            = delete;
+      mapped_file& operator=(const mapped_file&) = delete;
+
+      std::string_view data() const { return {_data, _size}; }
+
+   private:
+      const char* _data = nullptr;
+      size_t      _size = 0;
+   };
+
+   struct snapshot_section {
+      std::string_view name;
+      uint64_t         row_count = 0;
+      std::string_view rows; // the packed rows, after the section header
+   };
+
+   /**
+    * A portable binary chain snapshot, as written by `nodeos --snapshot` / `create_snapshot`.
+    *
+    * Layout: a `uint32_t` magic and `uint32_t` version, then sections until a `uint64_t(-1)` end marker.
+    * Each section starts with its size in bytes (not counting the size itself), its row count and its
+    * NUL terminated name, followed by the packed rows.
+    *
+    * The file is mapped, not read: sections and rows are views into the mapping.
+    */
+   class snapshot {
+   public:
+      static constexpr uint32_t magic = 0x30510550;
+
+      explicit snapshot(const std::string& path);
+
+      uint32_t                             version() const { return _version; }
+      const std::vector<snapshot_section>& sections() const { return _sections; }
+
+      // The section called `name`, throws if there is none.
+      const snapshot_section& section(std::string_view name) const;
+
+   private:
+      mapped_file                   _file;
+      uint32_t                      _version = 0;
+      std::vector<snapshot_section> _sections;
+   };
+
+   // Row of the primary index of a contract table, the value is a view into the snapshot.
+   struct table_row {
+      name             code;
+      name             scope;
+      name             table;
+      uint64_t         primary_key = 0;
+      name             payer;
+      std::string_view value;
+   };
+
+   // Decides from its header whether the rows of a table are wanted.
+   using table_filter = std::function<bool(name code, name scope, name table)>;
+
+   /**
+    * Walks the `contract_tables` section and calls `on_row` for every primary index row of the tables
+    * accepted by `filter`. Every other row, including all secondary index rows, is skipped without decoding.
+    *
+    * The section holds, for each table: the table header (code, scope, table, payer, row count), then for
+    * each of the six index types (primary, idx64, idx128, idx256, idx_double, idx_long_double) a
+    * `varuint32` row count followed by the rows.
+    *
+    * @return the number of tables in the section
+    */
+   uint64_t for_each_table_row(const snapshot& snap, const table_filter& filter,
+                               const std::function<void(const table_row&)>& on_row);
+
+} // namespace xyz_tools
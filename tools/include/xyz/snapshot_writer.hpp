@@ -0,0 +1,52 @@
+#pragma once
+
+#include <xyz/snapshot.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xyz_tools {
+
+   /**
+    * Builds a portable binary snapshot in memory, in the layout `snapshot` reads.
+    *
+    * Only the framing and the `contract_tables` section are meaningful; other sections are opaque blobs.
+    * Used by the synthetic snapshot generator and the tests.
+    */
+   class snapshot_writer {
+   public:
+      explicit snapshot_writer(uint32_t version = 8);
+
+      snapshot_writer(const snapshot_writer&)            = delete;
+      snapshot_writer& operator=(const snapshot_writer&) = delete;
+
+      // A section holding `rows` opaque rows.
+      void add_section(std::string_view name, uint64_t rows, std::string_view data);
+
+      // Starts the `contract_tables` section, ended by `end_contract_tables`.
+      void begin_contract_tables();
+
+      // A table with the given primary index rows, and `idx64_rows` rows in its first secondary index.
+      void add_table(name code, name scope, name table, name payer, const std::vector<table_row>& rows,
+                     uint32_t idx64_rows = 0);
+
+      void end_contract_tables();
+
+      // The snapshot, with its end marker.
+      const std::vector<char>& finish();
+
+      void write_file(const std::string& path);
+
+   private:
+      void begin_section(std::string_view name);
+      void end_section();
+
+      std::vector<char> _out;
+      writer            _w{_out};
+      size_t            _section_start = 0;
+      uint64_t          _section_rows  = 0;
+      bool              _finished      = false;
+   };
+
+} // namespace xyz_tools
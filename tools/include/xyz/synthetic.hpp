@@ -0,0 +1,52 @@
+#pragma once
+
+#include <xyz/snapshot_writer.hpp>
+
+namespace xyz_tools {
+
+   struct synthetic_options {
+      name     code             = "xyz"_n;
+      uint64_t holders          = 1000;
+      uint64_t seed             = 1;
+      uint64_t mutations        = 0;     // random swaps, transfers, releases and closes applied on top
+      bool     implicit_reserve = false; // write the state of a contract whose reserve is implicit
+      uint32_t foreign_every    = 64;    // one table of another contract, with secondary rows, every N holders
+   };
+
+   /**
+    * Builds a consistent snapshot of a deployment of the system contract: `config`, `stat`, `solvency`,
+    * `blocked`, one `accounts` row per holder plus the contract's reserve, and the contract's EOS balance,
+    * interleaved with unrelated tables that readers must skip.
+    *
+    * The same options always give the same snapshot. Two snapshots that only differ by `mutations` describe
+    * the same chain before and after some activity, for diffing.
+    */
+   void write_synthetic_snapshot(const synthetic_options& options, snapshot_writer& out);
+
+   struct synthetic_recording_options {
+      name     code         = "xyz"_n;
+      uint32_t blocks       = 100;
+      uint32_t transactions = 50; // per block
+      uint64_t seed         = 1;
+   };
+
+   // The events a decoder must find in a synthetic recording.
+   struct synthetic_recording_counts {
+      uint64_t transfers    = 0;
+      uint64_t swaps_to_xyz = 0;
+      uint64_t swaps_to_eos = 0;
+      uint64_t balances     = 0;
+   };
+
+   /**
+    * Appends a state history recording (see `replay_recording`) of blocks mixing the contract's transfers, swaps
+    * and forwarding actions with failed transactions, unrelated contracts, EOS moves the contract must not treat
+    * as swaps, and other deltas.
+    */
+   synthetic_recording_counts write_synthetic_recording(const synthetic_recording_options& options,
+                                                        std::vector<char>&                 out);
+
+   // The name of the `index`-th synthetic holder.
+   name synthetic_holder(uint64_t index);
+
+} // namespace xyz_tools
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <xyz/binary.hpp>
+
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Native mirrors of the on-chain types of the system contract, see contracts/include/system/system.entry.hpp.
+// They decode the rows and action data exactly as the contract packs them; the field order must follow
+// the contract's structs.
+
+namespace xyz_tools {
+
+   struct name {
+      uint64_t value = 0;
+
+      constexpr name() = default;
+      constexpr explicit name(uint64_t v)
+         : value(v) {}
+      explicit name(std::string_view str);
+
+      std::string to_string() const;
+
+      friend constexpr bool operator==(name a, name b) { return a.value == b.value; }
+      friend constexpr bool operator!=(name a, name b) { return a.value != b.value; }
+      friend constexpr bool operator<(name a, name b) { return a.value < b.value; }
+   };
+
+   struct symbol {
+      uint64_t value = 0; // precision in the low byte, code in the upper 7
+
+      constexpr symbol() = default;
+      constexpr explicit symbol(uint64_t v)
+         : value(v) {}
+      symbol(std::string_view code, uint8_t precision);
+
+      uint8_t     precision() const { return value & 0xff; }
+      uint64_t    code() const { return value >> 8; }
+      std::string code_string() const;
+
+      friend constexpr bool operator==(symbol a, symbol b) { return a.value == b.value; }
+      friend constexpr bool operator!=(symbol a, symbol b) { return a.value != b.value; }
+   };
+
+   struct asset {
+      int64_t amount = 0;
+      symbol  sym;
+
+      std::string to_string() const;
+
+      friend bool operator==(const asset& a, const asset& b) { return a.amount == b.amount && a.sym == b.sym; }
+      friend bool operator!=(const asset& a, const asset& b) { return !(a == b); }
+   };
+
+   // `system_contract::account`, table `accounts`, scope owner, primary key symbol code
+   struct account {
+      asset balance;
+      bool  released = false;
+   };
+
+   // `system_contract::currency_stats`, table `stat`, scope and primary key symbol code
+   struct currency_stats {
+      asset supply;
+      asset max_supply;
+      name  issuer;
+   };
+
+   // `system_contract::config`, singleton `config`
+   struct config {
+      symbol                 token_symbol;
+      std::optional<uint8_t> swap_audit;
+      std::optional<bool>    implicit_reserve;
+      std::optional<bool>    commitment;
+      std::optional<bool>    registry;
+   };
+
+   // `system_contract::solvency_stats`, singleton `solvency`
+   struct solvency_stats {
+      asset circulating;
+      asset eos_held;
+      asset swapped_in;
+      asset swapped_out;
+   };
+
+   // `system_contract::blocked_recipient`, table `blocked`, scope the contract, primary key the account
+   struct blocked_recipient {
+      name account;
+   };
+
+   std::ostream& operator<<(std::ostream& out, name v);
+   std::ostream& operator<<(std::ostream& out, const asset& v);
+
+   void decode(reader& r, name& v);
+   void decode(reader& r, symbol& v);
+   void decode(reader& r, asset& v);
+   void decode(reader& r, account& v);
+   void decode(reader& r, currency_stats& v);
+   void decode(reader& r, config& v);
+   void decode(reader& r, solvency_stats& v);
+   void decode(reader& r, blocked_recipient& v);
+
+   void encode(writer& w, name v);
+   void encode(writer& w, symbol v);
+   void encode(writer& w, const asset& v);
+   void encode(writer& w, const account& v);
+   void encode(writer& w, const currency_stats& v);
+   void encode(writer& w, const config& v);
+   void encode(writer& w, const solvency_stats& v);
+   void encode(writer& w, const blocked_recipient& v);
+
+   // Decodes a whole row, failing if bytes are left over.
+   template <typename T>
+   T decode_row(std::string_view data) {
+      reader r(data);
+      T      value;
+      decode(r, value);
+      if (!r.empty())
+         throw decode_error("trailing bytes after row");
+      return value;
+   }
+
+   template <typename T>
+   std::vector<char> encode_row(const T& value) {
+      std::vector<char> out;
+      writer            w(out);
+      encode(w, value);
+      return out;
+   }
+
+   inline namespace literals {
+      inline name operator""_n(const char* s, size_t n) { return name(std::string_view(s, n)); }
+   }
+
+} // namespace xyz_tools
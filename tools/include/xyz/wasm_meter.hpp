@@ -0,0 +1,55 @@
+#pragma once
+
+#include <xyz/binary.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xyz_tools {
+
+   // What `meter_wasm` did to a module.
+   struct meter_stats {
+      uint32_t functions    = 0; // function bodies metered
+      uint32_t segments     = 0; // counters inserted, one per straight-line run of instructions
+      uint32_t host_imports = 0; // imported functions whose calls are counted
+   };
+
+   // The counts a metered contract prints for one action, see `parse_meter_console`.
+   struct meter_counts {
+      uint64_t                                     instructions = 0;
+      uint64_t                                     host_calls   = 0; // all imported functions together
+      std::map<std::string, uint64_t, std::less<>> host;             // calls per imported function
+
+      meter_counts& operator+=(const meter_counts& other);
+   };
+
+   /**
+    * Instruments a contract so that every action reports how many WASM instructions it executed and how many
+    * times it called each host function. The counts don't depend on the runtime or on timing, so they can be
+    * compared across commits where billed CPU can't.
+    *
+    * Each straight-line run of instructions, up to and including the next branch, block boundary or return,
+    * starts by adding its length, and its calls to each imported function, to mutable `i64` globals. When the
+    * action ends, by returning from `apply` or by calling `eosio_exit`, the non-zero counters are printed to the
+    * action console as
+    *
+    *    meter:instructions:<count>
+    *    meter:host:<imported function>:<count>
+    *
+    * The lines are written from address 0 of the linear memory, which is discarded with the action anyway.
+    * `prints_l` and `printui` are imported when the module doesn't already import them, which shifts the indices
+    * of the module's own functions; the `name` section is dropped rather than renumbered. An action that fails
+    * prints nothing. The inserted instructions are not counted, but they are executed and billed.
+    *
+    * Throws `decode_error` for modules this pass doesn't handle, e.g. without an `apply` export or memory.
+    */
+   std::vector<char> meter_wasm(std::string_view wasm, meter_stats* stats = nullptr);
+
+   // Sums the `meter:` lines of an action console, ignoring every other line.
+   meter_counts parse_meter_console(std::string_view console);
+
+} // namespace xyz_tools
@@ -0,0 +1,77 @@
+// xyz-ship-bench: decodes a state history recording and reports the decoder's throughput.
+//
+//    xyz-ship-bench <recording> [--code <account>] [--batch <n>] [--repeat <n>]
+//
+// The recording is memory mapped and decoded `--repeat` times, the counts are those of one pass.
+
+#include <xyz/ship.hpp>
+#include <xyz/snapshot.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+using namespace xyz_tools;
+
+int main(int argc, char** argv) {
+   try {
+      decoder_options options;
+      std::string     path;
+      uint32_t        repeat = 1;
+      for (int i = 1; i < argc; ++i) {
+         const std::string arg = argv[i];
+         auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+               throw std::runtime_error(arg + " needs a value");
+            return argv[++i];
+         };
+         if (arg == "--code")
+            options.code = name(value());
+         else if (arg == "--batch")
+            options.batch_size = std::max<size_t>(1, std::stoull(value()));
+         else if (arg == "--repeat")
+            repeat = std::max<uint32_t>(1, std::stoul(value()));
+         else if (arg.starts_with("--") || !path.empty())
+            throw std::runtime_error("unexpected argument " + arg);
+         else
+            path = arg;
+      }
+      if (path.empty()) {
+         std::cerr << "usage: xyz-ship-bench <recording> [--code <account>] [--batch <n>] [--repeat <n>]\n";
+         return 2;
+      }
+
+      const mapped_file file(path);
+      decoder_stats     stats;
+      uint64_t          transfers = 0, swaps = 0, balances = 0;
+      const auto        start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < repeat; ++i) {
+         transfers = swaps = balances = 0;
+         ship_decoder decoder(options, [&](const event_batch& batch) {
+            transfers += batch.transfers.size();
+            swaps += batch.swaps.size();
+            balances += batch.balances.size();
+         });
+         replay_recording(file.data(), decoder);
+         stats = decoder.stats();
+      }
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      const double mb      = double(stats.bytes) * repeat / (1024 * 1024);
+
+      std::cout << std::fixed << std::setprecision(2) << "messages:     " << stats.messages << "\n"
+                << "blocks:       " << stats.blocks << "\n"
+                << "transactions: " << stats.transactions << "\n"
+                << "actions:      " << stats.actions << "\n"
+                << "rows:         " << stats.rows << "\n"
+                << "events:       " << stats.events << " (" << transfers << " transfers, " << swaps << " swaps, "
+                << balances << " balances)\n"
+                << "decoded:      " << mb << " MB in " << seconds << " s\n"
+                << "throughput:   " << std::setprecision(0) << double(stats.events) * repeat / seconds
+                << " events/s, " << std::setprecision(1) << mb / seconds
+                << " MB/s\n";
+      return 0;
+   } catch (const std::exception& e) {
+      std::cerr << "error: " << e.what() << "\n";
+      return 2;
+   }
+}
@@ -0,0 +1,59 @@
+// xyz-ship-gen: writes a synthetic state history recording of the system contract, for tests and benchmarks.
+//
+//    xyz-ship-gen <out> [--blocks <n>] [--transactions <n>] [--seed <n>] [--code <account>]
+//
+// Prints the events a decoder must find in it. The same options always give the same file.
+
+#include <xyz/synthetic.hpp>
+
+#include <fstream>
+#include <iostream>
+
+using namespace xyz_tools;
+
+int main(int argc, char** argv) {
+   try {
+      synthetic_recording_options options;
+      std::string                 out;
+      for (int i = 1; i < argc; ++i) {
+         const std::string arg = argv[i];
+         auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+               throw std::runtime_error(arg + " needs a value");
+            return argv[++i];
+         };
+         if (arg == "--blocks")
+            options.blocks = std::stoul(value());
+         else if (arg == "--transactions")
+            options.transactions = std::stoul(value());
+         else if (arg == "--seed")
+            options.seed = std::stoull(value());
+         else if (arg == "--code")
+            options.code = name(value());
+         else if (arg.starts_with("--") || !out.empty())
+            throw std::runtime_error("unexpected argument " + arg);
+         else
+            out = arg;
+      }
+      if (out.empty()) {
+         std::cerr << "usage: xyz-ship-gen <out> [--blocks <n>] [--transactions <n>] [--seed <n>] [--code <account>]\n";
+         return 2;
+      }
+
+      std::vector<char> recording;
+      const auto        counts = write_synthetic_recording(options, recording);
+      std::ofstream     file(out, std::ios::binary | std::ios::trunc);
+      file.write(recording.data(), recording.size());
+      if (!file)
+         throw std::runtime_error("cannot write " + out);
+
+      std::cout << "transfers:    " << counts.transfers << "\n"
+                << "swaps to XYZ: " << counts.swaps_to_xyz << "\n"
+                << "swaps to EOS: " << counts.swaps_to_eos << "\n"
+                << "balances:     " << counts.balances << "\n";
+      return 0;
+   } catch (const std::exception& e) {
+      std::cerr << "error: " << e.what() << "\n";
+      return 2;
+   }
+}
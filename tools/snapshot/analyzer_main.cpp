@@ -0,0 +1,139 @@
+// xyz-snapshot: offline audit of the system contract's tables in a portable chain snapshot.
+//
+//    xyz-snapshot reconcile <snapshot> [options]
+//       Checks that the balances of every token add up to its `stat.supply`, and that the `solvency`
+//       counters agree with them. Exits with 1 if a token does not balance.
+//
+//    xyz-snapshot diff <before> <after> [options]
+//       Lists the balance rows that were created, erased, or whose balance, `released` flag or RAM payer
+//       changed, along with changes of `config`, `stat`, `solvency` and `blocked`. Exits with 1 if anything changed.
+//
+// options:
+//    --code <account>     account the contract is deployed to (default: xyz)
+//    --token <account>    EOS token contract, for the contract's EOS balance (default: eosio.token)
+//    --threads <n>        worker threads (default: every core)
+//    --summary            diff: only print the counts
+
+#include <xyz/contract_state.hpp>
+#include <xyz/parallel.hpp>
+
+#include <chrono>
+#include <iostream>
+
+using namespace xyz_tools;
+
+namespace {
+
+   struct arguments {
+      std::string              command;
+      std::vector<std::string> files;
+      name                     code      = "xyz"_n;
+      name                     eos_token = "eosio.token"_n;
+      unsigned                 threads   = default_threads();
+      bool                     summary   = false;
+   };
+
+   int usage() {
+      std::cerr << "usage: xyz-snapshot reconcile <snapshot> [--code <account>] [--token <account>] [--threads <n>]\n"
+                   "       xyz-snapshot diff <before> <after> [--code <account>] [--token <account>] [--threads <n>] "
+                   "[--summary]\n";
+      return 2;
+   }
+
+   arguments parse(int argc, char** argv) {
+      arguments args;
+      if (argc > 1)
+         args.command = argv[1];
+      for (int i = 2; i < argc; ++i) {
+         const std::string arg = argv[i];
+         auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+               throw std::runtime_error(arg + " needs a value");
+            return argv[++i];
+         };
+         if (arg == "--code")
+            args.code = name(value());
+         else if (arg == "--token")
+            args.eos_token = name(value());
+         else if (arg == "--threads")
+            args.threads = std::max(1, std::stoi(value()));
+         else if (arg == "--summary")
+            args.summary = true;
+         else if (arg.starts_with("--"))
+            throw std::runtime_error("unknown option " + arg);
+         else
+            args.files.push_back(arg);
+      }
+      return args;
+   }
+
+   std::string amount(__int128 value, symbol sym) {
+      return value >= INT64_MIN && value <= INT64_MAX ? asset{int64_t(value), sym}.to_string() : "(out of range)";
+   }
+
+   double seconds_since(std::chrono::steady_clock::time_point start) {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   int run_reconcile(const arguments& args) {
+      const auto     start = std::chrono::steady_clock::now();
+      const snapshot snap(args.files[0]);
+      const auto     state  = load_contract_state(snap, args.code, args.eos_token);
+      const auto     result = reconcile(state, args.threads);
+
+      for (const auto& t : result.tokens) {
+         const symbol sym = t.stat.supply.sym;
+         std::cout << sym.code_string() << ": supply " << t.stat.supply.to_string() << ", holders "
+                   << amount(t.holder_sum, sym) << " over " << t.holders << " rows (" << t.released
+                   << " released), reserve " << t.reserve.to_string() << (t.implicit_reserve ? " (implicit)" : "")
+                   << ", total " << amount(t.total(), sym) << (t.ok() ? "  OK" : "  MISMATCH") << "\n";
+      }
+      for (const auto& m : result.solvency_mismatches)
+         std::cout << "warning: solvency counter " << m << "\n";
+
+      std::cerr << state.accounts.size() << " balance rows out of " << state.tables << " tables in "
+                << seconds_since(start) << "s\n";
+      return result.ok() ? 0 : 1;
+   }
+
+   int run_diff(const arguments& args) {
+      const auto     start = std::chrono::steady_clock::now();
+      const snapshot before_snap(args.files[0]), after_snap(args.files[1]);
+      const auto     before = load_contract_state(before_snap, args.code, args.eos_token);
+      const auto     after  = load_contract_state(after_snap, args.code, args.eos_token);
+      const auto     result = diff(before, after, args.threads);
+
+      if (!args.summary) {
+         for (const auto& line : result.singletons)
+            std::cout << "~ " << line << "\n";
+         for (auto account : result.blocked_added)
+            std::cout << "+ blocked " << account.to_string() << "\n";
+         for (auto account : result.blocked_removed)
+            std::cout << "- blocked " << account.to_string() << "\n";
+         for (const auto& change : result.accounts)
+            std::cout << to_string(change) << "\n";
+      }
+      std::cout << result.created << " created, " << result.erased << " erased, " << result.balance_changed
+                << " balances changed, " << result.released_changed << " released, " << result.payer_changed
+                << " payers changed\n";
+
+      std::cerr << before.accounts.size() << " and " << after.accounts.size() << " balance rows compared in "
+                << seconds_since(start) << "s\n";
+      return result.empty() ? 0 : 1;
+   }
+
+} // namespace
+
+int main(int argc, char** argv) {
+   try {
+      const auto args = parse(argc, argv);
+      if (args.command == "reconcile" && args.files.size() == 1)
+         return run_reconcile(args);
+      if (args.command == "diff" && args.files.size() == 2)
+         return run_diff(args);
+      return usage();
+   } catch (const std::exception& e) {
+      std::cerr << "error: " << e.what() << "\n";
+      return 2;
+   }
+}
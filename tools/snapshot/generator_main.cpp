@@ -0,0 +1,54 @@
+// xyz-snapshot-gen: writes a synthetic snapshot of the system contract's tables, for tests and benchmarks.
+//
+//    xyz-snapshot-gen <out> [--holders <n>] [--seed <n>] [--mutations <n>] [--implicit] [--code <account>]
+//
+// The same options always give the same file. Generating twice with the same seed and different
+// `--mutations` gives two states of the same chain, for `xyz-snapshot diff`.
+
+#include <xyz/synthetic.hpp>
+
+#include <iostream>
+
+using namespace xyz_tools;
+
+int main(int argc, char** argv) {
+   try {
+      synthetic_options options;
+      std::string       out;
+      for (int i = 1; i < argc; ++i) {
+         const std::string arg = argv[i];
+         auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+               throw std::runtime_error(arg + " needs a value");
+            return argv[++i];
+         };
+         if (arg == "--holders")
+            options.holders = std::stoull(value());
+         else if (arg == "--seed")
+            options.seed = std::stoull(value());
+         else if (arg == "--mutations")
+            options.mutations = std::stoull(value());
+         else if (arg == "--implicit")
+            options.implicit_reserve = true;
+         else if (arg == "--code")
+            options.code = name(value());
+         else if (arg.starts_with("--") || !out.empty())
+            throw std::runtime_error("unexpected argument " + arg);
+         else
+            out = arg;
+      }
+      if (out.empty()) {
+         std::cerr << "usage: xyz-snapshot-gen <out> [--holders <n>] [--seed <n>] [--mutations <n>] [--implicit] "
+                      "[--code <account>]\n";
+         return 2;
+      }
+
+      snapshot_writer writer;
+      write_synthetic_snapshot(options, writer);
+      writer.write_file(out);
+      return 0;
+   } catch (const std::exception& e) {
+      std::cerr << "error: " << e.what() << "\n";
+      return 2;
+   }
+}
@@ -0,0 +1,290 @@
+#include <xyz/contract_state.hpp>
+#include <xyz/parallel.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace xyz_tools {
+
+   namespace {
+      const symbol eos_symbol("EOS", 4);
+
+      std::string to_string(__int128 amount, symbol sym) {
+         // balances are int64 each, their sum is only wider to rule out overflow while adding
+         if (amount >= INT64_MIN && amount <= INT64_MAX)
+            return asset{int64_t(amount), sym}.to_string();
+         return "(out of range) " + sym.code_string();
+      }
+
+      std::string describe(const config& c) {
+         std::ostringstream out;
+         out << "config token_symbol=" << int(c.token_symbol.precision()) << "," << c.token_symbol.code_string();
+         if (c.swap_audit)
+            out << " swap_audit=" << int(*c.swap_audit);
+         if (c.implicit_reserve)
+            out << " implicit_reserve=" << *c.implicit_reserve;
+         if (c.commitment)
+            out << " commitment=" << *c.commitment;
+         if (c.registry)
+            out << " registry=" << *c.registry;
+         return out.str();
+      }
+
+      std::string describe(const currency_stats& s) {
+         return "stat supply=" + s.supply.to_string() + " max_supply=" + s.max_supply.to_string() +
+                " issuer=" + s.issuer.to_string();
+      }
+
+      std::string describe(const solvency_stats& s) {
+         return "solvency circulating=" + s.circulating.to_string() + " eos_held=" + s.eos_held.to_string() +
+                " swapped_in=" + s.swapped_in.to_string() + " swapped_out=" + s.swapped_out.to_string();
+      }
+
+      template <typename T>
+      void diff_singleton(const std::optional<T>& before, const std::optional<T>& after,
+                          std::vector<std::string>& out) {
+         const std::string b = before ? describe(*before) : "(none)";
+         const std::string a = after ? describe(*after) : "(none)";
+         if (a != b)
+            out.push_back(b + " -> " + a);
+      }
+
+      bool key_less(const table_row& a, const table_row& b) {
+         return a.scope != b.scope ? a.scope < b.scope : a.primary_key < b.primary_key;
+      }
+   } // namespace
+
+   contract_state load_contract_state(const snapshot& snap, name code, name eos_token) {
+      contract_state state;
+      state.code = code;
+
+      const name accounts = "accounts"_n, stat = "stat"_n, cfg = "config"_n, blocked = "blocked"_n,
+                 solvency = "solvency"_n;
+
+      auto filter = [&](name c, name scope, name table) {
+         if (c == code)
+            return table == accounts || table == stat || table == cfg || table == blocked || table == solvency;
+         return c == eos_token && scope == code && table == accounts;
+      };
+
+      state.tables = for_each_table_row(snap, filter, [&](const table_row& row) {
+         if (row.code == eos_token) {
+            if (row.primary_key == eos_symbol.code()) {
+               reader r(row.value);
+               asset  balance;
+               decode(r, balance);
+               state.eos_held = balance;
+            }
+         } else if (row.table == accounts) {
+            state.accounts.push_back(row);
+         } else if (row.table == stat) {
+            state.stats.push_back(decode_row<currency_stats>(row.value));
+         } else if (row.table == cfg) {
+            state.cfg = decode_row<config>(row.value);
+         } else if (row.table == solvency) {
+            state.solvency = decode_row<solvency_stats>(row.value);
+         } else if (row.table == blocked) {
+            state.blocked.push_back(decode_row<blocked_recipient>(row.value).account);
+         }
+      });
+      return state;
+   }
+
+   // ----------------------------------------------------
+   // reconciliation -------------------------------------
+   // ----------------------------------------------------
+
+   bool reconciliation::ok() const {
+      return std::all_of(tokens.begin(), tokens.end(), [](const auto& t) { return t.ok(); });
+   }
+
+   reconciliation reconcile(const contract_state& state, unsigned threads) {
+      reconciliation result;
+      for (const auto& s : state.stats) {
+         token_reconciliation t;
+         t.stat    = s;
+         t.reserve = asset{0, s.supply.sym};
+         result.tokens.push_back(t);
+      }
+
+      auto token_index = [&](uint64_t code) -> size_t {
+         for (size_t i = 0; i < result.tokens.size(); ++i)
+            if (result.tokens[i].stat.supply.sym.code() == code)
+               return i;
+         throw decode_error("balance of a token without a stat row: " + symbol(code << 8).code_string());
+      };
+
+      // one partial sum per token and chunk, added up once every chunk is done
+      std::vector<std::vector<token_reconciliation>> partials(std::max(1u, threads), result.tokens);
+      parallel_chunks(state.accounts.size(), threads, [&](size_t begin, size_t end, unsigned chunk) {
+         auto& sums = partials[chunk];
+         for (size_t i = begin; i < end; ++i) {
+            const auto& row     = state.accounts[i];
+            const auto  balance = decode_row<account>(row.value);
+            auto&       t       = sums[token_index(row.primary_key)];
+            if (row.scope == state.code) {
+               t.reserve = balance.balance;
+               continue;
+            }
+            t.holder_sum += balance.balance.amount;
+            t.holders += 1;
+            t.released += balance.released;
+         }
+      });
+
+      for (size_t i = 0; i < result.tokens.size(); ++i) {
+         auto& t = result.tokens[i];
+         for (const auto& sums : partials) {
+            t.holder_sum += sums[i].holder_sum;
+            t.holders += sums[i].holders;
+            t.released += sums[i].released;
+            if (sums[i].reserve.amount)
+               t.reserve = sums[i].reserve;
+         }
+      }
+
+      // With an implicit reserve the contract's row is frozen, the reserve is derived from the solvency counters.
+      if (state.cfg && state.cfg->implicit_reserve.value_or(false)) {
+         if (!state.solvency)
+            throw decode_error("the reserve is implicit but the snapshot has no solvency counters");
+         auto& t            = result.tokens[token_index(state.cfg->token_symbol.code())];
+         t.implicit_reserve = true;
+         t.reserve.amount   = t.stat.supply.amount - state.solvency->circulating.amount;
+      }
+
+      if (state.solvency && state.cfg) {
+         const auto& s = *state.solvency;
+         const auto& t = result.tokens[token_index(state.cfg->token_symbol.code())];
+         if (s.circulating.amount != t.holder_sum)
+            result.solvency_mismatches.push_back("circulating " + s.circulating.to_string() + " != balances " +
+                                                 to_string(t.holder_sum, s.circulating.sym));
+         if (state.eos_held && s.eos_held != *state.eos_held)
+            result.solvency_mismatches.push_back("eos_held " + s.eos_held.to_string() + " != EOS balance " +
+                                                 state.eos_held->to_string());
+      }
+      return result;
+   }
+
+   // ----------------------------------------------------
+   // diffing --------------------------------------------
+   // ----------------------------------------------------
+
+   state_diff diff(const contract_state& before, const contract_state& after, unsigned threads) {
+      state_diff result;
+
+      diff_singleton(before.cfg, after.cfg, result.singletons);
+      diff_singleton(before.solvency, after.solvency, result.singletons);
+      for (const auto& b : before.stats) {
+         auto a = std::find_if(after.stats.begin(), after.stats.end(),
+                               [&](const auto& s) { return s.supply.sym == b.supply.sym; });
+         diff_singleton(std::optional(b), a == after.stats.end() ? std::nullopt : std::optional(*a), result.singletons);
+      }
+      for (const auto& a : after.stats) {
+         if (std::none_of(before.stats.begin(), before.stats.end(),
+                          [&](const auto& s) { return s.supply.sym == a.supply.sym; }))
+            diff_singleton(std::optional<currency_stats>(), std::optional(a), result.singletons);
+      }
+
+      auto sorted_blocked = [](std::vector<name> v) {
+         std::sort(v.begin(), v.end());
+         return v;
+      };
+      const auto blocked_before = sorted_blocked(before.blocked), blocked_after = sorted_blocked(after.blocked);
+      std::set_difference(blocked_after.begin(), blocked_after.end(), blocked_before.begin(), blocked_before.end(),
+                          std::back_inserter(result.blocked_added));
+      std::set_difference(blocked_before.begin(), blocked_before.end(), blocked_after.begin(), blocked_after.end(),
+                          std::back_inserter(result.blocked_removed));
+
+      // Tables are stored in creation order, not key order: sort both sides by (owner, symbol) first.
+      std::vector<table_row> b = before.accounts, a = after.accounts;
+      parallel_sort(b.begin(), b.end(), threads, key_less);
+      parallel_sort(a.begin(), a.end(), threads, key_less);
+
+      // Split the key space at evenly spaced keys of `before`, and walk both sides of each split in parallel.
+      const unsigned chunks = std::max(1u, threads);
+      std::vector<std::pair<size_t, size_t>> starts;
+      for (unsigned t = 0; t < chunks; ++t) {
+         const size_t bi = b.size() * t / chunks;
+         if (t == 0)
+            starts.emplace_back(0, 0);
+         else if (bi == b.size())
+            starts.emplace_back(bi, a.size());
+         else
+            starts.emplace_back(bi, std::lower_bound(a.begin(), a.end(), b[bi], key_less) - a.begin());
+      }
+      starts.emplace_back(b.size(), a.size());
+
+      std::vector<state_diff> partials(chunks);
+      parallel_chunks(chunks, chunks, [&](size_t first, size_t last, unsigned) {
+         for (size_t chunk = first; chunk < last; ++chunk) {
+            auto& out = partials[chunk];
+            auto  bi = starts[chunk].first, ai = starts[chunk].second;
+            const auto be = starts[chunk + 1].first, ae = starts[chunk + 1].second;
+
+            while (bi < be || ai < ae) {
+               const bool take_b = bi < be && (ai == ae || !key_less(a[ai], b[bi]));
+               const bool take_a = ai < ae && (bi == be || !key_less(b[bi], a[ai]));
+               const table_row* br = take_b ? &b[bi++] : nullptr;
+               const table_row* ar = take_a ? &a[ai++] : nullptr;
+               if (br && ar && br->value == ar->value && br->payer == ar->payer)
+                  continue;
+
+               account_change change;
+               change.owner = (br ? br : ar)->scope;
+               change.sym   = symbol((br ? br : ar)->primary_key << 8);
+               if (br) {
+                  change.before       = decode_row<account>(br->value);
+                  change.sym          = change.before->balance.sym;
+                  change.payer_before = br->payer;
+               }
+               if (ar) {
+                  change.after       = decode_row<account>(ar->value);
+                  change.sym         = change.after->balance.sym;
+                  change.payer_after = ar->payer;
+               }
+
+               if (!br) {
+                  ++out.created;
+               } else if (!ar) {
+                  ++out.erased;
+               } else {
+                  out.balance_changed += change.before->balance != change.after->balance;
+                  out.released_changed += change.before->released != change.after->released;
+                  out.payer_changed += change.payer_before != change.payer_after;
+               }
+               out.accounts.push_back(change);
+            }
+         }
+      });
+
+      for (auto& p : partials) {
+         result.accounts.insert(result.accounts.end(), p.accounts.begin(), p.accounts.end());
+         result.created += p.created;
+         result.erased += p.erased;
+         result.balance_changed += p.balance_changed;
+         result.released_changed += p.released_changed;
+         result.payer_changed += p.payer_changed;
+      }
+      return result;
+   }
+
+   std::string to_string(const account_change& change) {
+      const std::string owner = change.owner.to_string();
+      if (!change.before)
+         return "+ " + owner + " " + change.after->balance.to_string() + (change.after->released ? " released" : "") +
+                " payer " + change.payer_after.to_string();
+      if (!change.after)
+         return "- " + owner + " " + change.before->balance.to_string();
+
+      std::string line = "~ " + owner;
+      if (change.before->balance != change.after->balance)
+         line += " balance " + change.before->balance.to_string() + " -> " + change.after->balance.to_string();
+      if (change.before->released != change.after->released)
+         line += std::string(" released ") + (change.before->released ? "1" : "0") + " -> " +
+                 (change.after->released ? "1" : "0");
+      if (change.payer_before != change.payer_after)
+         line += " payer " + change.payer_before.to_string() + " -> " + change.payer_after.to_string();
+      return line;
+   }
+
+} // namespace xyz_tools
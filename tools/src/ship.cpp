@@ -0,0 +1,292 @@
+#include <xyz/ship.hpp>
+
+#include <algorithm>
+
+namespace xyz_tools {
+
+   namespace {
+      constexpr size_t checksum_size = 32;
+      constexpr size_t name_pair     = 2 * sizeof(uint64_t); // permission_level, account_delta, account_auth_sequence
+
+      const name   transfer_action = "transfer"_n;
+      const name   accounts_table  = "accounts"_n;
+      const name   ram_account     = "eosio.ram"_n;
+      const name   stake_account   = "eosio.stake"_n;
+      const symbol eos_symbol("EOS", 4);
+
+      uint32_t read_variant(reader& r, uint32_t max_index, const char* type) {
+         const uint32_t index = r.read_varuint32();
+         if (index > max_index)
+            throw decode_error(std::string("unsupported ") + type + " version " + std::to_string(index));
+         return index;
+      }
+
+      void skip_vector(reader& r, size_t element_size) { r.skip(size_t(r.read_varuint32()) * element_size); }
+
+      void skip_optional(reader& r, size_t size) {
+         if (r.read_bool())
+            r.skip(size);
+      }
+
+      void skip_optional_bytes(reader& r) {
+         if (r.read_bool())
+            r.read_bytes();
+      }
+
+      // `fc::crypto::signature`: k1 and r1 are 65 bytes, webauthn adds the authenticator data and client JSON.
+      void skip_signature(reader& r) {
+         const uint32_t type = read_variant(r, 2, "signature");
+         r.skip(65);
+         if (type == 2) {
+            r.read_bytes();
+            r.read_bytes();
+         }
+      }
+
+      // `partial_transaction_v0`
+      void skip_partial_transaction(reader& r) {
+         read_variant(r, 0, "partial_transaction");
+         r.skip(sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint32_t)); // expiration, ref_block_num, ref_block_prefix
+         r.read_varuint32();                                             // max_net_usage_words
+         r.skip(sizeof(uint8_t));                                        // max_cpu_usage_ms
+         r.read_varuint32();                                             // delay_sec
+         for (uint32_t n = r.read_varuint32(); n > 0; --n) {             // transaction_extensions
+            r.skip(sizeof(uint16_t));
+            r.read_bytes();
+         }
+         for (uint32_t n = r.read_varuint32(); n > 0; --n)
+            skip_signature(r);
+         for (uint32_t n = r.read_varuint32(); n > 0; --n) // context_free_data
+            r.read_bytes();
+      }
+
+      struct transfer_data {
+         name             from;
+         name             to;
+         asset            quantity;
+         std::string_view memo;
+      };
+
+      transfer_data decode_transfer(std::string_view data) {
+         reader        r(data);
+         transfer_data t;
+         decode(r, t.from);
+         decode(r, t.to);
+         decode(r, t.quantity);
+         t.memo = r.read_bytes();
+         return t;
+      }
+   } // namespace
+
+   ship_decoder::ship_decoder(decoder_options options, sink on_batch)
+      : _options(options)
+      , _on_batch(std::move(on_batch)) {}
+
+   void ship_decoder::decode_message(std::string_view message) {
+      reader r(message);
+      ++_stats.messages;
+      _stats.bytes += message.size();
+
+      // result: get_status_result_v0, get_blocks_result_v0, get_blocks_result_v1
+      if (read_variant(r, 2, "state history result") == 0)
+         return;
+
+      r.skip(2 * (sizeof(uint32_t) + checksum_size)); // head, last_irreversible
+      if (!r.read_bool())                             // this_block
+         return;
+      const uint32_t block_num = r.read<uint32_t>();
+      r.skip(checksum_size);
+      skip_optional(r, sizeof(uint32_t) + checksum_size); // prev_block
+      skip_optional_bytes(r);                             // block
+
+      const bool       has_traces = r.read_bool();
+      std::string_view traces     = has_traces ? r.read_bytes() : std::string_view();
+      const bool       has_deltas = r.read_bool();
+      std::string_view deltas     = has_deltas ? r.read_bytes() : std::string_view();
+      ++_stats.blocks;
+
+      if (has_traces) {
+         reader t(traces);
+         decode_traces(t, block_num);
+      }
+      if (has_deltas) {
+         reader d(deltas);
+         decode_deltas(d, block_num);
+      }
+   }
+
+   void ship_decoder::decode_traces(reader& r, uint32_t block_num) {
+      for (uint32_t n = r.read_varuint32(); n > 0; --n)
+         decode_transaction(r, block_num, true);
+   }
+
+   // `transaction_trace_v0`, events are only emitted for executed transactions
+   void ship_decoder::decode_transaction(reader& r, uint32_t block_num, bool emit) {
+      read_variant(r, 0, "transaction_trace");
+      const std::string_view id = r.read_view(checksum_size);
+      const bool executed       = r.read<uint8_t>() == 0;
+      transaction_event trx;
+      trx.block_num       = block_num;
+      trx.trx_id          = id;
+      trx.cpu_usage_us    = r.read<uint32_t>();
+      trx.net_usage_words = r.read_varuint32();
+      trx.elapsed_us      = r.read<int64_t>();
+      r.skip(sizeof(uint64_t)); // net_usage
+      r.skip(sizeof(bool));     // scheduled
+
+      emit = emit && executed;
+      if (emit)
+         ++_stats.transactions;
+      const bool collect = emit && _options.transactions;
+      for (uint32_t n = r.read_varuint32(); n > 0; --n)
+         decode_action(r, block_num, id, emit, collect ? &trx : nullptr);
+
+      const bool replayable = std::all_of(trx.actions.begin(), trx.actions.end(), [&](const recorded_action& a) {
+         return a.account == _options.code || a.account == _options.eos_token;
+      });
+      if (collect && !trx.actions.empty() && replayable) {
+         _batch.transactions.push_back(std::move(trx));
+         emitted();
+      }
+
+      skip_optional(r, name_pair);        // account_ram_delta
+      skip_optional_bytes(r);             // except
+      skip_optional(r, sizeof(uint64_t)); // error_code
+      if (r.read_bool())                  // failed_dep_trace
+         decode_transaction(r, block_num, false);
+      if (r.read_bool()) // partial
+         skip_partial_transaction(r);
+   }
+
+   // `action_trace_v0` or `action_trace_v1`
+   void ship_decoder::decode_action(reader& r, uint32_t block_num, std::string_view trx_id, bool emit,
+                                    transaction_event* trx) {
+      const uint32_t version = read_variant(r, 1, "action_trace");
+      r.read_varuint32(); // action_ordinal
+      const bool input = r.read_varuint32() == 0; // creator_action_ordinal
+
+      uint64_t global_sequence = 0;
+      if (r.read_bool()) { // receipt: action_receipt_v0
+         read_variant(r, 0, "action_receipt");
+         r.skip(sizeof(uint64_t) + checksum_size); // receiver, act_digest
+         global_sequence = r.read<uint64_t>();
+         r.skip(sizeof(uint64_t)); // recv_sequence
+         skip_vector(r, name_pair);  // auth_sequence
+         r.read_varuint32();         // code_sequence
+         r.read_varuint32();         // abi_sequence
+      }
+
+      name receiver, account, act;
+      decode(r, receiver);
+      decode(r, account);
+      decode(r, act);
+
+      // the transaction's own actions, not what they sent inline or notified
+      recorded_action* recorded = nullptr;
+      if (trx && input && receiver == account)
+         recorded = &trx->actions.emplace_back(recorded_action{account, act, {}, {}});
+      for (uint32_t n = r.read_varuint32(); n > 0; --n) { // authorization
+         if (recorded) {
+            name actor, permission;
+            decode(r, actor);
+            decode(r, permission);
+            recorded->authorization.emplace_back(actor, permission);
+         } else {
+            r.skip(name_pair);
+         }
+      }
+      const std::string_view data = r.read_bytes();
+      if (recorded)
+         recorded->data = data;
+
+      r.skip(sizeof(bool) + sizeof(int64_t)); // context_free, elapsed
+      r.read_bytes();                         // console
+      skip_vector(r, name_pair);              // account_ram_deltas
+      skip_optional_bytes(r);                 // except
+      skip_optional(r, sizeof(uint64_t));     // error_code
+      if (version == 1)
+         r.read_bytes(); // return_value
+      ++_stats.actions;
+
+      // Only the copy of each action delivered to the contract, so that notifications aren't counted twice.
+      if (!emit || receiver != _options.code || act != transfer_action)
+         return;
+
+      if (account == _options.code) {
+         const auto t = decode_transfer(data);
+         _batch.transfers.push_back({block_num, trx_id, global_sequence, t.from, t.to, t.quantity, t.memo});
+         emitted();
+      } else if (account == _options.eos_token) {
+         // Mirrors `on_transfer`: EOS sent by the system's RAM and stake accounts is not swapped.
+         const auto t = decode_transfer(data);
+         if (t.quantity.sym != eos_symbol)
+            return;
+         if (t.to == _options.code && t.from != _options.code && t.from != ram_account && t.from != stake_account) {
+            _batch.swaps.push_back({block_num, trx_id, global_sequence, swap_direction::to_xyz, t.from, t.quantity});
+            emitted();
+         } else if (t.from == _options.code && t.to != _options.code) {
+            _batch.swaps.push_back({block_num, trx_id, global_sequence, swap_direction::to_eos, t.to, t.quantity});
+            emitted();
+         }
+      }
+   }
+
+   // `table_delta_v0`, only the `contract_row` deltas are looked at
+   void ship_decoder::decode_deltas(reader& r, uint32_t block_num) {
+      for (uint32_t n = r.read_varuint32(); n > 0; --n) {
+         read_variant(r, 0, "table_delta");
+         const bool     contract_rows = r.read_bytes() == "contract_row";
+         const uint32_t rows          = r.read_varuint32();
+         for (uint32_t i = 0; i < rows; ++i) {
+            const bool             present = r.read_bool();
+            const std::string_view data    = r.read_bytes();
+            if (!contract_rows)
+               continue;
+            ++_stats.rows;
+
+            // `contract_row_v0`
+            reader row(data);
+            read_variant(row, 0, "contract_row");
+            balance_event e;
+            name          code, table;
+            decode(row, code);
+            if (code != _options.code)
+               continue;
+            decode(row, e.owner);
+            decode(row, table);
+            if (table != accounts_table)
+               continue;
+            row.skip(sizeof(uint64_t)); // primary_key
+            decode(row, e.payer);
+            e.row       = decode_row<account>(row.read_bytes());
+            e.block_num = block_num;
+            e.present   = present;
+            _batch.balances.push_back(e);
+            emitted();
+         }
+      }
+   }
+
+   void ship_decoder::emitted() {
+      ++_stats.events;
+      if (_batch.size() >= _options.batch_size)
+         flush();
+   }
+
+   void ship_decoder::flush() {
+      if (_batch.size() == 0)
+         return;
+      _on_batch(_batch);
+      _batch.clear();
+   }
+
+   void replay_recording(std::string_view recording, ship_decoder& decoder) {
+      reader r(recording);
+      while (!r.empty()) {
+         const uint32_t size = r.read<uint32_t>();
+         decoder.decode_message(r.read_view(size));
+      }
+      decoder.flush();
+   }
+
+} // namespace xyz_tools
@@ -0,0 +1,184 @@
+#include <xyz/ship_writer.hpp>
+
+namespace xyz_tools {
+
+   namespace {
+      const std::string checksum(32, '\0');
+
+      void write_block_position(writer& w, uint32_t block_num) {
+         w.write(block_num);
+         w.write_raw(checksum);
+      }
+
+      void write_action(writer& w, const trace_action& a, uint32_t ordinal, bool executed) {
+         w.write_varuint32(1); // action_trace_v1
+         w.write_varuint32(ordinal);
+         w.write_varuint32(ordinal > 1 ? 1 : 0);
+
+         w.write_bool(executed);
+         if (executed) {
+            w.write_varuint32(0); // action_receipt_v0
+            encode(w, a.receiver);
+            w.write_raw(checksum);
+            w.write(a.global_sequence);
+            w.write(a.global_sequence); // recv_sequence
+            w.write_varuint32(1);       // auth_sequence
+            encode(w, a.actor);
+            w.write(uint64_t(1));
+            w.write_varuint32(1); // code_sequence
+            w.write_varuint32(1); // abi_sequence
+         }
+
+         encode(w, a.receiver);
+         encode(w, a.account);
+         encode(w, a.act);
+         w.write_varuint32(1); // authorization
+         encode(w, a.actor);
+         encode(w, "active"_n);
+         w.write_bytes({a.data.data(), a.data.size()});
+
+         w.write_bool(false);  // context_free
+         w.write(int64_t(12)); // elapsed
+         w.write_bytes("");    // console
+         w.write_varuint32(0); // account_ram_deltas
+         w.write_bool(false);  // except
+         w.write_bool(false);  // error_code
+         w.write_bytes({a.return_value.data(), a.return_value.size()});
+      }
+
+      void write_partial(writer& w, bool webauthn) {
+         w.write_varuint32(0); // partial_transaction_v0
+         w.write(uint32_t(0)); // expiration
+         w.write(uint16_t(0)); // ref_block_num
+         w.write(uint32_t(0)); // ref_block_prefix
+         w.write_varuint32(0); // max_net_usage_words
+         w.write(uint8_t(0));  // max_cpu_usage_ms
+         w.write_varuint32(0); // delay_sec
+         w.write_varuint32(1); // transaction_extensions
+         w.write(uint16_t(1));
+         w.write_bytes("ext");
+         w.write_varuint32(1); // signatures
+         w.write_varuint32(webauthn ? 2 : 0);
+         w.write_raw(std::string(65, '\x01'));
+         if (webauthn) {
+            w.write_bytes("authenticator data");
+            w.write_bytes(R"({"type":"webauthn.get"})");
+         }
+         w.write_varuint32(0); // context_free_data
+      }
+
+      void write_transaction(writer& w, const trace_transaction& t) {
+         w.write_varuint32(0); // transaction_trace_v0
+         w.write_raw({t.id.data(), t.id.size()});
+         w.write(uint8_t(t.executed ? 0 : 3)); // executed or hard_fail
+         w.write(uint32_t(100));              // cpu_usage_us
+         w.write_varuint32(16);               // net_usage_words
+         w.write(int64_t(100));               // elapsed
+         w.write(uint64_t(128));              // net_usage
+         w.write_bool(false);                 // scheduled
+
+         w.write_varuint32(t.actions.size());
+         for (size_t i = 0; i < t.actions.size(); ++i)
+            write_action(w, t.actions[i], i + 1, t.executed);
+
+         w.write_bool(false); // account_ram_delta
+         w.write_bool(!t.executed);
+         if (!t.executed)
+            w.write_bytes("assertion failure with message: overdrawn balance");
+         w.write_bool(false); // error_code
+         w.write_bool(false); // failed_dep_trace
+         w.write_bool(true);  // partial
+         write_partial(w, t.webauthn);
+      }
+   } // namespace
+
+   std::vector<char> encode_transfer(name from, name to, const asset& quantity, std::string_view memo) {
+      std::vector<char> out;
+      writer            w(out);
+      encode(w, from);
+      encode(w, to);
+      encode(w, quantity);
+      w.write_bytes(memo);
+      return out;
+   }
+
+   std::vector<char> encode_blocks_result(uint32_t block_num, const std::vector<trace_transaction>& transactions,
+                                          const std::vector<trace_row>& rows, uint32_t other_deltas) {
+      std::vector<char> traces;
+      {
+         writer w(traces);
+         w.write_varuint32(transactions.size());
+         for (const auto& t : transactions)
+            write_transaction(w, t);
+      }
+
+      std::vector<char> deltas;
+      {
+         writer w(deltas);
+         w.write_varuint32(other_deltas ? 2 : 1);
+         if (other_deltas) {
+            w.write_varuint32(0); // table_delta_v0
+            w.write_bytes("resource_usage");
+            w.write_varuint32(other_deltas);
+            for (uint32_t i = 0; i < other_deltas; ++i) {
+               w.write_bool(true);
+               w.write_bytes(std::string(40, char(i)));
+            }
+         }
+
+         w.write_varuint32(0);
+         w.write_bytes("contract_row");
+         w.write_varuint32(rows.size());
+         for (const auto& row : rows) {
+            std::vector<char> data;
+            writer            d(data);
+            d.write_varuint32(0); // contract_row_v0
+            encode(d, row.code);
+            encode(d, row.scope);
+            encode(d, row.table);
+            d.write(row.primary_key);
+            encode(d, row.payer);
+            d.write_bytes({row.value.data(), row.value.size()});
+
+            w.write_bool(row.present);
+            w.write_bytes({data.data(), data.size()});
+         }
+      }
+
+      std::vector<char> out;
+      writer            w(out);
+      w.write_varuint32(1);               // get_blocks_result_v0
+      write_block_position(w, block_num); // head
+      write_block_position(w, block_num); // last_irreversible
+      w.write_bool(true);                 // this_block
+      write_block_position(w, block_num);
+      w.write_bool(block_num > 1); // prev_block
+      if (block_num > 1)
+         write_block_position(w, block_num - 1);
+      w.write_bool(true); // block, opaque to the decoder
+      w.write_bytes(std::string(200, '\x42'));
+      w.write_bool(true);
+      w.write_bytes({traces.data(), traces.size()});
+      w.write_bool(true);
+      w.write_bytes({deltas.data(), deltas.size()});
+      return out;
+   }
+
+   std::vector<char> encode_status_result(uint32_t head) {
+      std::vector<char> out;
+      writer            w(out);
+      w.write_varuint32(0); // get_status_result_v0
+      write_block_position(w, head);
+      write_block_position(w, head);
+      w.write(uint32_t(1));
+      w.write(head);
+      return out;
+   }
+
+   void append_frame(std::vector<char>& recording, const std::vector<char>& message) {
+      writer w(recording);
+      w.write(uint32_t(message.size()));
+      w.write_raw({message.data(), message.size()});
+   }
+
+} // namespace xyz_tools
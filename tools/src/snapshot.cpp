@@ -0,0 +1,122 @@
+#include <xyz/snapshot.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xyz_tools {
+
+   namespace {
+      constexpr uint64_t end_marker = ~uint64_t(0);
+
+      // Packed size of one row of each secondary index: primary key, payer, secondary key.
+      constexpr size_t secondary_row_sizes[] = {
+         8 + 8 + 8,  // idx64
+         8 + 8 + 16, // idx128
+         8 + 8 + 32, // idx256
+         8 + 8 + 8,  // idx_double
+         8 + 8 + 16, // idx_long_double
+      };
+
+      std::runtime_error system_error(const std::string& what, const std::string& path) {
+         return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+      }
+   } // namespace
+
+   mapped_file::mapped_file(const std::string& path) {
+      const int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+         throw system_error("cannot open", path);
+
+      struct stat st;
+      if (::fstat(fd, &st) != 0) {
+         ::close(fd);
+         throw system_error("cannot stat", path);
+      }
+      _size = st.st_size;
+
+      if (_size) {
+         void* p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (p == MAP_FAILED) {
+            ::close(fd);
+            throw system_error("cannot map", path);
+         }
+         ::madvise(p, _size, MADV_SEQUENTIAL);
+         _data = static_cast<const char*>(p);
+      }
+      ::close(fd);
+   }
+
+   mapped_file::~mapped_file() {
+      if (_data)
+         ::munmap(const_cast<char*>(_data), _size);
+   }
+
+   snapshot::snapshot(const std::string& path)
+      : _file(path) {
+      reader r(_file.data());
+      if (r.read<uint32_t>() != magic)
+         throw decode_error("not a portable binary snapshot: " + path);
+      _version = r.read<uint32_t>();
+
+      for (;;) {
+         const uint64_t size = r.read<uint64_t>();
+         if (size == end_marker)
+            break;
+         if (size < sizeof(uint64_t) + 1 || size > r.remaining())
+            throw decode_error("invalid section size in " + path);
+
+         reader           section(r.pos(), r.pos() + size);
+         snapshot_section s;
+         s.row_count = section.read<uint64_t>();
+         s.name      = section.read_cstring();
+         s.rows      = section.read_view(section.remaining());
+         _sections.push_back(s);
+         r.skip(size);
+      }
+   }
+
+   const snapshot_section& snapshot::section(std::string_view name) const {
+      for (const auto& s : _sections)
+         if (s.name == name)
+            return s;
+      throw decode_error("snapshot has no section " + std::string(name));
+   }
+
+   uint64_t for_each_table_row(const snapshot& snap, const table_filter& filter,
+                               const std::function<void(const table_row&)>& on_row) {
+      reader   r(snap.section("contract_tables").rows);
+      uint64_t tables = 0;
+
+      while (!r.empty()) {
+         table_row row;
+         decode(r, row.code);
+         decode(r, row.scope);
+         decode(r, row.table);
+         r.skip(sizeof(uint64_t) + sizeof(uint32_t)); // table payer, row count
+         ++tables;
+
+         const bool     wanted  = filter(row.code, row.scope, row.table);
+         const uint32_t primary = r.read_varuint32();
+         for (uint32_t i = 0; i < primary; ++i) {
+            if (wanted) {
+               row.primary_key = r.read<uint64_t>();
+               decode(r, row.payer);
+               row.value = r.read_bytes();
+               on_row(row);
+            } else {
+               r.skip(2 * sizeof(uint64_t));
+               r.skip(r.read_varuint32());
+            }
+         }
+
+         for (size_t row_size : secondary_row_sizes)
+            r.skip(size_t(r.read_varuint32()) * row_size);
+      }
+      return tables;
+   }
+
+} // namespace xyz_tools
@@ -0,0 +1,80 @@
+#include <xyz/snapshot_writer.hpp>
+
+#include <fstream>
+
+namespace xyz_tools {
+
+   snapshot_writer::snapshot_writer(uint32_t version) {
+      _w.write(snapshot::magic);
+      _w.write(version);
+   }
+
+   void snapshot_writer::begin_section(std::string_view name) {
+      _section_start = _w.size();
+      _section_rows  = 0;
+      _w.write(uint64_t(0)); // size, patched by `end_section`
+      _w.write(uint64_t(0)); // row count, patched by `end_section`
+      _w.write_cstring(name);
+   }
+
+   void snapshot_writer::end_section() {
+      _w.patch(_section_start, uint64_t(_w.size() - _section_start - sizeof(uint64_t)));
+      _w.patch(_section_start + sizeof(uint64_t), _section_rows);
+   }
+
+   void snapshot_writer::add_section(std::string_view name, uint64_t rows, std::string_view data) {
+      begin_section(name);
+      _w.write_raw(data);
+      _section_rows = rows;
+      end_section();
+   }
+
+   void snapshot_writer::begin_contract_tables() { begin_section("contract_tables"); }
+
+   void snapshot_writer::add_table(name code, name scope, name table, name payer, const std::vector<table_row>& rows,
+                                   uint32_t idx64_rows) {
+      encode(_w, code);
+      encode(_w, scope);
+      encode(_w, table);
+      encode(_w, payer);
+      _w.write(uint32_t(rows.size() + idx64_rows));
+
+      _w.write_varuint32(rows.size());
+      for (const auto& row : rows) {
+         _w.write(row.primary_key);
+         encode(_w, row.payer);
+         _w.write_bytes(row.value);
+      }
+
+      _w.write_varuint32(idx64_rows);
+      for (uint32_t i = 0; i < idx64_rows; ++i) {
+         _w.write(uint64_t(i)); // primary key
+         encode(_w, payer);
+         _w.write(~uint64_t(i)); // secondary key
+      }
+      for (int index = 0; index < 4; ++index) // idx128, idx256, idx_double, idx_long_double
+         _w.write_varuint32(0);
+
+      // the table, then a size and the rows of each of the six indices
+      _section_rows += 1 + 6 + rows.size() + idx64_rows;
+   }
+
+   void snapshot_writer::end_contract_tables() { end_section(); }
+
+   const std::vector<char>& snapshot_writer::finish() {
+      if (!_finished) {
+         _w.write(~uint64_t(0));
+         _finished = true;
+      }
+      return _out;
+   }
+
+   void snapshot_writer::write_file(const std::string& path) {
+      const auto&   data = finish();
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      out.write(data.data(), data.size());
+      if (!out)
+         throw std::runtime_error("cannot write " + path);
+   }
+
+} // namespace xyz_tools
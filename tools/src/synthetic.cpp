@@ -0,0 +1,287 @@
+#include <xyz/synthetic.hpp>
+#include <xyz/ship_writer.hpp>
+
+#include <algorithm>
+#include <random>
+
+namespace xyz_tools {
+
+   namespace {
+      const symbol   xyz_symbol("XYZ", 4);
+      const symbol   eos_symbol("EOS", 4);
+      const int64_t  max_supply = 2'100'000'000'0000;
+      const uint64_t xyz_scope  = xyz_symbol.code();
+
+      struct holder {
+         name    owner;
+         int64_t amount   = 0;
+         bool    released = false;
+         bool    closed   = false;
+      };
+
+      table_row make_row(uint64_t primary_key, name payer, const std::vector<char>& value) {
+         table_row row;
+         row.primary_key = primary_key;
+         row.payer       = payer;
+         row.value       = std::string_view(value.data(), value.size());
+         return row;
+      }
+   } // namespace
+
+   name synthetic_holder(uint64_t index) {
+      static constexpr std::string_view digits = "12345abcdefghijklmnopqrstuvwxyz";
+      std::string                       str    = "h";
+      for (int i = 10; i >= 0; --i) {
+         uint64_t d = index;
+         for (int j = 0; j < i; ++j)
+            d /= digits.size();
+         str += digits[d % digits.size()];
+      }
+      return name(str);
+   }
+
+   void write_synthetic_snapshot(const synthetic_options& options, snapshot_writer& out) {
+      std::mt19937_64 rng(options.seed);
+      const name      code = options.code;
+
+      // holders share half of the supply, the rest stays in the reserve
+      std::vector<holder> holders(options.holders);
+      std::vector<name>   blocked;
+      const int64_t       max_amount = std::max<int64_t>(1, max_supply / std::max<uint64_t>(1, options.holders));
+      for (uint64_t i = 0; i < options.holders; ++i) {
+         holders[i].owner    = synthetic_holder(i);
+         holders[i].amount   = 1 + int64_t(rng() % uint64_t(max_amount));
+         holders[i].released = rng() & 1;
+         if (rng() % 100 == 0)
+            blocked.push_back(holders[i].owner);
+      }
+
+      int64_t swapped_out = 0;
+      for (const auto& h : holders)
+         swapped_out += h.amount / 10;
+
+      // Activity since the base state. Each mutation is one swap, transfer, release or close, so the state
+      // stays consistent: the reserve and the EOS held follow the swaps.
+      std::mt19937_64 activity(options.seed ^ 0x9e3779b97f4a7c15ull);
+      for (uint64_t m = 0; m < options.mutations && !holders.empty(); ++m) {
+         auto& h = holders[activity() % holders.size()];
+         if (h.closed)
+            continue;
+         switch (activity() % 4) {
+            case 0: { // transfer half of the balance to another holder
+               auto& to = holders[activity() % holders.size()];
+               if (&to != &h && !to.closed && h.amount > 1) {
+                  to.amount += h.amount / 2;
+                  h.amount -= h.amount / 2;
+               }
+               break;
+            }
+            case 1: // the first outgoing transfer releases the row, later ones swap more in
+               if (!h.released)
+                  h.released = true;
+               else
+                  h.amount += 1'0000;
+               break;
+            case 2: // swap everything out and close the row
+               swapped_out += h.amount;
+               h.amount = 0;
+               h.closed = true;
+               break;
+            default: // a new holder swaps in
+               holders.push_back({synthetic_holder(holders.size()), 1 + int64_t(activity() % 1000'0000), true});
+               break;
+         }
+      }
+
+      int64_t circulating = 0;
+      for (const auto& h : holders)
+         circulating += h.amount;
+      const int64_t reserve = max_supply - circulating;
+
+      config cfg;
+      cfg.token_symbol     = xyz_symbol;
+      cfg.swap_audit       = 0;
+      cfg.implicit_reserve = options.implicit_reserve;
+
+      // ----------------------------------------------------
+      // sections -------------------------------------------
+      // ----------------------------------------------------
+
+      const uint32_t          version = 8;
+      const std::string_view  header(reinterpret_cast<const char*>(&version), sizeof(version));
+      const std::vector<char> opaque(256, '\x5a');
+      out.add_section("eosio::chain::chain_snapshot_header", 1, header);
+      out.add_section("eosio::chain::global_property_object", 1, {opaque.data(), opaque.size()});
+
+      out.begin_contract_tables();
+
+      const name eos_token = "eosio.token"_n;
+      {
+         const auto value = encode_row(currency_stats{{circulating, eos_symbol}, {max_supply, eos_symbol}, "eosio"_n});
+         out.add_table(eos_token, name(eos_symbol.code()), "stat"_n, eos_token,
+                       {make_row(eos_symbol.code(), eos_token, value)});
+      }
+
+      {
+         const auto value = encode_row(cfg);
+         out.add_table(code, code, "config"_n, code, {make_row("config"_n.value, code, value)});
+      }
+      {
+         const auto value = encode_row(currency_stats{{max_supply, xyz_symbol}, {max_supply, xyz_symbol}, code});
+         out.add_table(code, name(xyz_scope), "stat"_n, code, {make_row(xyz_scope, code, value)});
+      }
+      {
+         const int64_t swapped_in = circulating + swapped_out;
+         const auto    value =
+            encode_row(solvency_stats{{circulating, xyz_symbol}, {circulating, eos_symbol}, {swapped_in, eos_symbol},
+                                      {swapped_out, xyz_symbol}});
+         out.add_table(code, code, "solvency"_n, code, {make_row("solvency"_n.value, code, value)});
+      }
+      if (!blocked.empty()) {
+         std::sort(blocked.begin(), blocked.end());
+         std::vector<std::vector<char>> values;
+         std::vector<table_row>         rows;
+         values.reserve(blocked.size());
+         for (auto account : blocked) {
+            values.push_back(encode_row(blocked_recipient{account}));
+            rows.push_back(make_row(account.value, account, values.back()));
+         }
+         out.add_table(code, code, "blocked"_n, rows.front().payer, rows);
+      }
+      {
+         // the reserve row is frozen at the whole supply while the reserve is implicit
+         const int64_t amount = options.implicit_reserve ? max_supply : reserve;
+         const auto    value  = encode_row(account{{amount, xyz_symbol}, true});
+         out.add_table(code, code, "accounts"_n, code, {make_row(xyz_scope, code, value)});
+      }
+
+      std::vector<char> foreign(48);
+      for (uint64_t i = 0; i < holders.size(); ++i) {
+         const auto& h = holders[i];
+         if (!h.closed) {
+            const name payer = h.released ? h.owner : code;
+            const auto value = encode_row(account{{h.amount, xyz_symbol}, h.released});
+            out.add_table(code, h.owner, "accounts"_n, payer, {make_row(xyz_scope, payer, value)});
+         }
+
+         if (options.foreign_every && i % options.foreign_every == 0) {
+            for (auto& c : foreign)
+               c = char(rng());
+            const name other = "otherdapp"_n;
+            out.add_table(other, h.owner, "accounts"_n, other,
+                          {make_row(1, other, foreign), make_row(2, other, foreign)}, 3);
+         }
+      }
+
+      {
+         const std::vector<char> value = [&] {
+            std::vector<char> v;
+            writer            w(v);
+            encode(w, asset{circulating, eos_symbol});
+            return v;
+         }();
+         out.add_table(eos_token, code, "accounts"_n, code, {make_row(eos_symbol.code(), code, value)});
+      }
+
+      out.end_contract_tables();
+      out.add_section("eosio::chain::resource_limits::resource_object", 1, {opaque.data(), opaque.size()});
+   }
+
+   synthetic_recording_counts write_synthetic_recording(const synthetic_recording_options& options,
+                                                        std::vector<char>&                 out) {
+      std::mt19937_64            rng(options.seed);
+      synthetic_recording_counts counts;
+      uint64_t                   global_sequence = 0;
+
+      const name code = options.code, eos_token = "eosio.token"_n, other = "otherdapp"_n;
+      const name transfer = "transfer"_n, accounts = "accounts"_n;
+
+      append_frame(out, encode_status_result(options.blocks));
+
+      for (uint32_t block = 1; block <= options.blocks; ++block) {
+         std::vector<trace_transaction> transactions(options.transactions);
+         std::vector<trace_row>         rows;
+
+         for (auto& trx : transactions) {
+            for (auto& c : trx.id)
+               c = char(rng());
+            trx.webauthn = rng() % 16 == 0;
+
+            auto action = [&](name receiver, name account, name act, name actor, std::vector<char> data) {
+               trx.actions.push_back({receiver, account, act, actor, std::move(data), ++global_sequence, {}});
+            };
+            // a token transfer as traced: the action itself, then the notifications to both sides, except the
+            // token contract which already ran it
+            auto token_transfer = [&](name token, name from, name to, const asset& quantity) {
+               const auto data = encode_transfer(from, to, quantity, "memo");
+               action(token, token, transfer, from, data);
+               for (const name notified : {from, to})
+                  if (notified != token)
+                     action(notified, token, transfer, from, data);
+            };
+            auto balance = [&](name owner, int64_t amount) {
+               rows.push_back({true, code, owner, accounts, xyz_symbol.code(), owner,
+                               encode_row(account{{amount, xyz_symbol}, true})});
+               ++counts.balances;
+            };
+
+            const name    user   = synthetic_holder(rng() % 1000);
+            const name    peer   = synthetic_holder(1000 + rng() % 1000);
+            const int64_t amount = 1 + int64_t(rng() % 100'0000);
+            const asset   xyz{amount, xyz_symbol}, eos{amount, eos_symbol};
+
+            switch (rng() % 8) {
+               case 0: // transfer
+                  token_transfer(code, user, peer, xyz);
+                  balance(user, amount);
+                  balance(peer, amount);
+                  ++counts.transfers;
+                  break;
+               case 1: // swap EOS to XYZ: `on_transfer` sends the XYZ back
+                  token_transfer(eos_token, user, code, eos);
+                  token_transfer(code, code, user, xyz);
+                  balance(user, amount);
+                  ++counts.swaps_to_xyz;
+                  ++counts.transfers;
+                  break;
+               case 2: // swap XYZ to EOS by transferring to the contract
+                  token_transfer(code, user, code, xyz);
+                  token_transfer(eos_token, code, user, eos);
+                  balance(user, amount);
+                  ++counts.swaps_to_eos;
+                  ++counts.transfers;
+                  break;
+               case 3: // a forwarding action: swap before forwarding, audited with `swaptrace`
+                  action(code, code, "buyram"_n, user, std::vector<char>(24, 'b'));
+                  action(code, code, "swaptrace"_n, code, std::vector<char>(24, 's'));
+                  token_transfer(eos_token, code, user, eos);
+                  action("eosio"_n, "eosio"_n, "buyram"_n, user, std::vector<char>(24, 'b'));
+                  token_transfer(eos_token, user, "eosio.ram"_n, eos);
+                  balance(user, amount);
+                  ++counts.swaps_to_eos;
+                  break;
+               case 4: // failed transfer: no events
+                  trx.executed = false;
+                  token_transfer(code, user, peer, xyz);
+                  break;
+               case 5: // RAM sold by the contract: EOS it receives without swapping
+                  token_transfer(eos_token, "eosio.ram"_n, code, eos);
+                  break;
+               case 6: // EOS moving between users
+                  token_transfer(eos_token, user, peer, eos);
+                  rows.push_back({true, eos_token, user, accounts, eos_symbol.code(), user,
+                                  encode_row(account{eos, false})});
+                  break;
+               default: // another contract with large actions and rows
+                  action(other, other, "update"_n, user, std::vector<char>(512, char(rng())));
+                  rows.push_back({rng() % 4 != 0, other, user, accounts, 1, user, std::vector<char>(300, 'o')});
+                  break;
+            }
+         }
+
+         append_frame(out, encode_blocks_result(block, transactions, rows, 20));
+      }
+      return counts;
+   }
+
+} // namespace xyz_tools
@@ -0,0 +1,172 @@
+#include <xyz/types.hpp>
+
+#include <ostream>
+
+namespace xyz_tools {
+
+   namespace {
+      constexpr std::string_view name_charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+
+      uint64_t char_to_value(char c) {
+         if (c == '.')
+            return 0;
+         if (c >= '1' && c <= '5')
+            return (c - '1') + 1;
+         if (c >= 'a' && c <= 'z')
+            return (c - 'a') + 6;
+         throw decode_error("invalid character in name: " + std::string(1, c));
+      }
+   } // namespace
+
+   name::name(std::string_view str) {
+      if (str.size() > 13)
+         throw decode_error("name is longer than 13 characters: " + std::string(str));
+      for (size_t i = 0; i < str.size() && i < 12; ++i)
+         value |= (char_to_value(str[i]) & 0x1f) << (64 - 5 * (i + 1));
+      if (str.size() == 13) {
+         const uint64_t v = char_to_value(str[12]);
+         if (v > 0x0f)
+            throw decode_error("thirteenth character of a name cannot be past 'j': " + std::string(str));
+         value |= v;
+      }
+   }
+
+   std::string name::to_string() const {
+      std::string str(13, '.');
+      uint64_t    tmp = value;
+      for (uint32_t i = 0; i <= 12; ++i) {
+         str[12 - i] = name_charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+         tmp >>= (i == 0 ? 4 : 5);
+      }
+      str.erase(str.find_last_not_of('.') + 1);
+      return str;
+   }
+
+   symbol::symbol(std::string_view code, uint8_t precision) {
+      if (code.empty() || code.size() > 7)
+         throw decode_error("invalid symbol code: " + std::string(code));
+      for (size_t i = code.size(); i-- > 0;) {
+         if (code[i] < 'A' || code[i] > 'Z')
+            throw decode_error("invalid symbol code: " + std::string(code));
+         value = (value << 8) | uint8_t(code[i]);
+      }
+      value = (value << 8) | precision;
+   }
+
+   std::string symbol::code_string() const {
+      std::string str;
+      for (uint64_t c = code(); c; c >>= 8)
+         str += char(c & 0xff);
+      return str;
+   }
+
+   std::string asset::to_string() const {
+      const uint8_t  precision = sym.precision();
+      const bool     negative  = amount < 0;
+      const uint64_t abs       = negative ? uint64_t(-(amount + 1)) + 1 : uint64_t(amount);
+
+      uint64_t p10 = 1;
+      for (uint8_t i = 0; i < precision; ++i)
+         p10 *= 10;
+
+      std::string result = std::to_string(abs / p10);
+      if (precision) {
+         std::string fraction = std::to_string(abs % p10);
+         result += '.' + std::string(precision - fraction.size(), '0') + fraction;
+      }
+      return (negative ? "-" : "") + result + " " + sym.code_string();
+   }
+
+   std::ostream& operator<<(std::ostream& out, name v) { return out << v.to_string(); }
+   std::ostream& operator<<(std::ostream& out, const asset& v) { return out << v.to_string(); }
+
+   // ----------------------------------------------------
+   // decoding -------------------------------------------
+   // ----------------------------------------------------
+
+   void decode(reader& r, name& v) { v.value = r.read<uint64_t>(); }
+   void decode(reader& r, symbol& v) { v.value = r.read<uint64_t>(); }
+
+   void decode(reader& r, asset& v) {
+      v.amount = r.read<int64_t>();
+      decode(r, v.sym);
+   }
+
+   void decode(reader& r, account& v) {
+      decode(r, v.balance);
+      v.released = r.read_bool();
+   }
+
+   void decode(reader& r, currency_stats& v) {
+      decode(r, v.supply);
+      decode(r, v.max_supply);
+      decode(r, v.issuer);
+   }
+
+   // Binary extensions: each one is present only if every one before it is.
+   void decode(reader& r, config& v) {
+      decode(r, v.token_symbol);
+      if (!r.empty())
+         v.swap_audit = r.read<uint8_t>();
+      if (!r.empty())
+         v.implicit_reserve = r.read_bool();
+      if (!r.empty())
+         v.commitment = r.read_bool();
+      if (!r.empty())
+         v.registry = r.read_bool();
+   }
+
+   void decode(reader& r, solvency_stats& v) {
+      decode(r, v.circulating);
+      decode(r, v.eos_held);
+      decode(r, v.swapped_in);
+      decode(r, v.swapped_out);
+   }
+
+   void decode(reader& r, blocked_recipient& v) { decode(r, v.account); }
+
+   // ----------------------------------------------------
+   // encoding -------------------------------------------
+   // ----------------------------------------------------
+
+   void encode(writer& w, name v) { w.write(v.value); }
+   void encode(writer& w, symbol v) { w.write(v.value); }
+
+   void encode(writer& w, const asset& v) {
+      w.write(v.amount);
+      encode(w, v.sym);
+   }
+
+   void encode(writer& w, const account& v) {
+      encode(w, v.balance);
+      w.write_bool(v.released);
+   }
+
+   void encode(writer& w, const currency_stats& v) {
+      encode(w, v.supply);
+      encode(w, v.max_supply);
+      encode(w, v.issuer);
+   }
+
+   void encode(writer& w, const config& v) {
+      encode(w, v.token_symbol);
+      if (v.swap_audit)
+         w.write(*v.swap_audit);
+      if (v.implicit_reserve)
+         w.write_bool(*v.implicit_reserve);
+      if (v.commitment)
+         w.write_bool(*v.commitment);
+      if (v.registry)
+         w.write_bool(*v.registry);
+   }
+
+   void encode(writer& w, const solvency_stats& v) {
+      encode(w, v.circulating);
+      encode(w, v.eos_held);
+      encode(w, v.swapped_in);
+      encode(w, v.swapped_out);
+   }
+
+   void encode(writer& w, const blocked_recipient& v) { encode(w, v.account); }
+
+} // namespace xyz_tools
@@ -0,0 +1,724 @@
+#include <xyz/wasm_meter.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <optional>
+
+namespace xyz_tools {
+
+   namespace {
+      // section ids
+      constexpr uint8_t custom_section = 0, type_section = 1, import_section = 2, function_section = 3,
+                        global_section = 6, export_section = 7, start_section = 8, element_section = 9,
+                        code_section = 10, datacount_section = 12;
+
+      constexpr uint8_t external_function = 0, external_table = 1, external_memory = 2, external_global = 3;
+      constexpr uint8_t valtype_i32 = 0x7f, valtype_i64 = 0x7e;
+
+      // opcodes the pass looks at or emits
+      constexpr uint8_t op_unreachable = 0x00, op_block = 0x02, op_loop = 0x03, op_if = 0x04, op_else = 0x05,
+                        op_end = 0x0b, op_br = 0x0c, op_br_if = 0x0d, op_br_table = 0x0e, op_return = 0x0f,
+                        op_call = 0x10, op_local_get = 0x20, op_global_get = 0x23, op_global_set = 0x24,
+                        op_i64_store = 0x37, op_i32_const = 0x41, op_i64_const = 0x42, op_i64_ne = 0x52,
+                        op_i64_add = 0x7c, op_prefix_fc = 0xfc;
+
+      // Position of a section in the order the binary format requires; custom sections may be anywhere.
+      int section_rank(uint8_t id) {
+         switch (id) {
+            case custom_section: return 0;
+            case datacount_section: return 10;
+            case code_section: return 11;
+            case 11: return 12; // data
+            default: return id;
+         }
+      }
+
+      void skip_leb(reader& r) {
+         for (int i = 0; r.read<uint8_t>() & 0x80; ++i)
+            if (i >= 9)
+               throw decode_error("LEB128 value is too long");
+      }
+
+      void write_varint64(writer& w, int64_t value) {
+         for (bool more = true; more;) {
+            uint8_t b = value & 0x7f;
+            value >>= 7;
+            more = !((value == 0 && !(b & 0x40)) || (value == -1 && (b & 0x40)));
+            w.write<uint8_t>(more ? b | 0x80 : b);
+         }
+      }
+
+      void skip_limits(reader& r) {
+         const uint8_t flags = r.read<uint8_t>();
+         r.read_varuint32();
+         if (flags & 1)
+            r.read_varuint32();
+      }
+
+      struct function_type {
+         std::string params;
+         std::string results;
+
+         bool operator==(const function_type&) const = default;
+      };
+
+      struct import_entry {
+         std::string_view module;
+         std::string_view field;
+         uint8_t          kind = 0;
+         uint32_t         type = 0;       // functions
+         std::string_view description;    // everything after the kind byte, as it was read
+      };
+
+      struct export_entry {
+         std::string_view name;
+         uint8_t          kind  = 0;
+         uint32_t         index = 0;
+      };
+
+      struct instruction {
+         uint8_t  opcode = 0;
+         uint32_t callee = 0; // `call` only
+         size_t   begin  = 0; // range in the function body
+         size_t   end    = 0;
+      };
+
+      // Reads the instruction at `r`'s position, skipping its immediates; `base` is the start of the body.
+      instruction read_instruction(reader& r, const char* base) {
+         instruction in;
+         in.begin  = r.pos() - base;
+         in.opcode = r.read<uint8_t>();
+         switch (in.opcode) {
+            case op_block:
+            case op_loop:
+            case op_if: {
+               const uint8_t type = r.read<uint8_t>();
+               if (type != 0x40 && (type < 0x7c || type > 0x7f)) { // a type index, as a signed LEB128
+                  for (uint8_t b = type; b & 0x80;)
+                     b = r.read<uint8_t>();
+               }
+               break;
+            }
+            case op_br:
+            case op_br_if:
+            case op_local_get:
+            case 0x21: // local.set
+            case 0x22: // local.tee
+            case op_global_get:
+            case op_global_set:
+               r.read_varuint32();
+               break;
+            case op_br_table:
+               for (uint32_t n = r.read_varuint32() + 1; n; --n)
+                  r.read_varuint32();
+               break;
+            case op_call:
+               in.callee = r.read_varuint32();
+               break;
+            case 0x11: // call_indirect
+               r.read_varuint32();
+               r.read<uint8_t>();
+               break;
+            case 0x3f: // memory.size
+            case 0x40: // memory.grow
+               r.read<uint8_t>();
+               break;
+            case op_i32_const:
+            case op_i64_const:
+               skip_leb(r);
+               break;
+            case 0x43: r.skip(4); break; // f32.const
+            case 0x44: r.skip(8); break; // f64.const
+            case op_prefix_fc: {
+               const uint32_t sub = r.read_varuint32();
+               if (sub <= 7) // saturating truncations
+                  break;
+               if (sub == 8) { // memory.init
+                  r.read_varuint32();
+                  r.read<uint8_t>();
+               } else if (sub == 9) { // data.drop
+                  r.read_varuint32();
+               } else if (sub == 10) { // memory.copy
+                  r.skip(2);
+               } else if (sub == 11) { // memory.fill
+                  r.skip(1);
+               } else {
+                  throw decode_error("unsupported instruction 0xfc " + std::to_string(sub));
+               }
+               break;
+            }
+            default:
+               if (in.opcode >= 0x28 && in.opcode <= 0x3e) { // loads and stores
+                  r.read_varuint32();
+                  r.read_varuint32();
+               } else if (!(in.opcode <= 0x01 || in.opcode == op_else || in.opcode == op_end ||
+                            in.opcode == op_return || in.opcode == 0x1a || in.opcode == 0x1b ||
+                            (in.opcode >= 0x45 && in.opcode <= 0xc4))) {
+                  throw decode_error("unsupported instruction " + std::to_string(in.opcode));
+               }
+         }
+         in.end = r.pos() - base;
+         return in;
+      }
+
+      // Instructions after which execution may not continue with the next one, or enters or leaves a block.
+      bool ends_segment(uint8_t opcode) {
+         switch (opcode) {
+            case op_unreachable:
+            case op_block:
+            case op_loop:
+            case op_if:
+            case op_else:
+            case op_end:
+            case op_br:
+            case op_br_if:
+            case op_br_table:
+            case op_return: return true;
+            default: return false;
+         }
+      }
+
+      // A function body split into its local declarations and its instructions.
+      struct function_body {
+         std::string_view         locals;
+         std::string_view         code;
+         std::vector<instruction> instructions;
+      };
+
+      function_body read_body(std::string_view body) {
+         reader        r(body);
+         function_body f;
+         for (uint32_t n = r.read_varuint32(); n; --n) {
+            r.read_varuint32();
+            r.read<uint8_t>();
+         }
+         f.locals = body.substr(0, r.pos() - body.data());
+         f.code   = body.substr(f.locals.size());
+         reader c(f.code);
+         while (!c.empty())
+            f.instructions.push_back(read_instruction(c, f.code.data()));
+         return f;
+      }
+
+      void add_counter(writer& w, uint32_t global, uint64_t amount) {
+         w.write<uint8_t>(op_global_get);
+         w.write_varuint32(global);
+         w.write<uint8_t>(op_i64_const);
+         write_varint64(w, int64_t(amount));
+         w.write<uint8_t>(op_i64_add);
+         w.write<uint8_t>(op_global_set);
+         w.write_varuint32(global);
+      }
+
+      void write_section(std::vector<char>& out, uint8_t id, const std::vector<char>& body) {
+         writer w(out);
+         w.write(id);
+         w.write_bytes({body.data(), body.size()});
+      }
+
+      class metering_pass {
+      public:
+         explicit metering_pass(std::string_view wasm) {
+            reader r(wasm);
+            if (r.read_view(4) != std::string_view("\0asm", 4) || r.read<uint32_t>() != 1)
+               throw decode_error("not a WASM binary module");
+            while (!r.empty()) {
+               const uint8_t id = r.read<uint8_t>();
+               _sections.push_back({id, r.read_bytes()});
+            }
+            read_types();
+            read_imports();
+            read_functions();
+            read_exports();
+         }
+
+         std::vector<char> run(meter_stats& stats) {
+            plan();
+
+            std::vector<char> out;
+            writer            w(out);
+            w.write_raw(std::string_view("\0asm", 4));
+            w.write(uint32_t(1));
+
+            // sections this pass always writes, added where the module has none
+            const uint8_t   required[] = {type_section, import_section, function_section, global_section,
+                                          export_section, code_section};
+            std::vector<bool> written(13);
+            auto flush_before = [&](int rank) {
+               for (const uint8_t id : required)
+                  if (!written[id] && section_rank(id) < rank) {
+                     write_section(out, id, rewrite(id, {}));
+                     written[id] = true;
+                  }
+            };
+            for (const auto& [id, body] : _sections) {
+               if (id == custom_section) {
+                  reader r(body);
+                  if (r.read_bytes() != "name")
+                     write_section(out, id, {body.begin(), body.end()});
+                  continue;
+               }
+               flush_before(section_rank(id));
+               write_section(out, id, rewrite(id, body));
+               if (id < written.size())
+                  written[id] = true;
+            }
+            flush_before(100);
+
+            stats = _stats;
+            return out;
+         }
+
+      private:
+         struct section {
+            uint8_t          id;
+            std::string_view body;
+         };
+
+         std::optional<std::string_view> find(uint8_t id) const {
+            for (const auto& s : _sections)
+               if (s.id == id)
+                  return s.body;
+            return {};
+         }
+
+         void read_types() {
+            if (auto body = find(type_section)) {
+               reader r(*body);
+               for (uint32_t n = r.read_varuint32(); n; --n) {
+                  if (r.read<uint8_t>() != 0x60)
+                     throw decode_error("bad function type");
+                  function_type t;
+                  t.params  = r.read_bytes();
+                  t.results = r.read_bytes();
+                  _types.push_back(std::move(t));
+               }
+            }
+         }
+
+         void read_imports() {
+            if (auto body = find(import_section)) {
+               reader r(*body);
+               for (uint32_t n = r.read_varuint32(); n; --n) {
+                  import_entry e;
+                  e.module          = r.read_bytes();
+                  e.field           = r.read_bytes();
+                  e.kind            = r.read<uint8_t>();
+                  const char* begin = r.pos();
+                  switch (e.kind) {
+                     case external_function: e.type = r.read_varuint32(); break;
+                     case external_table:
+                        r.read<uint8_t>();
+                        skip_limits(r);
+                        break;
+                     case external_memory:
+                        skip_limits(r);
+                        _has_memory = true;
+                        break;
+                     case external_global:
+                        r.skip(2);
+                        ++_imported_globals;
+                        break;
+                     default: throw decode_error("bad import kind");
+                  }
+                  e.description = {begin, size_t(r.pos() - begin)};
+                  if (e.kind == external_function)
+                     _function_imports.push_back(_imports.size());
+                  _imports.push_back(e);
+               }
+            }
+         }
+
+         void read_functions() {
+            if (auto body = find(function_section)) {
+               reader r(*body);
+               for (uint32_t n = r.read_varuint32(); n; --n)
+                  _function_types.push_back(r.read_varuint32());
+            }
+            if (auto body = find(code_section)) {
+               reader r(*body);
+               for (uint32_t n = r.read_varuint32(); n; --n)
+                  _bodies.push_back(read_body(r.read_bytes()));
+            }
+            if (_bodies.size() != _function_types.size())
+               throw decode_error("function and code sections differ in size");
+            if (auto body = find(5)) { // memory
+               reader r(*body);
+               _has_memory |= r.read_varuint32() > 0;
+            }
+            if (auto body = find(global_section)) {
+               reader r(*body);
+               _defined_globals = r.read_varuint32();
+            }
+         }
+
+         void read_exports() {
+            if (auto body = find(export_section)) {
+               reader r(*body);
+               for (uint32_t n = r.read_varuint32(); n; --n) {
+                  export_entry e;
+                  e.name  = r.read_bytes();
+                  e.kind  = r.read<uint8_t>();
+                  e.index = r.read_varuint32();
+                  _exports.push_back(e);
+               }
+            }
+         }
+
+         uint32_t type_index(const function_type& t) {
+            const auto it = std::find(_types.begin(), _types.end(), t);
+            if (it != _types.end())
+               return it - _types.begin();
+            _types.push_back(t);
+            return _types.size() - 1;
+         }
+
+         // The imported function `env.<field>`, as an index among the imported functions.
+         std::optional<uint32_t> imported_function(std::string_view field) const {
+            for (uint32_t i = 0; i < _function_imports.size(); ++i) {
+               const auto& e = _imports[_function_imports[i]];
+               if (e.module == "env" && e.field == field)
+                  return i;
+            }
+            return {};
+         }
+
+         // Decides the new imports, globals and functions, and the renumbering of the existing functions.
+         void plan() {
+            if (!_has_memory)
+               throw decode_error("module has no memory");
+            const auto apply = std::find_if(_exports.begin(), _exports.end(), [](const export_entry& e) {
+               return e.name == "apply" && e.kind == external_function;
+            });
+            if (apply == _exports.end() || apply->index < _function_imports.size())
+               throw decode_error("module does not export an `apply` function");
+
+            _old_imported_functions = _function_imports.size();
+            auto import = [&](std::string_view field, function_type type) {
+               if (auto existing = imported_function(field))
+                  return *existing;
+               _added_imports.push_back({"env", field, external_function, type_index(type), {}});
+               return uint32_t(_old_imported_functions + _added_imports.size() - 1);
+            };
+            _prints_l = import("prints_l", {{char(valtype_i32), char(valtype_i32)}, {}});
+            _printui  = import("printui", {{char(valtype_i64)}, {}});
+            _eosio_exit = imported_function("eosio_exit");
+
+            // a counter for the instructions, and one for each imported function the module calls
+            uint32_t next_global = _imported_globals + _defined_globals;
+            _instruction_counter = next_global++;
+            _host_counters.assign(_old_imported_functions, UINT32_MAX);
+            for (const auto& body : _bodies)
+               for (const auto& in : body.instructions)
+                  if (in.opcode == op_call && in.callee < _old_imported_functions &&
+                      _host_counters[in.callee] == UINT32_MAX) {
+                     _host_counters[in.callee] = 0;
+                  }
+            for (auto& counter : _host_counters)
+               if (counter == 0) {
+                  counter = next_global++;
+                  ++_stats.host_imports;
+               }
+
+            const uint32_t first_new = _old_imported_functions + _added_imports.size() + _bodies.size();
+            _apply        = renumber(apply->index);
+            _report       = first_new;
+            _meter_apply  = first_new + 1;
+            _meter_exit   = first_new + 2;
+            _apply_type   = _function_types[apply->index - _old_imported_functions];
+            _report_type  = type_index({});
+            _exit_type    = _eosio_exit ? _imports[_function_imports[*_eosio_exit]].type : 0;
+         }
+
+         uint32_t renumber(uint32_t function) const {
+            return function < _old_imported_functions ? function : function + _added_imports.size();
+         }
+
+         std::vector<char> rewrite(uint8_t id, std::string_view body) {
+            std::vector<char> out;
+            writer            w(out);
+            switch (id) {
+               case type_section:
+                  w.write_varuint32(_types.size());
+                  for (const auto& t : _types) {
+                     w.write<uint8_t>(0x60);
+                     w.write_bytes(t.params);
+                     w.write_bytes(t.results);
+                  }
+                  break;
+               case import_section:
+                  w.write_varuint32(_imports.size() + _added_imports.size());
+                  for (const auto& e : _imports)
+                     write_import(w, e);
+                  for (const auto& e : _added_imports)
+                     write_import(w, e);
+                  break;
+               case function_section:
+                  w.write_varuint32(_function_types.size() + 2 + (_eosio_exit ? 1 : 0));
+                  for (const auto t : _function_types)
+                     w.write_varuint32(t);
+                  w.write_varuint32(_report_type);
+                  w.write_varuint32(_apply_type);
+                  if (_eosio_exit)
+                     w.write_varuint32(_exit_type);
+                  break;
+               case global_section: {
+                  const uint32_t added = 1 + _stats.host_imports;
+                  w.write_varuint32(_defined_globals + added);
+                  if (!body.empty()) {
+                     reader r(body);
+                     r.read_varuint32();
+                     w.write_raw({r.pos(), r.remaining()});
+                  }
+                  for (uint32_t i = 0; i < added; ++i) {
+                     w.write<uint8_t>(valtype_i64);
+                     w.write<uint8_t>(1); // mutable
+                     w.write<uint8_t>(op_i64_const);
+                     w.write<uint8_t>(0);
+                     w.write<uint8_t>(op_end);
+                  }
+                  break;
+               }
+               case export_section:
+                  w.write_varuint32(_exports.size());
+                  for (const auto& e : _exports) {
+                     w.write_bytes(e.name);
+                     w.write(e.kind);
+                     if (e.kind != external_function)
+                        w.write_varuint32(e.index);
+                     else if (e.name == "apply")
+                        w.write_varuint32(_meter_apply);
+                     else
+                        w.write_varuint32(renumber(e.index));
+                  }
+                  break;
+               case start_section: {
+                  reader r(body);
+                  w.write_varuint32(renumber(r.read_varuint32()));
+                  break;
+               }
+               case element_section: {
+                  reader r(body);
+                  const uint32_t segments = r.read_varuint32();
+                  w.write_varuint32(segments);
+                  for (uint32_t s = 0; s < segments; ++s) {
+                     if (r.read_varuint32() != 0)
+                        throw decode_error("unsupported element segment");
+                     w.write_varuint32(0);
+                     const char* offset = r.pos();
+                     while (read_instruction(r, offset).opcode != op_end) {
+                     }
+                     w.write_raw({offset, size_t(r.pos() - offset)});
+                     const uint32_t n = r.read_varuint32();
+                     w.write_varuint32(n);
+                     for (uint32_t i = 0; i < n; ++i)
+                        w.write_varuint32(renumber(r.read_varuint32()));
+                  }
+                  break;
+               }
+               case code_section:
+                  w.write_varuint32(_bodies.size() + 2 + (_eosio_exit ? 1 : 0));
+                  for (const auto& body : _bodies)
+                     write_body(w, meter_body(body));
+                  write_body(w, report_body());
+                  write_body(w, meter_apply_body());
+                  if (_eosio_exit)
+                     write_body(w, meter_exit_body());
+                  break;
+               default: w.write_raw(body);
+            }
+            return out;
+         }
+
+         static void write_import(writer& w, const import_entry& e) {
+            w.write_bytes(e.module);
+            w.write_bytes(e.field);
+            w.write(e.kind);
+            if (e.description.empty())
+               w.write_varuint32(e.type);
+            else
+               w.write_raw(e.description);
+         }
+
+         static void write_body(writer& w, const std::vector<char>& body) { w.write_bytes({body.data(), body.size()}); }
+
+         std::vector<char> meter_body(const function_body& f) {
+            std::vector<char> out;
+            writer            w(out);
+            w.write_raw(f.locals);
+            ++_stats.functions;
+
+            const auto& ins = f.instructions;
+            for (size_t begin = 0; begin < ins.size();) {
+               size_t end = begin;
+               while (end < ins.size() && !ends_segment(ins[end++].opcode)) {
+               }
+
+               // what the segment costs, charged before it runs
+               ++_stats.segments;
+               add_counter(w, _instruction_counter, end - begin);
+               std::map<uint32_t, uint32_t> calls;
+               for (size_t i = begin; i < end; ++i)
+                  if (ins[i].opcode == op_call && ins[i].callee < _old_imported_functions)
+                     ++calls[ins[i].callee];
+               for (const auto& [import, count] : calls)
+                  add_counter(w, _host_counters[import], count);
+
+               for (size_t i = begin; i < end; ++i) {
+                  const auto& in = ins[i];
+                  if (in.opcode != op_call) {
+                     w.write_raw(f.code.substr(in.begin, in.end - in.begin));
+                  } else {
+                     w.write<uint8_t>(op_call);
+                     w.write_varuint32(_eosio_exit && in.callee == *_eosio_exit ? _meter_exit : renumber(in.callee));
+                  }
+               }
+               begin = end;
+            }
+            return out;
+         }
+
+         // Prints `text` from address 0.
+         void print(writer& w, std::string_view text) const {
+            for (size_t offset = 0; offset < text.size(); offset += 8) {
+               uint64_t chunk = 0;
+               std::memcpy(&chunk, text.data() + offset, std::min<size_t>(8, text.size() - offset));
+               w.write<uint8_t>(op_i32_const);
+               write_varint64(w, int64_t(offset));
+               w.write<uint8_t>(op_i64_const);
+               write_varint64(w, int64_t(chunk));
+               w.write<uint8_t>(op_i64_store);
+               w.write_varuint32(0); // alignment
+               w.write_varuint32(0); // offset
+            }
+            w.write<uint8_t>(op_i32_const);
+            write_varint64(w, 0);
+            w.write<uint8_t>(op_i32_const);
+            write_varint64(w, int64_t(text.size()));
+            w.write<uint8_t>(op_call);
+            w.write_varuint32(_prints_l);
+         }
+
+         void print_counter(writer& w, std::string_view label, uint32_t global) const {
+            print(w, label);
+            w.write<uint8_t>(op_global_get);
+            w.write_varuint32(global);
+            w.write<uint8_t>(op_call);
+            w.write_varuint32(_printui);
+            print(w, "\n");
+         }
+
+         std::vector<char> report_body() const {
+            std::vector<char> out;
+            writer            w(out);
+            w.write_varuint32(0); // locals
+            print_counter(w, "meter:instructions:", _instruction_counter);
+            for (uint32_t i = 0; i < _host_counters.size(); ++i) {
+               if (_host_counters[i] == UINT32_MAX)
+                  continue;
+               w.write<uint8_t>(op_global_get);
+               w.write_varuint32(_host_counters[i]);
+               w.write<uint8_t>(op_i64_const);
+               w.write<uint8_t>(0);
+               w.write<uint8_t>(op_i64_ne);
+               w.write<uint8_t>(op_if);
+               w.write<uint8_t>(0x40);
+               const auto& e = _imports[_function_imports[i]];
+               print_counter(w, "meter:host:" + std::string(e.field) + ":", _host_counters[i]);
+               w.write<uint8_t>(op_end);
+            }
+            w.write<uint8_t>(op_end);
+            return out;
+         }
+
+         std::vector<char> meter_apply_body() const {
+            std::vector<char> out;
+            writer            w(out);
+            w.write_varuint32(0);
+            for (uint32_t i = 0; i < _types[_apply_type].params.size(); ++i) {
+               w.write<uint8_t>(op_local_get);
+               w.write_varuint32(i);
+            }
+            w.write<uint8_t>(op_call);
+            w.write_varuint32(_apply);
+            w.write<uint8_t>(op_call);
+            w.write_varuint32(_report);
+            w.write<uint8_t>(op_end);
+            return out;
+         }
+
+         std::vector<char> meter_exit_body() const {
+            std::vector<char> out;
+            writer            w(out);
+            w.write_varuint32(0);
+            w.write<uint8_t>(op_call);
+            w.write_varuint32(_report);
+            w.write<uint8_t>(op_local_get);
+            w.write_varuint32(0);
+            w.write<uint8_t>(op_call);
+            w.write_varuint32(*_eosio_exit);
+            w.write<uint8_t>(op_end);
+            return out;
+         }
+
+         std::vector<section>       _sections;
+         std::vector<function_type> _types;
+         std::vector<import_entry>  _imports;
+         std::vector<uint32_t>      _function_imports; // indices in `_imports` of the imported functions
+         std::vector<import_entry>  _added_imports;
+         std::vector<uint32_t>      _function_types;
+         std::vector<function_body> _bodies;
+         std::vector<export_entry>  _exports;
+         uint32_t                   _imported_globals = 0;
+         uint32_t                   _defined_globals  = 0;
+         bool                       _has_memory       = false;
+
+         uint32_t                _old_imported_functions = 0;
+         uint32_t                _prints_l = 0, _printui = 0;
+         std::optional<uint32_t> _eosio_exit;
+         uint32_t                _instruction_counter = 0;
+         std::vector<uint32_t>   _host_counters; // global per imported function, UINT32_MAX when never called
+         uint32_t                _apply = 0, _report = 0, _meter_apply = 0, _meter_exit = 0;
+         uint32_t                _apply_type = 0, _report_type = 0, _exit_type = 0;
+         meter_stats             _stats;
+      };
+   } // namespace
+
+   meter_counts& meter_counts::operator+=(const meter_counts& other) {
+      instructions += other.instructions;
+      host_calls += other.host_calls;
+      for (const auto& [function, count] : other.host)
+         host[function] += count;
+      return *this;
+   }
+
+   std::vector<char> meter_wasm(std::string_view wasm, meter_stats* stats) {
+      meter_stats ignored;
+      return metering_pass(wasm).run(stats ? *stats : ignored);
+   }
+
+   meter_counts parse_meter_console(std::string_view console) {
+      meter_counts counts;
+      while (!console.empty()) {
+         const size_t     eol  = console.find('\n');
+         std::string_view line = console.substr(0, eol);
+         console.remove_prefix(eol == std::string_view::npos ? console.size() : eol + 1);
+         if (!line.starts_with("meter:"))
+            continue;
+
+         const size_t sep   = line.rfind(':');
+         uint64_t     count = 0;
+         if (std::from_chars(line.data() + sep + 1, line.data() + line.size(), count).ec != std::errc())
+            continue;
+         const auto label = line.substr(6, sep - 6);
+         if (label == "instructions") {
+            counts.instructions += count;
+         } else if (label.starts_with("host:")) {
+            counts.host[std::string(label.substr(5))] += count;
+            counts.host_calls += count;
+         }
+      }
+      return counts;
+   }
+
+} // namespace xyz_tools
@@ -0,0 +1,248 @@
+#include <boost/test/unit_test.hpp>
+
+#include <xyz/ship_writer.hpp>
+#include <xyz/synthetic.hpp>
+
+using namespace xyz_tools;
+
+namespace {
+
+   const name   code = "xyz"_n, eos_token = "eosio.token"_n, transfer = "transfer"_n;
+   const symbol xyz_symbol("XYZ", 4);
+   const symbol eos_symbol("EOS", 4);
+
+   // Collects every event of every batch, copying the views out of the messages.
+   struct collector {
+      std::vector<transfer_event> transfers;
+      std::vector<swap_event>     swaps;
+      std::vector<balance_event>  balances;
+      std::vector<std::string>    memos;
+      size_t                      batches = 0;
+
+      ship_decoder::sink sink() {
+         return [this](const event_batch& batch) {
+            ++batches;
+            for (const auto& t : batch.transfers) {
+               transfers.push_back(t);
+               memos.emplace_back(t.memo);
+            }
+            swaps.insert(swaps.end(), batch.swaps.begin(), batch.swaps.end());
+            balances.insert(balances.end(), batch.balances.begin(), batch.balances.end());
+         };
+      }
+   };
+
+   // A transfer of `token` with its notifications, as the chain traces it.
+   void add_transfer(trace_transaction& trx, name token, name from, name to, const asset& quantity,
+                     uint64_t& global_sequence, std::string_view memo = "") {
+      const auto data = encode_transfer(from, to, quantity, memo);
+      trx.actions.push_back({token, token, transfer, from, data, ++global_sequence, {}});
+      for (const name notified : {from, to})
+         if (notified != token)
+            trx.actions.push_back({notified, token, transfer, from, data, ++global_sequence, {}});
+   }
+
+   std::vector<char> decode_all(const std::vector<std::vector<char>>& messages, collector& out,
+                                decoder_options options = {}) {
+      std::vector<char> recording;
+      for (const auto& m : messages)
+         append_frame(recording, m);
+      ship_decoder decoder(options, out.sink());
+      replay_recording({recording.data(), recording.size()}, decoder);
+      return recording;
+   }
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ship_tests)
+
+BOOST_AUTO_TEST_CASE(transfers_and_swaps) {
+   uint64_t          seq = 0;
+   trace_transaction trx;
+   trx.id[0] = 'a';
+   add_transfer(trx, code, "alice"_n, "bob"_n, {100, xyz_symbol}, seq, "hello");
+   add_transfer(trx, eos_token, "alice"_n, code, {200, eos_symbol}, seq);    // swapped to XYZ...
+   add_transfer(trx, code, code, "alice"_n, {200, xyz_symbol}, seq);         // ...and sent back
+   add_transfer(trx, code, "bob"_n, code, {300, xyz_symbol}, seq);           // swapped to EOS...
+   add_transfer(trx, eos_token, code, "bob"_n, {300, eos_symbol}, seq);      // ...and paid out
+   add_transfer(trx, eos_token, "eosio.ram"_n, code, {400, eos_symbol}, seq); // RAM sold, not a swap
+   add_transfer(trx, eos_token, "alice"_n, "bob"_n, {500, eos_symbol}, seq);  // not ours
+   add_transfer(trx, "fake.token"_n, "alice"_n, code, {600, eos_symbol}, seq); // not EOS
+
+   collector events;
+   decode_all({encode_blocks_result(7, {trx}, {})}, events);
+
+   BOOST_REQUIRE_EQUAL(events.transfers.size(), 3u);
+   BOOST_REQUIRE_EQUAL(events.transfers[0].from, "alice"_n);
+   BOOST_REQUIRE_EQUAL(events.transfers[0].to, "bob"_n);
+   BOOST_REQUIRE_EQUAL(events.transfers[0].quantity, (asset{100, xyz_symbol}));
+   BOOST_REQUIRE_EQUAL(events.memos[0], "hello");
+   BOOST_REQUIRE_EQUAL(events.transfers[0].block_num, 7u);
+   BOOST_REQUIRE_EQUAL(events.transfers[0].global_sequence, 1u);
+   BOOST_REQUIRE_EQUAL(events.transfers[1].from, code);
+   BOOST_REQUIRE_EQUAL(events.transfers[2].to, code);
+
+   BOOST_REQUIRE_EQUAL(events.swaps.size(), 2u);
+   BOOST_REQUIRE(events.swaps[0].direction == swap_direction::to_xyz);
+   BOOST_REQUIRE_EQUAL(events.swaps[0].account, "alice"_n);
+   BOOST_REQUIRE_EQUAL(events.swaps[0].quantity, (asset{200, eos_symbol}));
+   BOOST_REQUIRE(events.swaps[1].direction == swap_direction::to_eos);
+   BOOST_REQUIRE_EQUAL(events.swaps[1].account, "bob"_n);
+   BOOST_REQUIRE_EQUAL(events.swaps[1].quantity, (asset{300, eos_symbol}));
+}
+
+BOOST_AUTO_TEST_CASE(failed_transactions) {
+   uint64_t          seq = 0;
+   trace_transaction failed, executed;
+   failed.executed = false;
+   add_transfer(failed, code, "alice"_n, "bob"_n, {100, xyz_symbol}, seq);
+   add_transfer(executed, code, "bob"_n, "alice"_n, {50, xyz_symbol}, seq);
+
+   collector events;
+   ship_decoder decoder({}, events.sink());
+   const auto   message = encode_blocks_result(1, {failed, executed}, {});
+   decoder.decode_message({message.data(), message.size()});
+   decoder.flush();
+
+   BOOST_REQUIRE_EQUAL(events.transfers.size(), 1u);
+   BOOST_REQUIRE_EQUAL(events.transfers[0].from, "bob"_n);
+   BOOST_REQUIRE_EQUAL(decoder.stats().transactions, 1u);
+   BOOST_REQUIRE_EQUAL(decoder.stats().actions, 6u); // failed ones are still traced
+}
+
+BOOST_AUTO_TEST_CASE(replayable_transactions) {
+   uint64_t          seq = 0;
+   trace_transaction transfer_trx, swap_trx, foreign_trx, failed_trx;
+   transfer_trx.id[0] = 't';
+   add_transfer(transfer_trx, code, "alice"_n, "bob"_n, {100, xyz_symbol}, seq, "memo");
+   add_transfer(swap_trx, eos_token, "bob"_n, code, {200, eos_symbol}, seq);
+   add_transfer(foreign_trx, "fake.token"_n, "alice"_n, "bob"_n, {300, eos_symbol}, seq);
+   failed_trx.executed = false;
+   add_transfer(failed_trx, code, "alice"_n, "bob"_n, {400, xyz_symbol}, seq);
+   const auto message = encode_blocks_result(9, {transfer_trx, swap_trx, foreign_trx, failed_trx}, {});
+
+   // off by default
+   collector events;
+   decode_all({message}, events);
+   BOOST_REQUIRE_EQUAL(events.transfers.size(), 1u);
+
+   std::vector<transaction_event> transactions;
+   std::vector<std::vector<char>> data;
+   decoder_options                options;
+   options.transactions = true;
+   ship_decoder decoder(options, [&](const event_batch& batch) {
+      for (const auto& t : batch.transactions) {
+         transactions.push_back(t);
+         data.emplace_back(t.actions[0].data.begin(), t.actions[0].data.end());
+      }
+   });
+   decoder.decode_message({message.data(), message.size()});
+   decoder.flush();
+
+   // only the input actions of the executed transactions of the two contracts, not the notifications
+   BOOST_REQUIRE_EQUAL(transactions.size(), 2u);
+   const auto& t = transactions[0];
+   BOOST_REQUIRE_EQUAL(t.block_num, 9u);
+   BOOST_REQUIRE_EQUAL(t.cpu_usage_us, 100u);
+   BOOST_REQUIRE_EQUAL(t.net_usage_words, 16u);
+   BOOST_REQUIRE_EQUAL(t.actions.size(), 1u);
+   BOOST_REQUIRE_EQUAL(t.actions[0].account, code);
+   BOOST_REQUIRE_EQUAL(t.actions[0].act, transfer);
+   BOOST_REQUIRE_EQUAL(t.actions[0].authorization.size(), 1u);
+   BOOST_REQUIRE_EQUAL(t.actions[0].authorization[0].first, "alice"_n);
+   BOOST_REQUIRE_EQUAL(t.actions[0].authorization[0].second, "active"_n);
+   BOOST_REQUIRE(data[0] == encode_transfer("alice"_n, "bob"_n, {100, xyz_symbol}, "memo"));
+   BOOST_REQUIRE_EQUAL(transactions[1].actions[0].account, eos_token);
+   BOOST_REQUIRE_EQUAL(transactions[1].actions[0].authorization[0].first, "bob"_n);
+}
+
+BOOST_AUTO_TEST_CASE(balance_deltas) {
+   std::vector<trace_row> rows;
+   rows.push_back({true, code, "alice"_n, "accounts"_n, xyz_symbol.code(), "alice"_n,
+                   encode_row(account{{100, xyz_symbol}, true})});
+   rows.push_back({false, code, "bob"_n, "accounts"_n, xyz_symbol.code(), code,
+                   encode_row(account{{0, xyz_symbol}, false})});
+   rows.push_back({true, eos_token, "alice"_n, "accounts"_n, eos_symbol.code(), "alice"_n,
+                   encode_row(account{{5, eos_symbol}, false})});
+   rows.push_back({true, code, code, "config"_n, 0, code, std::vector<char>(8, 'c')});
+
+   collector events;
+   decode_all({encode_blocks_result(3, {}, rows, 10)}, events);
+
+   BOOST_REQUIRE_EQUAL(events.balances.size(), 2u);
+   BOOST_REQUIRE_EQUAL(events.balances[0].owner, "alice"_n);
+   BOOST_REQUIRE(events.balances[0].present);
+   BOOST_REQUIRE_EQUAL(events.balances[0].row.balance, (asset{100, xyz_symbol}));
+   BOOST_REQUIRE(events.balances[0].row.released);
+   BOOST_REQUIRE_EQUAL(events.balances[0].block_num, 3u);
+   BOOST_REQUIRE_EQUAL(events.balances[1].owner, "bob"_n);
+   BOOST_REQUIRE(!events.balances[1].present);
+   BOOST_REQUIRE_EQUAL(events.balances[1].payer, code);
+}
+
+BOOST_AUTO_TEST_CASE(batching) {
+   uint64_t          seq = 0;
+   trace_transaction trx;
+   for (int i = 0; i < 10; ++i)
+      add_transfer(trx, code, "alice"_n, "bob"_n, {i + 1, xyz_symbol}, seq);
+
+   collector       events;
+   decoder_options options;
+   options.batch_size = 4;
+   ship_decoder decoder(options, events.sink());
+   const auto   message = encode_blocks_result(1, {trx}, {});
+   decoder.decode_message({message.data(), message.size()});
+   BOOST_REQUIRE_EQUAL(events.batches, 2u);
+   BOOST_REQUIRE_EQUAL(events.transfers.size(), 8u);
+
+   decoder.flush();
+   decoder.flush();
+   BOOST_REQUIRE_EQUAL(events.batches, 3u);
+   BOOST_REQUIRE_EQUAL(events.transfers.size(), 10u);
+   BOOST_REQUIRE_EQUAL(events.transfers[9].quantity.amount, 10);
+}
+
+BOOST_AUTO_TEST_CASE(status_and_signatures) {
+   uint64_t          seq = 0;
+   trace_transaction trx;
+   trx.webauthn = true;
+   add_transfer(trx, code, "alice"_n, "bob"_n, {1, xyz_symbol}, seq);
+
+   collector events;
+   ship_decoder decoder({}, events.sink());
+   const auto   recording = decode_all({encode_status_result(5), encode_blocks_result(5, {trx, trx}, {})}, events);
+   BOOST_REQUIRE_EQUAL(events.transfers.size(), 2u);
+
+   // a truncated message is reported, not read past
+   const auto message = encode_blocks_result(5, {trx}, {});
+   BOOST_REQUIRE_THROW(decoder.decode_message({message.data(), message.size() - 1}), decode_error);
+   BOOST_REQUIRE_THROW(replay_recording({recording.data(), recording.size() - 1}, decoder), decode_error);
+}
+
+BOOST_AUTO_TEST_CASE(synthetic_recording) {
+   synthetic_recording_options options;
+   options.blocks       = 50;
+   options.transactions = 40;
+   std::vector<char> recording;
+   const auto        expected = write_synthetic_recording(options, recording);
+   BOOST_REQUIRE(expected.transfers > 0 && expected.swaps_to_xyz > 0 && expected.swaps_to_eos > 0);
+
+   size_t       transfers = 0, to_xyz = 0, to_eos = 0, balances = 0;
+   ship_decoder decoder({}, [&](const event_batch& batch) {
+      transfers += batch.transfers.size();
+      for (const auto& s : batch.swaps)
+         ++(s.direction == swap_direction::to_xyz ? to_xyz : to_eos);
+      balances += batch.balances.size();
+   });
+   replay_recording({recording.data(), recording.size()}, decoder);
+
+   BOOST_REQUIRE_EQUAL(transfers, expected.transfers);
+   BOOST_REQUIRE_EQUAL(to_xyz, expected.swaps_to_xyz);
+   BOOST_REQUIRE_EQUAL(to_eos, expected.swaps_to_eos);
+   BOOST_REQUIRE_EQUAL(balances, expected.balances);
+   BOOST_REQUIRE_EQUAL(decoder.stats().messages, options.blocks + 1);
+   BOOST_REQUIRE_EQUAL(decoder.stats().blocks, options.blocks);
+   BOOST_REQUIRE_EQUAL(decoder.stats().bytes + 4 * decoder.stats().messages, recording.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,226 @@
+#include <boost/test/unit_test.hpp>
+
+#include <xyz/contract_state.hpp>
+#include <xyz/synthetic.hpp>
+
+#include <filesystem>
+#include <unistd.h>
+
+using namespace xyz_tools;
+
+namespace {
+
+   // A snapshot file that is removed at the end of the test.
+   struct temp_snapshot {
+      std::string path;
+
+      explicit temp_snapshot(const std::string& label)
+         : path((std::filesystem::temp_directory_path() /
+                 ("xyz_tools_" + label + "_" + std::to_string(::getpid()) + ".snapshot"))
+                   .string()) {}
+      ~temp_snapshot() { std::filesystem::remove(path); }
+   };
+
+   std::string write_synthetic(const temp_snapshot& file, const synthetic_options& options) {
+      snapshot_writer writer;
+      write_synthetic_snapshot(options, writer);
+      writer.write_file(file.path);
+      return file.path;
+   }
+
+   const symbol xyz_symbol("XYZ", 4);
+
+   std::vector<char> balance(int64_t amount, bool released) {
+      return encode_row(account{{amount, xyz_symbol}, released});
+   }
+
+   table_row row(uint64_t primary_key, name payer, const std::vector<char>& value) {
+      table_row r;
+      r.primary_key = primary_key;
+      r.payer       = payer;
+      r.value       = {value.data(), value.size()};
+      return r;
+   }
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(snapshot_tests)
+
+BOOST_AUTO_TEST_CASE(types) {
+   for (const char* s : {"xyz", "eosio.token", "alice", "a", "zzzzzzzzzzzzj", "h1111111112z", "1.2.3"})
+      BOOST_REQUIRE_EQUAL(name(s).to_string(), s);
+   BOOST_REQUIRE_EQUAL(name("eosio").value, 0x5530ea0000000000ull);
+
+   BOOST_REQUIRE_EQUAL(xyz_symbol.code_string(), "XYZ");
+   BOOST_REQUIRE_EQUAL((asset{12345, xyz_symbol}.to_string()), "1.2345 XYZ");
+   BOOST_REQUIRE_EQUAL((asset{-5, xyz_symbol}.to_string()), "-0.0005 XYZ");
+   BOOST_REQUIRE_EQUAL((asset{7, symbol("EOS", 0)}.to_string()), "7 EOS");
+
+   // a config written before any binary extension existed, and one with all of them
+   config old_cfg;
+   old_cfg.token_symbol = xyz_symbol;
+   const auto decoded   = decode_row<config>({encode_row(old_cfg).data(), 8});
+   BOOST_REQUIRE(!decoded.swap_audit && !decoded.implicit_reserve && !decoded.commitment && !decoded.registry);
+
+   config new_cfg           = old_cfg;
+   new_cfg.swap_audit       = 1;
+   new_cfg.implicit_reserve = true;
+   new_cfg.commitment       = false;
+   new_cfg.registry         = true;
+   const auto packed        = encode_row(new_cfg);
+   BOOST_REQUIRE_EQUAL(packed.size(), 8 + 1 + 1 + 1 + 1);
+   const auto round_trip    = decode_row<config>({packed.data(), packed.size()});
+   BOOST_REQUIRE(round_trip.commitment == false && round_trip.registry == true);
+
+   const auto row = encode_row(account{{1, xyz_symbol}, true});
+   BOOST_REQUIRE_THROW(decode_row<account>({row.data(), row.size() - 1}), decode_error);
+}
+
+BOOST_AUTO_TEST_CASE(reconcile_synthetic) {
+   temp_snapshot file("reconcile");
+   synthetic_options options;
+   options.holders   = 5000;
+   options.mutations = 500;
+   const snapshot snap(write_synthetic(file, options));
+
+   BOOST_REQUIRE_EQUAL(snap.version(), 8u);
+   BOOST_REQUIRE_EQUAL(snap.sections().size(), 4u);
+
+   const auto state = load_contract_state(snap, "xyz"_n);
+   BOOST_REQUIRE(state.cfg);
+   BOOST_REQUIRE(state.solvency);
+   BOOST_REQUIRE(state.eos_held);
+   BOOST_REQUIRE_EQUAL(state.stats.size(), 1u);
+   BOOST_REQUIRE(!state.blocked.empty());
+
+   const auto single = reconcile(state, 1);
+   BOOST_REQUIRE(single.ok());
+   BOOST_REQUIRE(single.solvency_mismatches.empty());
+   BOOST_REQUIRE_EQUAL(single.tokens[0].holders + 1, state.accounts.size()); // every row but the reserve
+
+   const auto parallel = reconcile(state, 8);
+   BOOST_REQUIRE(parallel.ok());
+   BOOST_REQUIRE(parallel.tokens[0].holder_sum == single.tokens[0].holder_sum);
+   BOOST_REQUIRE_EQUAL(parallel.tokens[0].released, single.tokens[0].released);
+   BOOST_REQUIRE_EQUAL(parallel.tokens[0].reserve, single.tokens[0].reserve);
+
+   // the same rows of another contract are not counted
+   const auto other = load_contract_state(snap, "otherdapp"_n);
+   BOOST_REQUIRE(other.stats.empty());
+   BOOST_REQUIRE_THROW(reconcile(other, 4), decode_error);
+}
+
+BOOST_AUTO_TEST_CASE(reconcile_implicit_reserve) {
+   temp_snapshot file("implicit");
+   synthetic_options options;
+   options.holders          = 1000;
+   options.implicit_reserve = true;
+   const snapshot snap(write_synthetic(file, options));
+
+   const auto result = reconcile(load_contract_state(snap, "xyz"_n), 4);
+   BOOST_REQUIRE(result.ok());
+   BOOST_REQUIRE(result.tokens[0].implicit_reserve);
+
+   // the reserve is derived from the solvency counters, not from the EOS the contract holds
+   BOOST_REQUIRE(reconcile(load_contract_state(snap, "xyz"_n, "notatoken"_n), 4).ok());
+   auto state = load_contract_state(snap, "xyz"_n);
+   state.solvency.reset();
+   BOOST_REQUIRE_THROW(reconcile(state, 4), decode_error);
+}
+
+BOOST_AUTO_TEST_CASE(reconcile_mismatch) {
+   const name     code = "xyz"_n, alice = "alice"_n, bob = "bob"_n;
+   const auto     stat = encode_row(currency_stats{{100, xyz_symbol}, {100, xyz_symbol}, code});
+   const auto     reserve = balance(60, true), a = balance(30, true), b = balance(11, false);
+   temp_snapshot  file("mismatch");
+   snapshot_writer writer;
+   writer.begin_contract_tables();
+   writer.add_table(code, name(xyz_symbol.code()), "stat"_n, code, {row(xyz_symbol.code(), code, stat)});
+   writer.add_table(code, code, "accounts"_n, code, {row(xyz_symbol.code(), code, reserve)});
+   writer.add_table(code, alice, "accounts"_n, alice, {row(xyz_symbol.code(), alice, a)}, 5);
+   writer.add_table(code, bob, "accounts"_n, code, {row(xyz_symbol.code(), code, b)});
+   writer.end_contract_tables();
+   writer.write_file(file.path);
+
+   const auto result = reconcile(load_contract_state(snapshot(file.path), code), 2);
+   BOOST_REQUIRE(!result.ok());
+   BOOST_REQUIRE(result.tokens[0].total() == 101);
+   BOOST_REQUIRE_EQUAL(result.tokens[0].holders, 2u);
+   BOOST_REQUIRE_EQUAL(result.tokens[0].released, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(diff_rows) {
+   const name code = "xyz"_n, alice = "alice"_n, bob = "bob"_n, carol = "carol"_n, dave = "dave"_n;
+   const auto pk   = xyz_symbol.code();
+
+   const auto a1 = balance(10, true), b1 = balance(20, false), c1 = balance(30, false);
+   const auto a2 = balance(15, true), b2 = balance(20, true), d2 = balance(1, true);
+   const auto blocked = encode_row(blocked_recipient{carol});
+
+   temp_snapshot before("diff_before"), after("diff_after");
+   {
+      snapshot_writer writer;
+      writer.begin_contract_tables();
+      writer.add_table(code, carol, "accounts"_n, code, {row(pk, code, c1)});
+      writer.add_table(code, alice, "accounts"_n, alice, {row(pk, alice, a1)});
+      writer.add_table(code, bob, "accounts"_n, code, {row(pk, code, b1)});
+      writer.end_contract_tables();
+      writer.write_file(before.path);
+   }
+   {
+      snapshot_writer writer;
+      writer.begin_contract_tables();
+      writer.add_table(code, code, "blocked"_n, carol, {row(carol.value, carol, blocked)});
+      writer.add_table(code, dave, "accounts"_n, dave, {row(pk, dave, d2)});
+      writer.add_table(code, bob, "accounts"_n, bob, {row(pk, bob, b2)});
+      writer.add_table(code, alice, "accounts"_n, alice, {row(pk, alice, a2)});
+      writer.end_contract_tables();
+      writer.write_file(after.path);
+   }
+
+   const snapshot before_snap(before.path), after_snap(after.path);
+   const auto     b = load_contract_state(before_snap, code), a = load_contract_state(after_snap, code);
+
+   for (unsigned threads : {1u, 3u}) {
+      const auto result = diff(b, a, threads);
+      BOOST_REQUIRE_EQUAL(result.accounts.size(), 4u);
+      BOOST_REQUIRE_EQUAL(result.created, 1u);
+      BOOST_REQUIRE_EQUAL(result.erased, 1u);
+      BOOST_REQUIRE_EQUAL(result.balance_changed, 1u);
+      BOOST_REQUIRE_EQUAL(result.released_changed, 1u);
+      BOOST_REQUIRE_EQUAL(result.payer_changed, 1u);
+      BOOST_REQUIRE_EQUAL(result.blocked_added.size(), 1u);
+
+      // ordered by owner
+      BOOST_REQUIRE_EQUAL(to_string(result.accounts[0]), "~ alice balance 0.0010 XYZ -> 0.0015 XYZ");
+      BOOST_REQUIRE_EQUAL(to_string(result.accounts[1]), "~ bob released 0 -> 1 payer xyz -> bob");
+      BOOST_REQUIRE_EQUAL(to_string(result.accounts[2]), "- carol 0.0030 XYZ");
+      BOOST_REQUIRE_EQUAL(to_string(result.accounts[3]), "+ dave 0.0001 XYZ released payer dave");
+   }
+
+   BOOST_REQUIRE(diff(b, b, 4).empty());
+}
+
+BOOST_AUTO_TEST_CASE(diff_synthetic) {
+   temp_snapshot before("synthetic_before"), after("synthetic_after");
+   synthetic_options options;
+   options.holders = 20000;
+   const snapshot before_snap(write_synthetic(before, options));
+   options.mutations = 300;
+   const snapshot after_snap(write_synthetic(after, options));
+
+   const auto b = load_contract_state(before_snap, "xyz"_n), a = load_contract_state(after_snap, "xyz"_n);
+   BOOST_REQUIRE(reconcile(a, 4).ok());
+
+   const auto single   = diff(b, a, 1);
+   const auto parallel = diff(b, a, 7);
+   BOOST_REQUIRE(!single.empty());
+   BOOST_REQUIRE_EQUAL(single.accounts.size(), parallel.accounts.size());
+   for (size_t i = 0; i < single.accounts.size(); ++i)
+      BOOST_REQUIRE_EQUAL(to_string(single.accounts[i]), to_string(parallel.accounts[i]));
+   BOOST_REQUIRE_EQUAL(single.created, parallel.created);
+   BOOST_REQUIRE_EQUAL(single.erased, parallel.erased);
+   BOOST_REQUIRE_EQUAL(single.singletons.size(), 1u); // the solvency counters, nothing else
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,378 @@
+#include <boost/test/unit_test.hpp>
+
+#include <xyz/wasm_meter.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace xyz_tools;
+
+namespace {
+
+   std::string bytes(std::initializer_list<uint8_t> b) { return {b.begin(), b.end()}; }
+
+   void add_section(writer& w, uint8_t id, const std::string& body) {
+      w.write(id);
+      w.write_bytes(body);
+   }
+
+   std::string code_body(const std::string& locals, const std::string& instructions) {
+      std::vector<char> out;
+      writer            w(out);
+      w.write_bytes(locals + instructions);
+      return {out.begin(), out.end()};
+   }
+
+   // A contract whose `apply` calls a helper three times in a loop, the helper calling `require_auth` and
+   // `current_time`, then calls `eosio_exit` when `code` is 0. Instructions executed, counted the way the pass
+   // counts them:
+   //
+   //    3 before the loop, 3 x 7 in it, 1 for its `end`, 3 for the `if`, 3 x 5 in the helper,
+   //    then 3 in the `if` when it exits, or 1 for the final `end` when it returns.
+   std::vector<char> sample_contract(bool with_apply = true) {
+      std::vector<char> out;
+      writer            w(out);
+      w.write_raw(std::string_view("\0asm", 4));
+      w.write(uint32_t(1));
+
+      add_section(w, 1, bytes({4,                                  // types
+                               0x60, 1, 0x7e, 0,                   // 0: (i64) -> ()
+                               0x60, 0, 1, 0x7e,                   // 1: () -> i64
+                               0x60, 1, 0x7f, 0,                   // 2: (i32) -> ()
+                               0x60, 3, 0x7e, 0x7e, 0x7e, 0}));    // 3: (i64, i64, i64) -> ()
+      add_section(w, 2, bytes({3}) +                               // imports
+                           bytes({3}) + "env" + bytes({12}) + "require_auth" + bytes({0, 0}) +
+                           bytes({3}) + "env" + bytes({12}) + "current_time" + bytes({0, 1}) +
+                           bytes({3}) + "env" + bytes({10}) + "eosio_exit" + bytes({0, 2}));
+      add_section(w, 3, bytes({2, 0, 3}));                         // helper: 3, apply: 4
+      add_section(w, 5, bytes({1, 0, 1}));                         // one page
+      if (with_apply)
+         add_section(w, 7, bytes({1, 5}) + "apply" + bytes({0, 4}));
+      const std::string helper = code_body(bytes({0}), bytes({0x20, 0,     // local.get 0
+                                                              0x10, 0,     // call require_auth
+                                                              0x10, 1,     // call current_time
+                                                              0x1a,        // drop
+                                                              0x0b}));
+      const std::string apply  = code_body(bytes({1, 1, 0x7f}),            // one i32 local: 3
+                                           bytes({0x41, 3, 0x21, 3,        // i32.const 3; local.set 3
+                                                  0x03, 0x40,              // loop
+                                                  0x20, 0, 0x10, 3,        //   local.get 0; call helper
+                                                  0x20, 3, 0x41, 1, 0x6b,  //   local.get 3; i32.const 1; i32.sub
+                                                  0x22, 3, 0x0d, 0,        //   local.tee 3; br_if 0
+                                                  0x0b,                    // end
+                                                  0x20, 1, 0x50,           // local.get 1; i64.eqz
+                                                  0x04, 0x40,              // if
+                                                  0x41, 0, 0x10, 2,        //   i32.const 0; call eosio_exit
+                                                  0x0b,                    // end
+                                                  0x0b}));
+      add_section(w, 10, bytes({2}) + helper + apply);
+      add_section(w, 0, bytes({4}) + "name" + bytes({0}));
+      return out;
+   }
+
+   uint64_t read_leb(reader& r, bool is_signed) {
+      uint64_t value = 0;
+      uint32_t shift = 0;
+      uint8_t  b;
+      do {
+         b = r.read<uint8_t>();
+         value |= uint64_t(b & 0x7f) << shift;
+         shift += 7;
+      } while (b & 0x80);
+      if (is_signed && shift < 64 && (b & 0x40))
+         value |= ~uint64_t(0) << shift;
+      return value;
+   }
+
+   // Just enough of a WASM interpreter to run what `sample_contract` and the pass produce.
+   class interpreter {
+   public:
+      explicit interpreter(const std::vector<char>& wasm)
+         : _wasm(wasm.begin(), wasm.end())
+         , _memory(65536) {
+         reader r(_wasm);
+         r.skip(8);
+         while (!r.empty()) {
+            const uint8_t id   = r.read<uint8_t>();
+            reader        body(r.read_bytes());
+            if (id == 1) {
+               for (uint32_t n = body.read_varuint32(); n; --n) {
+                  body.read<uint8_t>();
+                  const auto params = body.read_bytes();
+                  body.read_bytes();
+                  _type_params.push_back(params.size());
+               }
+            } else if (id == 2) {
+               for (uint32_t n = body.read_varuint32(); n; --n) {
+                  body.read_bytes();
+                  const auto field = body.read_bytes();
+                  BOOST_REQUIRE_EQUAL(body.read<uint8_t>(), 0);
+                  _imports.push_back({std::string(field), body.read_varuint32()});
+               }
+            } else if (id == 3) {
+               for (uint32_t n = body.read_varuint32(); n; --n)
+                  _functions.push_back({body.read_varuint32(), 0, {}});
+            } else if (id == 6) {
+               _globals.resize(body.read_varuint32());
+            } else if (id == 7) {
+               for (uint32_t n = body.read_varuint32(); n; --n) {
+                  const auto export_name = body.read_bytes();
+                  body.read<uint8_t>();
+                  const uint32_t index = body.read_varuint32();
+                  if (export_name == "apply")
+                     _apply = index;
+               }
+            } else if (id == 10) {
+               BOOST_REQUIRE_EQUAL(body.read_varuint32(), _functions.size());
+               for (auto& f : _functions) {
+                  reader fn(body.read_bytes());
+                  for (uint32_t n = fn.read_varuint32(); n; --n)
+                     f.locals += fn.read_varuint32(), fn.read<uint8_t>();
+                  f.code = {fn.pos(), fn.remaining()};
+               }
+            } else {
+               BOOST_REQUIRE(id == 0 || id == 5);
+            }
+         }
+      }
+
+      // Runs `apply` on a fresh instance, as the chain does for each action, and returns what it printed.
+      std::string run(uint64_t receiver, uint64_t code, uint64_t action) {
+         _console.clear();
+         std::fill(_globals.begin(), _globals.end(), 0);
+         try {
+            call(_apply, {receiver, code, action});
+         } catch (const exited&) {
+         }
+         return _console;
+      }
+
+   private:
+      struct import_entry {
+         std::string field;
+         uint32_t    type;
+      };
+      struct function {
+         uint32_t         type;
+         uint32_t         locals;
+         std::string_view code;
+      };
+      struct exited {};
+
+      // The position after the `else` or `end` that closes the block starting at `r`, and of its `else`.
+      static std::pair<const char*, const char*> find_end(reader r) {
+         const char* else_pos = nullptr;
+         for (int depth = 0;;) {
+            const uint8_t op = r.read<uint8_t>();
+            switch (op) {
+               case 0x02:
+               case 0x03:
+               case 0x04: r.read<uint8_t>(), ++depth; break;
+               case 0x05:
+                  if (depth == 0)
+                     else_pos = r.pos();
+                  break;
+               case 0x0b:
+                  if (depth-- == 0)
+                     return {r.pos(), else_pos};
+                  break;
+               case 0x37: r.read_varuint32(), r.read_varuint32(); break;
+               case 0x41:
+               case 0x42: read_leb(r, true); break;
+               case 0x0c:
+               case 0x0d:
+               case 0x10:
+               case 0x20:
+               case 0x21:
+               case 0x22:
+               case 0x23:
+               case 0x24: r.read_varuint32(); break;
+               default: break;
+            }
+         }
+      }
+
+      void call(uint32_t index, std::vector<uint64_t> args) {
+         if (index < _imports.size())
+            return host(_imports[index].field, args);
+
+         const auto& f = _functions.at(index - _imports.size());
+         args.resize(args.size() + f.locals);
+
+         struct label {
+            bool        loop;
+            const char* start; // after the blocktype
+            const char* end;   // after the `end`
+         };
+         std::vector<label> labels;
+         auto               branch = [&](reader& r, uint32_t depth) {
+            const label target = labels[labels.size() - 1 - depth];
+            labels.resize(labels.size() - depth - (target.loop ? 0 : 1));
+            r = reader(target.loop ? target.start : target.end, f.code.data() + f.code.size());
+         };
+         auto pop = [&] {
+            const uint64_t v = _stack.back();
+            _stack.pop_back();
+            return v;
+         };
+
+         for (reader r(f.code); !r.empty();) {
+            const uint8_t op = r.read<uint8_t>();
+            switch (op) {
+               case 0x02:
+               case 0x03: {
+                  r.read<uint8_t>();
+                  labels.push_back({op == 0x03, r.pos(), find_end(r).first});
+                  break;
+               }
+               case 0x04: {
+                  r.read<uint8_t>();
+                  const auto [end, else_pos] = find_end(r);
+                  labels.push_back({false, r.pos(), end});
+                  if (!pop()) {
+                     if (else_pos)
+                        r = reader(else_pos, f.code.data() + f.code.size());
+                     else
+                        branch(r, 0);
+                  }
+                  break;
+               }
+               case 0x05: branch(r, 0); break;
+               case 0x0b:
+                  if (labels.empty())
+                     return;
+                  labels.pop_back();
+                  break;
+               case 0x0c: branch(r, r.read_varuint32()); break;
+               case 0x0d: {
+                  const uint32_t depth = r.read_varuint32();
+                  if (uint32_t(pop()))
+                     branch(r, depth);
+                  break;
+               }
+               case 0x10: {
+                  const uint32_t callee = r.read_varuint32();
+                  const uint32_t type   = callee < _imports.size() ? _imports[callee].type
+                                                                   : _functions.at(callee - _imports.size()).type;
+                  std::vector<uint64_t> callee_args(_type_params.at(type));
+                  for (auto it = callee_args.rbegin(); it != callee_args.rend(); ++it)
+                     *it = pop();
+                  call(callee, std::move(callee_args));
+                  break;
+               }
+               case 0x1a: pop(); break;
+               case 0x20: _stack.push_back(args.at(r.read_varuint32())); break;
+               case 0x21: args.at(r.read_varuint32()) = pop(); break;
+               case 0x22: args.at(r.read_varuint32()) = _stack.back(); break;
+               case 0x23: _stack.push_back(_globals.at(r.read_varuint32())); break;
+               case 0x24: _globals.at(r.read_varuint32()) = pop(); break;
+               case 0x37: {
+                  r.read_varuint32();
+                  const uint32_t offset = r.read_varuint32();
+                  const uint64_t value  = pop();
+                  const uint32_t addr   = uint32_t(pop()) + offset;
+                  std::memcpy(_memory.data() + addr, &value, 8);
+                  break;
+               }
+               case 0x41: _stack.push_back(uint32_t(read_leb(r, true))); break;
+               case 0x42: _stack.push_back(read_leb(r, true)); break;
+               case 0x50: _stack.push_back(pop() == 0); break;
+               case 0x52: _stack.push_back(pop() != pop()); break;
+               case 0x6b: {
+                  const uint32_t b = pop(), a = pop();
+                  _stack.push_back(uint32_t(a - b));
+                  break;
+               }
+               case 0x7c: _stack.push_back(pop() + pop()); break;
+               default: BOOST_FAIL("unexpected opcode " << int(op));
+            }
+         }
+      }
+
+      void host(const std::string& field, const std::vector<uint64_t>& args) {
+         if (field == "prints_l")
+            _console.append(_memory.data() + uint32_t(args[0]), uint32_t(args[1]));
+         else if (field == "printui")
+            _console += std::to_string(args[0]);
+         else if (field == "current_time")
+            _stack.push_back(1);
+         else if (field == "eosio_exit")
+            throw exited{};
+      }
+
+      std::string               _wasm;
+      std::vector<uint32_t>     _type_params;
+      std::vector<import_entry> _imports;
+      std::vector<function>     _functions;
+      std::vector<uint64_t>     _globals;
+      uint32_t                  _apply = 0;
+      std::vector<char>         _memory;
+      std::vector<uint64_t>     _stack;
+      std::string               _console;
+   };
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(wasm_meter_tests)
+
+BOOST_AUTO_TEST_CASE(counts_instructions_and_host_calls) {
+   const auto  contract = sample_contract();
+   meter_stats stats;
+   const auto  metered = meter_wasm({contract.data(), contract.size()}, &stats);
+   BOOST_TEST(stats.functions == 2u);
+   BOOST_TEST(stats.segments == 7u);
+   BOOST_TEST(stats.host_imports == 3u);
+
+   interpreter wasm(metered);
+
+   // returns from apply
+   auto counts = parse_meter_console(wasm.run(1, 2, 3));
+   BOOST_TEST(counts.instructions == 3 + 3 * 7 + 1 + 3 + 3 * 5 + 1u);
+   BOOST_TEST(counts.host_calls == 6u);
+   BOOST_TEST(counts.host.size() == 2u);
+   BOOST_TEST(counts.host["require_auth"] == 3u);
+   BOOST_TEST(counts.host["current_time"] == 3u);
+
+   // exits from the `if`, the counts are printed before the contract's own eosio_exit
+   counts = parse_meter_console(wasm.run(1, 0, 3));
+   BOOST_TEST(counts.instructions == 3 + 3 * 7 + 1 + 3 + 3 * 5 + 3u);
+   BOOST_TEST(counts.host_calls == 7u);
+   BOOST_TEST(counts.host["eosio_exit"] == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(keeps_the_original_behaviour) {
+   const auto contract = sample_contract();
+   const auto metered  = meter_wasm({contract.data(), contract.size()});
+
+   // the original prints nothing; metered, it only adds its own lines
+   interpreter original(contract);
+   BOOST_TEST(original.run(1, 2, 3).empty());
+   interpreter wasm(metered);
+   const auto  console = wasm.run(1, 2, 3);
+   BOOST_TEST(console.starts_with("meter:instructions:"));
+   BOOST_TEST(console.ends_with("\n"));
+
+   // metering is repeatable, and the name section is gone
+   BOOST_TEST(meter_wasm({contract.data(), contract.size()}) == metered);
+   BOOST_TEST(std::string_view(metered.data(), metered.size()).find("name") == std::string_view::npos);
+}
+
+BOOST_AUTO_TEST_CASE(parses_consoles) {
+   meter_counts counts = parse_meter_console("hello\nmeter:instructions:10\nmeter:host:db_find_i64:2\n"
+                                             "meter:host:db_find_i64:3\nmeter:bogus\nmeter:host:printui:1");
+   BOOST_TEST(counts.instructions == 10u);
+   BOOST_TEST(counts.host_calls == 6u);
+   BOOST_TEST(counts.host["db_find_i64"] == 5u);
+
+   counts += parse_meter_console("meter:instructions:5\n");
+   BOOST_TEST(counts.instructions == 15u);
+   BOOST_TEST(counts.host_calls == 6u);
+}
+
+BOOST_AUTO_TEST_CASE(rejects_unsupported_modules) {
+   const auto no_apply = sample_contract(false);
+   BOOST_CHECK_THROW(meter_wasm({no_apply.data(), no_apply.size()}), decode_error);
+   BOOST_CHECK_THROW(meter_wasm(std::string_view("\0asn\1\0\0\0", 8)), decode_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,42 @@
+// xyz-wasm-meter: instruments a contract to report its instruction and host function counts per action.
+//
+//    xyz-wasm-meter <in.wasm> <out.wasm>
+//
+// Deploy the output in place of the contract; each action then prints `meter:` lines to its console.
+
+#include <xyz/wasm_meter.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+using namespace xyz_tools;
+
+int main(int argc, char** argv) {
+   try {
+      if (argc != 3) {
+         std::cerr << "usage: xyz-wasm-meter <in.wasm> <out.wasm>\n";
+         return 2;
+      }
+      std::ifstream in(argv[1], std::ios::binary);
+      if (!in)
+         throw std::runtime_error(std::string("cannot open ") + argv[1]);
+      const std::string wasm{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+      meter_stats stats;
+      const auto  metered = meter_wasm(wasm, &stats);
+
+      std::ofstream out(argv[2], std::ios::binary);
+      if (!out.write(metered.data(), metered.size()))
+         throw std::runtime_error(std::string("cannot write ") + argv[2]);
+
+      std::cout << "functions:    " << stats.functions << "\n"
+                << "segments:     " << stats.segments << "\n"
+                << "host imports: " << stats.host_imports << "\n"
+                << "size:         " << wasm.size() << " -> " << metered.size() << " bytes\n";
+      return 0;
+   } catch (const std::exception& e) {
+      std::cerr << "error: " << e.what() << "\n";
+      return 2;
+   }
+}